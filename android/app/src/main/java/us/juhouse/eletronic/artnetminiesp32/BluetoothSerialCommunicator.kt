@@ -2,6 +2,7 @@ package us.juhouse.eletronic.artnetminiesp32
 
 import android.annotation.SuppressLint
 import android.bluetooth.BluetoothDevice
+import java.io.ByteArrayOutputStream
 import java.io.IOException
 import java.util.UUID
 
@@ -72,25 +73,11 @@ class BluetoothSerialCommunicator(private val device: BluetoothDevice, private v
 
                 dataString = ""
 
-                outputStream.write(request.code)
+                val payload = ByteArrayOutputStream()
+                requestData?.writeToStream(payload)
 
-                when (request) {
-                    BluetoothSerialRequest.BLUETOOTH_REQUEST_TYPE_NONE ->
-                        outputStream.flush()
-
-                    BluetoothSerialRequest.BLUETOOTH_REQUEST_TYPE_GET_INFO ->
-                        outputStream.flush()
-
-                    BluetoothSerialRequest.BLUETOOTH_REQUEST_TYPE_CHANGE_PASSWORD -> {
-                        requestData?.writeToStream(outputStream)
-                        outputStream.flush()
-                    }
-
-                    BluetoothSerialRequest.BLUETOOTH_REQUEST_TYPE_CHANGE_SETTINGS -> {
-                        requestData?.writeToStream(outputStream)
-                        outputStream.flush()
-                    }
-                }
+                outputStream.write(BluetoothSerialFrame.encode(request.code, payload.toByteArray()))
+                outputStream.flush()
 
                 synchronized(syncObject) {
                     request = BluetoothSerialRequest.BLUETOOTH_REQUEST_TYPE_NONE
@@ -5,8 +5,8 @@ import java.io.OutputStream
 data class BluetoothSerialDataPasswordChange(val oldPassword: String, val newPassword: String): BluetoothSerialData {
     private fun serializeStringToStream(data: String, size: Int, output: OutputStream) {
         for (i in 0..size) {
-            if (data.length < i) {
-                val currentChar: Int = data[i] as Int
+            if (i < data.length) {
+                val currentChar: Int = data[i].code
                 output.write(currentChar and 0xFF)
             } else {
                 output.write(0)
@@ -2,7 +2,7 @@ package us.juhouse.eletronic.artnetminiesp32
 
 import java.io.OutputStream
 
-data class BluetoothSerialDataSettings(val password: String, val channelCount: UInt, val net: UInt, val subnet: UInt, val universe: UInt, val wirelessMode: WirelessMode, val wirelessSSID: String, val wirelessPassword: String): BluetoothSerialData {
+data class BluetoothSerialDataSettings(val password: String, val channelCount: UInt, val net: UInt, val subnet: UInt, val universe: UInt, val port2Universe: UInt, val port3Universe: UInt, val portInputs: List<Boolean>, val wirelessMode: WirelessMode, val wirelessSSID: String, val wirelessPassword: String): BluetoothSerialData {
 
     private fun serializeStringToStream(data: String, size: Int, output: OutputStream) {
         for (i in 0..size) {
@@ -26,8 +26,13 @@ data class BluetoothSerialDataSettings(val password: String, val channelCount: U
         outputStream.write(wirelessMode.code)
         serializeStringToStream(wirelessSSID, 200, outputStream)
         serializeStringToStream(wirelessPassword, 200, outputStream)
-        // Bit stuff
-        outputStream.write(0)
+        outputStream.write((universe and 0xFu).toInt())
+        outputStream.write((port2Universe and 0xFu).toInt())
+        outputStream.write((port3Universe and 0xFu).toInt())
+        // Port modes: 0 output, 1 input
+        for (i in 0..2) {
+            outputStream.write(if (portInputs.getOrElse(i) { false }) 1 else 0)
+        }
     }
 
     override fun getType(): BluetoothSerialRequest {
@@ -0,0 +1,30 @@
+package us.juhouse.eletronic.artnetminiesp32
+
+import java.util.zip.CRC32
+
+// Framing of requests to the node: 0xA5 0x5A, type, payload length (little
+// endian), payload, CRC-32 of type, length and payload (little endian).
+object BluetoothSerialFrame {
+    private const val SYNC_0 = 0xA5
+    private const val SYNC_1 = 0x5A
+
+    fun encode(type: Int, payload: ByteArray): ByteArray {
+        val frame = ByteArray(5 + payload.size + 4)
+
+        frame[0] = SYNC_0.toByte()
+        frame[1] = SYNC_1.toByte()
+        frame[2] = type.toByte()
+        frame[3] = (payload.size and 0xFF).toByte()
+        frame[4] = (payload.size shr 8).toByte()
+        payload.copyInto(frame, 5)
+
+        val crc = CRC32()
+        crc.update(frame, 2, 3 + payload.size)
+
+        for (i in 0..3) {
+            frame[5 + payload.size + i] = (crc.value shr (8 * i)).toByte()
+        }
+
+        return frame
+    }
+}
@@ -13,6 +13,7 @@ import androidx.activity.compose.setContent
 import androidx.activity.result.contract.ActivityResultContracts
 import androidx.activity.viewModels
 import androidx.compose.foundation.layout.Column
+import androidx.compose.foundation.layout.Row
 import androidx.compose.foundation.layout.fillMaxSize
 import androidx.compose.foundation.layout.padding
 import androidx.compose.foundation.rememberScrollState
@@ -21,6 +22,7 @@ import androidx.compose.foundation.verticalScroll
 import androidx.compose.material.icons.Icons
 import androidx.compose.material.icons.filled.ArrowDropDown
 import androidx.compose.material3.Button
+import androidx.compose.material3.Checkbox
 import androidx.compose.material3.ExperimentalMaterial3Api
 import androidx.compose.material3.MaterialTheme
 import androidx.compose.material3.Surface
@@ -32,6 +34,7 @@ import androidx.compose.material3.Icon
 import androidx.compose.runtime.Composable
 import androidx.compose.runtime.collectAsState
 import androidx.compose.runtime.getValue
+import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.tooling.preview.Preview
 import androidx.compose.ui.unit.dp
@@ -78,6 +81,11 @@ class MainViewModel(state: SavedStateHandle) : ViewModel() {
     var net by state.saveable { mutableStateOf("") }
     var subnet by state.saveable { mutableStateOf("") }
     var universe by state.saveable { mutableStateOf("") }
+    var port2Universe by state.saveable { mutableStateOf("") }
+    var port3Universe by state.saveable { mutableStateOf("") }
+    var port1Input by state.saveable { mutableStateOf(false) }
+    var port2Input by state.saveable { mutableStateOf(false) }
+    var port3Input by state.saveable { mutableStateOf(false) }
     var wirelessSSID by state.saveable { mutableStateOf("") }
     var wirelessPassword by state.saveable { mutableStateOf("") }
     var wirelessMode by state.saveable { mutableStateOf(WirelessMode.NONE) }
@@ -105,6 +113,9 @@ class MainViewModel(state: SavedStateHandle) : ViewModel() {
             net.toUInt(),
             subnet.toUInt(),
             universe.toUInt(),
+            port2Universe.toUInt(),
+            port3Universe.toUInt(),
+            listOf(port1Input, port2Input, port3Input),
             wirelessMode,
             wirelessSSID,
             wirelessPassword
@@ -291,6 +302,42 @@ fun Greeting(callbacks: MainActivityCallbacks, mainViewModel: MainViewModel, mod
             },
             singleLine = true,
         )
+        TextField(
+            value = mainViewModel.port2Universe,
+            onValueChange = { mainViewModel.port2Universe = it.replace(Regex("\\D"), "") },
+            keyboardOptions = KeyboardOptions(keyboardType = KeyboardType.Decimal),
+            label = {
+                Text(text = "ArtNet Universe Port 2")
+            },
+            placeholder = {
+                Text(text = "Min 0 Max 15")
+            },
+            singleLine = true,
+        )
+        TextField(
+            value = mainViewModel.port3Universe,
+            onValueChange = { mainViewModel.port3Universe = it.replace(Regex("\\D"), "") },
+            keyboardOptions = KeyboardOptions(keyboardType = KeyboardType.Decimal),
+            label = {
+                Text(text = "ArtNet Universe Port 3")
+            },
+            placeholder = {
+                Text(text = "Min 0 Max 15")
+            },
+            singleLine = true,
+        )
+        Row(verticalAlignment = Alignment.CenterVertically) {
+            Checkbox(checked = mainViewModel.port1Input, onCheckedChange = { mainViewModel.port1Input = it })
+            Text(text = "Port 1 DMX Input")
+        }
+        Row(verticalAlignment = Alignment.CenterVertically) {
+            Checkbox(checked = mainViewModel.port2Input, onCheckedChange = { mainViewModel.port2Input = it })
+            Text(text = "Port 2 DMX Input")
+        }
+        Row(verticalAlignment = Alignment.CenterVertically) {
+            Checkbox(checked = mainViewModel.port3Input, onCheckedChange = { mainViewModel.port3Input = it })
+            Text(text = "Port 3 DMX Input")
+        }
         Button(onClick = { wirelessModeDropdownExpanded = !wirelessModeDropdownExpanded }) {
             Text(text = "Wireless Mode: ${mainViewModel.wirelessMode.name}")
             Icon(Icons.Default.ArrowDropDown, contentDescription = "Open")
@@ -0,0 +1,55 @@
+#include <ArrivalJitter.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+ArrivalJitter::ArrivalJitter() {
+    reset();
+}
+
+void ArrivalJitter::reset() {
+    deviations.reset();
+    lastArrival = 0;
+    interval = 0;
+    jitter = 0;
+    started = 0;
+}
+
+void ArrivalJitter::record(uint32_t nowMicros) {
+    uint32_t elapsed = nowMicros - lastArrival;
+
+    lastArrival = nowMicros;
+
+    if (!started || elapsed > ARRIVAL_JITTER_MAX_INTERVAL_US) {
+        started = 1;
+        return;
+    }
+
+    if (interval == 0) {
+        interval = elapsed << 4;
+        return;
+    }
+
+    uint32_t average = interval >> 4;
+    uint32_t deviation = elapsed > average ? elapsed - average : average - elapsed;
+
+    deviations.record(deviation);
+    jitter += deviation - (jitter >> 4);
+    interval += elapsed - average;
+}
+
+uint32_t ArrivalJitter::getJitter() const {
+    return jitter >> 4;
+}
+
+uint32_t ArrivalJitter::getInterval() const {
+    return interval >> 4;
+}
+
+const LatencyHistogram* ArrivalJitter::getDeviations() const {
+    return &deviations;
+}
+
+int ArrivalJitter::format(char *buffer, size_t size, const char *name) const {
+    return snprintf(buffer, size, "%s: interval %" PRIu32 " us, jitter %" PRIu32 " us, p50 %" PRIu32 " us, p99 %" PRIu32 " us, max %" PRIu32 " us, n %" PRIu32 "\r\n",
+        name, getInterval(), getJitter(), deviations.getPercentile(50), deviations.getPercentile(99), deviations.getMax(), deviations.getCount());
+}
@@ -0,0 +1,41 @@
+#ifndef ARRIVAL_JITTER_H
+#define ARRIVAL_JITTER_H
+
+#include <Arduino.h>
+#include <StageProfiler.h>
+
+// Gaps longer than this are a pause of the sender, not jitter.
+#ifndef ARRIVAL_JITTER_MAX_INTERVAL_US
+#define ARRIVAL_JITTER_MAX_INTERVAL_US 1000000
+#endif
+
+// Jitter of a stream sent at a steady rate, from its arrival times only: the
+// sender's period is taken as the running average interval, and each
+// interval's distance from it goes to a histogram and to a running estimate
+// smoothed like the RTP interarrival jitter (RFC 3550, 1/16 gain).
+class ArrivalJitter {
+    public:
+        ArrivalJitter();
+
+        void record(uint32_t nowMicros);
+        void reset();
+
+        // Running estimate, in us.
+        uint32_t getJitter() const;
+        // Average interval, 0 until measured.
+        uint32_t getInterval() const;
+        // Distance of each interval from the average.
+        const LatencyHistogram* getDeviations() const;
+
+        // "name: interval 22727 us, jitter 120 us, p50 ..., n 1234\r\n"
+        int format(char *buffer, size_t size, const char *name) const;
+    private:
+        LatencyHistogram deviations;
+        uint32_t lastArrival;
+        // Both scaled by 16.
+        uint32_t interval;
+        uint32_t jitter;
+        uint8_t started;
+};
+
+#endif
@@ -1,4 +1,9 @@
+#ifndef ART_NET_H
+#define ART_NET_H
+
 #include <Arduino.h>
+#include <ArtNetMerger.h>
+#include <functional>
 
 #define ART_NET_ID "Art-Net"
 
@@ -16,6 +21,64 @@
 
 #define ART_NET_MAX_NET 127
 
+// Sizes of the node names, null included.
+#define ART_NET_SHORT_NAME_SIZE 18
+#define ART_NET_LONG_NAME_SIZE 64
+
+static_assert(ART_NET_OUTPUT_UNIVERSE_COUNT <= 4, "ArtPollReply advertises at most 4 ports");
+
+// Without ArtSync for this long the node goes back to outputting ArtDmx immediately.
+#define ART_NET_SYNC_TIMEOUT_MS 4000
+
+// ArtPollReply is sent after a random delay up to this long; polls from the
+// same controller arriving meanwhile are answered by a single reply.
+#ifndef ART_NET_POLL_REPLY_MAX_DELAY_MS
+#define ART_NET_POLL_REPLY_MAX_DELAY_MS 1000
+#endif
+
+// After a reply, further polls from the same controller within this window
+// are considered answered.
+#ifndef ART_NET_POLL_REPLY_MERGE_WINDOW_MS
+#define ART_NET_POLL_REPLY_MERGE_WINDOW_MS 1000
+#endif
+
+// Distinct controllers waiting for (or recently sent) a reply at the same time.
+#ifndef ART_NET_POLL_REPLY_QUEUE_SIZE
+#define ART_NET_POLL_REPLY_QUEUE_SIZE 8
+#endif
+
+// Bytes of an ArtDmx packet before the slot data (ID .. LengthLo).
+#define ART_NET_DMX_HEADER_SIZE 18
+
+// Statistics go out as ArtDiagData this often, while a controller asks for them.
+#ifndef ART_NET_DIAG_INTERVAL_MS
+#define ART_NET_DIAG_INTERVAL_MS 5000
+#endif
+// The statistics in the ArtPollReply node report are formatted this often,
+// like the refresh rate they show. Replies in between only update the counter.
+#ifndef ART_NET_NODE_REPORT_INTERVAL_MS
+#define ART_NET_NODE_REPORT_INTERVAL_MS 1000
+#endif
+
+// ArtPoll Flags bits.
+#define ART_NET_POLL_FLAG_DIAGNOSTICS 0x04
+#define ART_NET_POLL_FLAG_DIAG_UNICAST 0x08
+
+// ArtPollReply GoodInput bits.
+#define ART_NET_GOOD_INPUT_DATA 0x80
+#define ART_NET_GOOD_INPUT_ERRORS 0x04
+
+// ArtDiagData priority of the statistics (DpLow).
+#define ART_NET_DIAG_PRIORITY_LOW 0x10
+
+// ArtAddress switch fields are only taken with this bit set. The node has no
+// switches to reset to, so 0x00 leaves the value as it is, like 0x7F.
+#define ART_NET_ADDRESS_PROGRAM 0x80
+// ArtAddress Command values, the merge ones plus the port (0-3).
+#define ART_NET_ADDRESS_CANCEL_MERGE 0x01
+#define ART_NET_ADDRESS_MERGE_LTP 0x10
+#define ART_NET_ADDRESS_MERGE_HTP 0x50
+
 namespace art_net {
     enum class PacketParseStatus : int8_t {
         BadSize = -1,
@@ -25,8 +88,32 @@ namespace art_net {
         Success = 0
     };
 
+    // Result of looking only at the first bytes of a datagram.
+    enum class HeaderClass : uint8_t {
+        // Not an ArtDmx, the whole packet must go through onPacketReceived.
+        Other = 0,
+        // ArtDmx addressed to one of our output universes.
+        DmxAccepted = 1,
+        // ArtDmx for a universe we don't output, safe to drop unread.
+        DmxRejected = 2
+    };
+
+    // Direction of a DMX port.
+    enum class PortMode : uint8_t {
+        // ArtDmx for the port universe goes out on the DMX line.
+        Output = 0,
+        // DMX received on the line goes out as ArtDmx for the port universe.
+        Input = 1
+    };
+
     static constexpr size_t NUM_POLLREPLY_PUBLIC_PORT_LIMIT {4};
 
+    // "Art-Net\0" read as a little endian 64 bit word.
+    static constexpr uint64_t ART_NET_ID_WORD {
+        ((uint64_t)'A') | ((uint64_t)'r' << 8) | ((uint64_t)'t' << 16) | ((uint64_t)'-' << 24) |
+        ((uint64_t)'N' << 32) | ((uint64_t)'e' << 40) | ((uint64_t)'t' << 48)
+    };
+
     enum class OpCode : uint16_t {
         // Device Discovery
         Poll = 0x2000,
@@ -112,6 +199,45 @@ namespace art_net {
         uint8_t b[239];
     } ArtNetPollReplyPacket;
 
+    typedef struct ArtNetPollPacket {
+        char ID[8];
+        uint8_t OpCodeLo;
+        uint8_t OpCodeHi;
+        uint8_t ProtVerHi, ProtVerLo;
+        uint8_t Flags;
+        uint8_t DiagPriority;
+    } ArtNetPollPacket;
+
+    typedef struct ArtNetAddressPacket {
+        char ID[8];
+        uint8_t OpCodeLo;
+        uint8_t OpCodeHi;
+        uint8_t ProtVerHi, ProtVerLo;
+        uint8_t NetSwitch;
+        uint8_t BindIndex;
+        char ShortName[ART_NET_SHORT_NAME_SIZE];
+        char LongName[ART_NET_LONG_NAME_SIZE];
+        uint8_t SwIn[NUM_POLLREPLY_PUBLIC_PORT_LIMIT];
+        uint8_t SwOut[NUM_POLLREPLY_PUBLIC_PORT_LIMIT];
+        uint8_t SubSwitch;
+        uint8_t AcnPriority;
+        uint8_t Command;
+    } ArtNetAddressPacket;
+
+    typedef struct ArtNetDiagDataPacket {
+        char ID[8];
+        uint8_t OpCodeLo;
+        uint8_t OpCodeHi;
+        uint8_t ProtVerHi, ProtVerLo;
+        uint8_t Filler1;
+        uint8_t Priority;
+        uint8_t Filler2;
+        uint8_t Filler3;
+        uint8_t LengthHi;
+        uint8_t LengthLo;
+        char Data[512];
+    } ArtNetDiagDataPacket;
+
     typedef struct ArtNetDmxDataPacket {
         char ID[8];
         uint8_t OpCodeLo;
@@ -126,17 +252,222 @@ namespace art_net {
         uint8_t Data[512];
     } ArtNetDmxDataPacket;
 
-    class ArtNet {
+    // ArtDmx with the start code in place of Physical.
+    typedef struct ArtNetNzsDataPacket {
+        char ID[8];
+        uint8_t OpCodeLo;
+        uint8_t OpCodeHi;
+        uint8_t ProtVerHi, ProtVerLo;
+        uint8_t Sequence;
+        uint8_t StartCode;
+        uint8_t SubUni;
+        uint8_t Net;
+        uint8_t LengthHi;
+        uint8_t LengthLo;
+        uint8_t Data[512];
+    } ArtNetNzsDataPacket;
+
+    typedef struct {
+        uint32_t ip;
+        uint16_t port;
+        // Reply time, or end of the merge window once sent.
+        unsigned long dueMillis;
+        uint8_t sent;
+    } PendingPollReply;
+
+    // Received packet counters, only touched by the network side.
+    typedef struct {
+        uint32_t dmx;
+        uint32_t nzs;
+        uint32_t poll;
+        uint32_t sync;
+        uint32_t address;
+        uint32_t otherOpCode;
+        uint32_t badSize;
+        uint32_t badId;
+        // ArtDmx sent for input ports.
+        uint32_t dmxSent;
+        // ArtDmx/ArtNzs for universes we don't output.
+        uint32_t dmxForeign;
+        // ArtDmx/ArtNzs with a length above 512, ArtNzs with start code 0.
+        uint32_t dmxBadLength;
+        // ArtDmx/ArtNzs datagram shorter than its length field.
+        uint32_t dmxTruncated;
+    } ArtNetStats;
+
+    // Written by the output task of each port.
+    typedef struct {
+        uint32_t framesSwapped;
+        uint32_t keepAlives;
+        uint32_t nzsFrames;
+        // Frames between two fresh ones, from the interpolator.
+        uint32_t interpolated;
+        // Frames sent during the last second.
+        uint16_t refreshRate;
+    } OutputStats;
+
+    // Where ArtNet delivers DMX and sends its packets through. BasicArtNet
+    // calls these members directly, so a sink known at compile time is
+    // inlined into the packet path. This one forwards to std::function, for
+    // callbacks set at runtime.
+    class ArtNetFunctionSink {
         public:
-            uint8_t net, subnet, mac[6], receiveSequence[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            std::function<void(uint32_t, uint16_t, const uint8_t*, uint32_t)> sendPacketFunc;
+            std::function<void(uint8_t, uint8_t, const uint8_t*, uint16_t)> dmxDataCallback;
+            std::function<void()> dmxCommitCallback;
+
+            void sendPacket(uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+                sendPacketFunc(ip, port, data, size);
+            }
+
+            void onDmxData(uint8_t universe, uint8_t startCode, const uint8_t *data, uint16_t size) {
+                dmxDataCallback(universe, startCode, data, size);
+            }
+
+            void onDmxCommit() {
+                dmxCommitCallback();
+            }
+    };
+
+    // Member definitions are in ArtNetImpl.h, include it to bind another sink.
+    template <typename Sink>
+    class BasicArtNet {
+        public:
+            // What the Receiver reads before deciding where the slots go.
+            typedef ArtNetDmxDataPacket DmxPacket;
+            static constexpr uint16_t DMX_HEADER_SIZE {ART_NET_DMX_HEADER_SIZE};
+
+            uint8_t net, subnet, mac[6];
+            // Universe (low nibble of SubUni) of each output port.
+            uint8_t portUniverse[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            // Shown in ArtPollReply, null terminated.
+            char shortName[ART_NET_SHORT_NAME_SIZE];
+            char longName[ART_NET_LONG_NAME_SIZE];
+            // Changes made by ArtAddress to the addressing, names or merge
+            // modes; they are to be saved when this moves. New addressing
+            // takes effect between frames: at once, or after the ArtSync of
+            // the current group in synchronous mode.
+            uint32_t addressChanges;
+            // ArtDmx for the universe of an input port is not delivered.
+            PortMode portMode[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            // GoodInput of each input port, kept up to date by the input side.
+            uint8_t goodInput[ART_NET_OUTPUT_UNIVERSE_COUNT];
             uint32_t ip;
-            void setSendPacketCallback(std::function<void(uint32_t, uint16_t, const uint8_t*, uint32_t)> func);
-            void setDmxDataCallback(std::function<void(uint8_t, uint8_t, const uint8_t*, uint16_t)> func);
+            // Per port source tracking, sequence checks and merge mode.
+            Merger mergers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            // Upper bound of the random ArtPoll reply delay, 0 replies on the next processPendingReplies.
+            uint16_t pollReplyMaxDelayMs;
+            // How long after a reply further polls from the same controller are considered answered.
+            uint16_t pollReplyMergeWindowMs;
+            ArtNetStats stats;
+            OutputStats outputStats[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            // sendPacket(ip, port, data, size);
+            // onDmxData(universe, startCode, data, size) with the start code: 0
+            // for ArtDmx, that of the packet for ArtNzs. ArtNzs frames bypass
+            // merge and ArtSync, and are not followed by onDmxCommit;
+            // onDmxCommit() when the frames delivered to onDmxData must be
+            // output: right after each frame, or on ArtSync while in
+            // synchronous mode.
+            Sink sink;
+            BasicArtNet();
+            // ArtNetFunctionSink only.
+            void setSendPacketCallback(std::function<void(uint32_t, uint16_t, const uint8_t*, uint32_t)> func) {
+                sink.sendPacketFunc = func;
+            }
+
+            void setDmxDataCallback(std::function<void(uint8_t, uint8_t, const uint8_t*, uint16_t)> func) {
+                sink.dmxDataCallback = func;
+            }
+
+            void setDmxCommitCallback(std::function<void()> func) {
+                sink.dmxCommitCallback = func;
+            }
+
             PacketParseStatus onPacketReceived(uint32_t remoteIP, uint16_t remotePort, const uint8_t *data, uint32_t size);
+            // Classifies a datagram from its first ART_NET_DMX_HEADER_SIZE bytes so
+            // ArtDmx for foreign universes can be discarded without reading the payload.
+            HeaderClass classifyHeader(const uint8_t *data, uint32_t size) const;
+            // Validates addressing, source, sequence and length of an ArtDmx header,
+            // followed by `payloadSize` bytes of slots. Returns false when the
+            // frame must be dropped; a truncated frame doesn't register its source.
+            bool acceptDmxHeader(uint32_t remoteIP, const ArtNetDmxDataPacket *header, uint32_t payloadSize, uint8_t *universe, uint16_t *dataLength);
+            // When false the caller may read the slot data of an accepted header
+            // straight into its output buffer and then call onDmxFrameReceived,
+            // otherwise the data must go through onDmxData.
+            bool needsMerge(uint8_t universe) const;
+            // Merges if needed and delivers the data of an accepted header.
+            void onDmxData(uint8_t universe, const uint8_t *data, uint16_t dataLength);
+            // Must follow the delivery of an accepted frame that bypassed the data
+            // callback. ArtNet commits all ports, ArtSync groups them.
+            void onDmxFrameReceived(uint8_t universe);
+            bool isSynchronous() const;
+            // Sends the slots received on an input port as ArtDmx. Odd lengths
+            // are padded with a zero slot, as ArtDmx requires an even length.
+            void sendDmx(uint8_t port, uint32_t dstIP, const uint8_t *data, uint16_t length);
+            // Sends the poll replies that are due. Call it outside of the packet
+            // path, where a blocking UDP send can't delay DMX data.
+            void processPendingReplies();
+            // Sends ArtDiagData with the statistics when a controller asked for it
+            // and ART_NET_DIAG_INTERVAL_MS passed, and refreshes the node report
+            // every ART_NET_NODE_REPORT_INTERVAL_MS. Call it next to processPendingReplies.
+            void processDiagnostics();
+            // Sums of the merger rejections over all ports.
+            uint32_t getSequenceRejected() const;
+            uint32_t getSourceRejected() const;
+            // Writes all counters as "Label: value" lines, then a line per port.
+            void formatStats(char *buffer, size_t size) const;
+            // The two parts of formatStats, each fits in an ArtDiagData. Return
+            // the length they would have, like snprintf.
+            int formatCounters(char *buffer, size_t size) const;
+            int formatOutputStats(char *buffer, size_t size) const;
         private:
-            std::function<void(uint32_t, uint16_t, const uint8_t*, uint32_t)> sendPacketFunc;
-            std::function<void(uint8_t, uint8_t, const uint8_t*, uint16_t)> dmxDataCallback;
+            uint8_t synchronous;
+            unsigned long lastSyncMillis;
+            // ArtAddress addressing, waiting for the end of the ArtSync group.
+            uint8_t addressPending;
+            uint8_t pendingNet;
+            uint8_t pendingSubnet;
+            uint8_t pendingUniverse[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            uint32_t addressIP;
+            uint16_t addressPort;
+            // Prebuilt reply, rebuilt only when the addressing or port status
+            // changes; only the node report counter is patched per send.
+            ArtNetPollReplyPacket pollReply;
+            uint16_t pollReplyCount;
+            unsigned long lastNodeReportMillis;
+            PendingPollReply pendingReplies[ART_NET_POLL_REPLY_QUEUE_SIZE];
+            uint8_t pendingReplyCount;
+            // Where ArtDiagData goes, from the Flags of the last ArtPoll.
+            uint8_t diagEnabled;
+            uint8_t diagPriority;
+            uint32_t diagIP;
+            unsigned long lastDiagMillis;
+            ArtNetDiagDataPacket diagPacket;
+
+            // Sends diagPacket with its Data text.
+            void sendDiagData();
+            ArtNetDmxDataPacket inputPacket;
+            uint8_t inputSequence[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            void onPollPacket(uint32_t remoteIP, uint16_t remotePort, const uint8_t *data, uint32_t size);
+            void onAddressPacket(uint32_t remoteIP, uint16_t remotePort, const uint8_t *data, uint32_t size);
+            bool applyAddressCommand(uint8_t command);
+            void applyPendingAddress();
+            void writeNodeReport();
+            void schedulePollReply(uint32_t dstIP, uint16_t dstPort, uint16_t maxDelayMs);
             void sendPollReply(uint32_t dstIP, uint16_t dstPort);
-            void onDmxPacket(ArtNetDmxDataPacket *packet);
+            void buildPollReply();
+            bool isPollReplyStale() const;
+            uint8_t getGoodOutput(uint8_t port) const;
+            uint8_t getPortType(uint8_t port) const;
+            void onDmxPacket(uint32_t remoteIP, ArtNetDmxDataPacket *packet, uint32_t size);
+            void onNzsPacket(const ArtNetNzsDataPacket *packet, uint32_t size);
+            void onSyncPacket();
+            int8_t getOutputUniverse(uint8_t packetNet, uint8_t packetSubUni) const;
     };
+
+    // Instantiated once in ArtNet.cpp.
+    extern template class BasicArtNet<ArtNetFunctionSink>;
+    typedef BasicArtNet<ArtNetFunctionSink> ArtNet;
 }
+
+#endif
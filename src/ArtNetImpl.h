@@ -0,0 +1,776 @@
+#ifndef ART_NET_IMPL_H
+#define ART_NET_IMPL_H
+
+#include <ArtNet.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+
+namespace art_net {
+    static inline OpCode art_net_get_packet_op_code(ArtNetBasePacket *data) {
+        uint16_t opCode = (((uint16_t)data->OpCodeHi) << 8) | data->OpCodeLo;
+        return (OpCode) opCode;
+    }
+
+    static inline bool art_net_has_valid_id(const uint8_t *data) {
+        uint64_t id;
+        memcpy(&id, data, sizeof(id));
+        return id == ART_NET_ID_WORD;
+    }
+
+    // Sets `name` from a field of `size` bytes that may lack its null; an
+    // empty field leaves it. Returns true if it changed.
+    static inline bool art_net_set_name(char *name, const char *from, size_t size) {
+        size_t length = strnlen(from, size - 1);
+
+        if (length == 0 || (strlen(name) == length && memcmp(name, from, length) == 0)) {
+            return false;
+        }
+
+        memcpy(name, from, length);
+        memset(name + length, 0, size - length);
+        return true;
+    }
+
+    template <typename Sink>
+    BasicArtNet<Sink>::BasicArtNet() {
+        net = 0;
+        subnet = 0;
+        ip = 0;
+        memset(mac, 0, sizeof(mac));
+        synchronous = false;
+        lastSyncMillis = 0;
+        addressChanges = 0;
+        addressPending = 0;
+        addressIP = 0;
+        addressPort = 0;
+        strncpy(shortName, ART_NET_SHORT_NAME, sizeof(shortName) - 1);
+        shortName[sizeof(shortName) - 1] = 0;
+        strncpy(longName, ART_NET_LONG_NAME, sizeof(longName) - 1);
+        longName[sizeof(longName) - 1] = 0;
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            portUniverse[i] = i;
+            portMode[i] = PortMode::Output;
+            goodInput[i] = 0;
+            inputSequence[i] = 0;
+        }
+
+        pollReplyCount = 0;
+        lastNodeReportMillis = 0;
+        pollReplyMaxDelayMs = ART_NET_POLL_REPLY_MAX_DELAY_MS;
+        pollReplyMergeWindowMs = ART_NET_POLL_REPLY_MERGE_WINDOW_MS;
+        pendingReplyCount = 0;
+
+        memset(&stats, 0, sizeof(stats));
+        memset(outputStats, 0, sizeof(outputStats));
+
+        diagEnabled = 0;
+        diagPriority = 0;
+        diagIP = 0;
+        lastDiagMillis = 0;
+
+        buildPollReply();
+    }
+
+    template <typename Sink>
+    uint8_t BasicArtNet<Sink>::getGoodOutput(uint8_t port) const {
+        if (portMode[port] == PortMode::Input) {
+            return 0;
+        }
+
+        uint8_t goodOutput = 0b10000000;
+
+        if (mergers[port].isMerging()) {
+            goodOutput |= 0b00001000;
+        }
+
+        if (mergers[port].mode == MergeMode::Ltp) {
+            goodOutput |= 0b00000010;
+        }
+
+        return goodOutput;
+    }
+
+    template <typename Sink>
+    uint8_t BasicArtNet<Sink>::getPortType(uint8_t port) const {
+        return portMode[port] == PortMode::Input ? 0b01000000 : 0b10100000;
+    }
+
+    template <typename Sink>
+    bool BasicArtNet<Sink>::isPollReplyStale() const {
+        if (memcmp(pollReply.ip, &ip, sizeof(pollReply.ip)) != 0 ||
+            pollReply.net_sw != net ||
+            pollReply.sub_sw != subnet ||
+            memcmp(pollReply.mac, mac, sizeof(mac)) != 0 ||
+            memcmp(pollReply.short_name, shortName, sizeof(shortName)) != 0 ||
+            memcmp(pollReply.long_name, longName, sizeof(longName)) != 0) {
+            return true;
+        }
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            if (pollReply.sw_out[i] != portUniverse[i] || pollReply.good_output[i] != getGoodOutput(i)) {
+                return true;
+            }
+
+            if (pollReply.port_types[i] != getPortType(i) || pollReply.good_input[i] != goodInput[i]) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::buildPollReply() {
+        memset(&pollReply, 0, sizeof(pollReply));
+
+        memcpy(pollReply.ID, ART_NET_ID, sizeof(ART_NET_ID));
+        pollReply.OpCodeHi = ((uint16_t)OpCode::PollReply >> 8);
+        pollReply.OpCodeLo = ((uint16_t)OpCode::PollReply & 0xFF);
+
+        memcpy(pollReply.ip, &ip, sizeof(pollReply.ip));
+
+        pollReply.port_l = 0x36;
+        pollReply.port_h = 0x19;
+
+        pollReply.ver_h = 0x0;
+        pollReply.ver_l = 14U;
+
+        pollReply.net_sw = net;
+        pollReply.sub_sw = subnet;
+
+        pollReply.oem_h = 0;
+        pollReply.oem_l = 0xFF;
+
+        memcpy(pollReply.short_name, shortName, sizeof(shortName));
+        memcpy(pollReply.long_name, longName, sizeof(longName));
+
+        pollReply.num_ports_h = 0;
+        pollReply.num_ports_l = ART_NET_OUTPUT_UNIVERSE_COUNT;
+
+        for (uint8_t i = 0; i < NUM_POLLREPLY_PUBLIC_PORT_LIMIT; i++) {
+            if (i < ART_NET_OUTPUT_UNIVERSE_COUNT) {
+                pollReply.sw_out[i] = portUniverse[i];
+                pollReply.sw_in[i] = portUniverse[i];
+                pollReply.port_types[i] = getPortType(i);
+                pollReply.good_output[i] = getGoodOutput(i);
+                pollReply.good_input[i] = goodInput[i];
+            }
+        }
+
+        memcpy(pollReply.mac, mac, sizeof(mac));
+
+        pollReply.status_2 = 0b00001110;
+
+        writeNodeReport();
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::sendPollReply(uint32_t dstIP, uint16_t dstPort) {
+        if (isPollReplyStale()) {
+            buildPollReply();
+        }
+
+        // Only the nnnn of "#0001 [nnnn] OK", the rest is written by writeNodeReport.
+        uint16_t count = pollReplyCount;
+        pollReplyCount = (pollReplyCount + 1) % 10000;
+
+        for (uint8_t i = 10; i >= 7; i--) {
+            pollReply.node_report[i] = '0' + (count % 10);
+            count /= 10;
+        }
+
+        sink.sendPacket(dstIP, dstPort, (uint8_t*) &pollReply, sizeof(pollReply));
+    }
+
+    // "#0001 [nnnn] OK 44/44/0 Hz dmx n seq n drop n": nnnn counts the replies
+    // sent, then the refresh rate of each port and the ArtDmx counters.
+    template <typename Sink>
+    void BasicArtNet<Sink>::writeNodeReport() {
+        char *report = (char*) pollReply.node_report;
+        size_t size = sizeof(pollReply.node_report);
+        int length = snprintf(report, size, "#0001 [%04u] OK", pollReplyCount);
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            length += snprintf(report + length, size - length, i ? "/%u" : " %u", outputStats[i].refreshRate);
+        }
+
+        uint32_t dropped = stats.dmxBadLength + stats.dmxTruncated + getSourceRejected();
+
+        snprintf(report + length, size - length, " Hz dmx %" PRIu32 " seq %" PRIu32 " drop %" PRIu32,
+            stats.dmx, getSequenceRejected(), dropped);
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::schedulePollReply(uint32_t dstIP, uint16_t dstPort, uint16_t maxDelayMs) {
+        unsigned long now = millis();
+        unsigned long dueMillis = now + (maxDelayMs ? random((long)maxDelayMs + 1) : 0);
+
+        for (uint8_t i = 0; i < pendingReplyCount; i++) {
+            PendingPollReply *pending = &pendingReplies[i];
+
+            if (pending->ip == dstIP && pending->port == dstPort) {
+                if (pending->sent && (long)(now - pending->dueMillis) >= 0) {
+                    // Merge window is over, this is a new poll.
+                    pending->dueMillis = dueMillis;
+                    pending->sent = 0;
+                    return;
+                }
+
+                // Already waiting or just answered, one reply covers both.
+                // A waiting reply is never pushed later.
+                if (!pending->sent && (long)(dueMillis - pending->dueMillis) < 0) {
+                    pending->dueMillis = dueMillis;
+                }
+
+                return;
+            }
+        }
+
+        if (pendingReplyCount == ART_NET_POLL_REPLY_QUEUE_SIZE) {
+            return;
+        }
+
+        PendingPollReply *pending = &pendingReplies[pendingReplyCount++];
+        pending->ip = dstIP;
+        pending->port = dstPort;
+        pending->dueMillis = dueMillis;
+        pending->sent = 0;
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::processPendingReplies() {
+        // The ArtSync it was waiting for is not coming.
+        if (addressPending && (!synchronous || millis() - lastSyncMillis > ART_NET_SYNC_TIMEOUT_MS)) {
+            applyPendingAddress();
+        }
+
+        if (pendingReplyCount == 0) {
+            return;
+        }
+
+        unsigned long now = millis();
+
+        for (uint8_t i = 0; i < pendingReplyCount;) {
+            PendingPollReply *pending = &pendingReplies[i];
+
+            if ((long)(now - pending->dueMillis) < 0) {
+                i++;
+            } else if (!pending->sent) {
+                sendPollReply(pending->ip, pending->port);
+                pending->sent = 1;
+                pending->dueMillis = now + pollReplyMergeWindowMs;
+                i++;
+            } else {
+                pendingReplies[i] = pendingReplies[--pendingReplyCount];
+            }
+        }
+    }
+
+    template <typename Sink>
+    uint32_t BasicArtNet<Sink>::getSequenceRejected() const {
+        uint32_t count = 0;
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            count += mergers[i].sequenceRejected;
+        }
+
+        return count;
+    }
+
+    template <typename Sink>
+    uint32_t BasicArtNet<Sink>::getSourceRejected() const {
+        uint32_t count = 0;
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            count += mergers[i].sourceRejected;
+        }
+
+        return count;
+    }
+
+    template <typename Sink>
+    int BasicArtNet<Sink>::formatCounters(char *buffer, size_t size) const {
+        return snprintf(buffer, size,
+            "ArtDmx: %" PRIu32 "\r\n"
+            "ArtNzs: %" PRIu32 "\r\n"
+            "ArtPoll: %" PRIu32 "\r\n"
+            "ArtSync: %" PRIu32 "\r\n"
+            "ArtAddress/ArtInput: %" PRIu32 "\r\n"
+            "Other OpCodes: %" PRIu32 "\r\n"
+            "Bad Size: %" PRIu32 "\r\n"
+            "Bad ID: %" PRIu32 "\r\n"
+            "ArtDmx Foreign Universe: %" PRIu32 "\r\n"
+            "ArtDmx Sequence Rejected: %" PRIu32 "\r\n"
+            "ArtDmx Source Rejected: %" PRIu32 "\r\n"
+            "ArtDmx Bad Length: %" PRIu32 "\r\n"
+            "ArtDmx Truncated: %" PRIu32 "\r\n"
+            "ArtDmx Sent: %" PRIu32 "\r\n",
+            stats.dmx, stats.nzs, stats.poll, stats.sync, stats.address, stats.otherOpCode,
+            stats.badSize, stats.badId, stats.dmxForeign, getSequenceRejected(),
+            getSourceRejected(), stats.dmxBadLength, stats.dmxTruncated, stats.dmxSent);
+    }
+
+    template <typename Sink>
+    int BasicArtNet<Sink>::formatOutputStats(char *buffer, size_t size) const {
+        int length = 0;
+
+        if (size) {
+            buffer[0] = 0;
+        }
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT && length >= 0 && (size_t)length < size; i++) {
+            const OutputStats *output = &outputStats[i];
+
+            length += snprintf(buffer + length, size - length,
+                "Port %u: %u Hz, %" PRIu32 " frames, %" PRIu32 " keep alive, %" PRIu32 " NZS, %" PRIu32 " interpolated\r\n",
+                i + 1, output->refreshRate, output->framesSwapped, output->keepAlives, output->nzsFrames, output->interpolated);
+        }
+
+        return length;
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::formatStats(char *buffer, size_t size) const {
+        int length = formatCounters(buffer, size);
+
+        if (length >= 0 && (size_t)length < size) {
+            formatOutputStats(buffer + length, size - length);
+        }
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::processDiagnostics() {
+        unsigned long now = millis();
+
+        if (now - lastNodeReportMillis >= ART_NET_NODE_REPORT_INTERVAL_MS) {
+            lastNodeReportMillis = now;
+            writeNodeReport();
+        }
+
+        if (!diagEnabled || diagPriority > ART_NET_DIAG_PRIORITY_LOW) {
+            return;
+        }
+
+        if (now - lastDiagMillis < ART_NET_DIAG_INTERVAL_MS) {
+            return;
+        }
+
+        lastDiagMillis = now;
+
+        memset(&diagPacket, 0, offsetof(ArtNetDiagDataPacket, Data));
+        memcpy(diagPacket.ID, ART_NET_ID, sizeof(ART_NET_ID));
+        diagPacket.OpCodeLo = ((uint16_t)OpCode::DiagData & 0xFF);
+        diagPacket.OpCodeHi = ((uint16_t)OpCode::DiagData >> 8);
+        diagPacket.ProtVerLo = 14;
+        diagPacket.Priority = ART_NET_DIAG_PRIORITY_LOW;
+
+        // Together they don't fit in the 512 bytes of Data.
+        formatCounters(diagPacket.Data, sizeof(diagPacket.Data));
+        sendDiagData();
+        formatOutputStats(diagPacket.Data, sizeof(diagPacket.Data));
+        sendDiagData();
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::sendDiagData() {
+        // Text length including the terminating null.
+        uint16_t length = strlen(diagPacket.Data) + 1;
+        diagPacket.LengthHi = length >> 8;
+        diagPacket.LengthLo = length & 0xFF;
+
+        sink.sendPacket(diagIP, 0x1936, (uint8_t*) &diagPacket, offsetof(ArtNetDiagDataPacket, Data) + length);
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::sendDmx(uint8_t port, uint32_t dstIP, const uint8_t *data, uint16_t length) {
+        if (length > 512) {
+            length = 512;
+        }
+
+        memcpy(inputPacket.ID, ART_NET_ID, sizeof(ART_NET_ID));
+        inputPacket.OpCodeLo = ((uint16_t)OpCode::Dmx & 0xFF);
+        inputPacket.OpCodeHi = ((uint16_t)OpCode::Dmx >> 8);
+        inputPacket.ProtVerHi = 0;
+        inputPacket.ProtVerLo = 14;
+
+        // 1-255, 0 would turn the receiver's sequence check off.
+        inputSequence[port] = inputSequence[port] == 255 ? 1 : inputSequence[port] + 1;
+        inputPacket.Sequence = inputSequence[port];
+        inputPacket.Physical = port;
+        inputPacket.SubUni = (subnet << 4) | portUniverse[port];
+        inputPacket.Net = net;
+
+        memcpy(inputPacket.Data, data, length);
+
+        if (length & 1) {
+            inputPacket.Data[length++] = 0;
+        }
+
+        // At least 2 slots.
+        if (length == 0) {
+            inputPacket.Data[0] = 0;
+            inputPacket.Data[1] = 0;
+            length = 2;
+        }
+
+        inputPacket.LengthHi = length >> 8;
+        inputPacket.LengthLo = length & 0xFF;
+
+        stats.dmxSent++;
+        sink.sendPacket(dstIP, 0x1936, (uint8_t*) &inputPacket, ART_NET_DMX_HEADER_SIZE + length);
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::onPollPacket(uint32_t remoteIP, uint16_t remotePort, const uint8_t *data, uint32_t size) {
+        if (size >= sizeof(ArtNetPollPacket)) {
+            const ArtNetPollPacket *packet = (const ArtNetPollPacket*) data;
+
+            if (packet->Flags & ART_NET_POLL_FLAG_DIAGNOSTICS) {
+                if (!diagEnabled) {
+                    // First diagnostics go out right away.
+                    lastDiagMillis = millis() - ART_NET_DIAG_INTERVAL_MS;
+                }
+
+                diagEnabled = 1;
+                diagPriority = packet->DiagPriority;
+                diagIP = (packet->Flags & ART_NET_POLL_FLAG_DIAG_UNICAST) ? remoteIP : 0xFFFFFFFF;
+            } else {
+                diagEnabled = 0;
+            }
+        }
+
+        schedulePollReply(remoteIP, remotePort, pollReplyMaxDelayMs);
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::onAddressPacket(uint32_t remoteIP, uint16_t remotePort, const uint8_t *data, uint32_t size) {
+        if (size < sizeof(ArtNetAddressPacket)) {
+            schedulePollReply(remoteIP, remotePort, 0);
+            return;
+        }
+
+        const ArtNetAddressPacket *packet = (const ArtNetAddressPacket*) data;
+
+        if (!addressPending) {
+            pendingNet = net;
+            pendingSubnet = subnet;
+            memcpy(pendingUniverse, portUniverse, sizeof(pendingUniverse));
+        }
+
+        if (packet->NetSwitch & ART_NET_ADDRESS_PROGRAM) {
+            pendingNet = packet->NetSwitch & ART_NET_MAX_NET;
+        }
+
+        if (packet->SubSwitch & ART_NET_ADDRESS_PROGRAM) {
+            pendingSubnet = packet->SubSwitch & 0x0F;
+        }
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            uint8_t sw = portMode[i] == PortMode::Input ? packet->SwIn[i] : packet->SwOut[i];
+
+            if (sw & ART_NET_ADDRESS_PROGRAM) {
+                pendingUniverse[i] = sw & 0x0F;
+            }
+        }
+
+        // Names and merge modes don't change what a frame is, they apply now.
+        bool changed = applyAddressCommand(packet->Command);
+
+        changed = art_net_set_name(shortName, packet->ShortName, sizeof(shortName)) || changed;
+        changed = art_net_set_name(longName, packet->LongName, sizeof(longName)) || changed;
+
+        if (changed) {
+            addressChanges++;
+        }
+
+        addressPending = 1;
+        addressIP = remoteIP;
+        addressPort = remotePort;
+
+        // In synchronous mode the frames of the current group were accepted
+        // on the old addressing, they go out together on the next ArtSync.
+        if (!synchronous) {
+            applyPendingAddress();
+        }
+    }
+
+    template <typename Sink>
+    bool BasicArtNet<Sink>::applyAddressCommand(uint8_t command) {
+        if (command == ART_NET_ADDRESS_CANCEL_MERGE) {
+            for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+                mergers[i].clearSources();
+            }
+
+            return false;
+        }
+
+        uint8_t port = command & 0x0F;
+        MergeMode mode;
+
+        if ((command & 0xF0) == ART_NET_ADDRESS_MERGE_LTP) {
+            mode = MergeMode::Ltp;
+        } else if ((command & 0xF0) == ART_NET_ADDRESS_MERGE_HTP) {
+            mode = MergeMode::Htp;
+        } else {
+            return false;
+        }
+
+        if (port >= ART_NET_OUTPUT_UNIVERSE_COUNT || mergers[port].mode == mode) {
+            return false;
+        }
+
+        mergers[port].mode = mode;
+        return true;
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::applyPendingAddress() {
+        bool moved = pendingNet != net || pendingSubnet != subnet;
+        bool changed = moved;
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            if (moved || pendingUniverse[i] != portUniverse[i]) {
+                // Sequence numbers of the old universe would hold back the
+                // first frames of the new one.
+                mergers[i].clearSources();
+                changed = changed || pendingUniverse[i] != portUniverse[i];
+            }
+        }
+
+        net = pendingNet;
+        subnet = pendingSubnet;
+        memcpy(portUniverse, pendingUniverse, sizeof(portUniverse));
+        addressPending = 0;
+
+        if (changed) {
+            addressChanges++;
+        }
+
+        schedulePollReply(addressIP, addressPort, 0);
+    }
+
+    template <typename Sink>
+    int8_t BasicArtNet<Sink>::getOutputUniverse(uint8_t packetNet, uint8_t packetSubUni) const {
+        if (packetNet != net) {
+            return -1;
+        }
+
+        if (subnet != packetSubUni >> 4) {
+            return -1;
+        }
+
+        uint8_t universe = packetSubUni & 0x0F;
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            if (portUniverse[i] == universe && portMode[i] == PortMode::Output) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    template <typename Sink>
+    bool BasicArtNet<Sink>::acceptDmxHeader(uint32_t remoteIP, const ArtNetDmxDataPacket *header, uint32_t payloadSize, uint8_t *universe, uint16_t *dataLength) {
+        stats.dmx++;
+
+        int8_t outputUniverse = getOutputUniverse(header->Net, header->SubUni);
+
+        if (outputUniverse < 0) {
+            stats.dmxForeign++;
+            return false;
+        }
+
+        uint16_t length = (uint16_t)header->LengthHi << 8;
+        length |= header->LengthLo;
+
+        if (length > 512) {
+            stats.dmxBadLength++;
+            return false;
+        }
+
+        if (length > payloadSize) {
+            stats.dmxTruncated++;
+            return false;
+        }
+
+        if (!mergers[outputUniverse].acceptSource(remoteIP, header->Sequence, millis())) {
+            return false;
+        }
+
+        *universe = outputUniverse;
+        *dataLength = length;
+
+        return true;
+    }
+
+    template <typename Sink>
+    bool BasicArtNet<Sink>::needsMerge(uint8_t universe) const {
+        return mergers[universe].isMerging();
+    }
+
+    template <typename Sink>
+    bool BasicArtNet<Sink>::isSynchronous() const {
+        return synchronous;
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::onDmxFrameReceived(uint8_t universe) {
+        if (synchronous && millis() - lastSyncMillis > ART_NET_SYNC_TIMEOUT_MS) {
+            synchronous = false;
+        }
+
+        if (!synchronous) {
+            sink.onDmxCommit();
+        }
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::onSyncPacket() {
+        synchronous = true;
+        lastSyncMillis = millis();
+
+        sink.onDmxCommit();
+
+        if (addressPending) {
+            applyPendingAddress();
+        }
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::onDmxData(uint8_t universe, const uint8_t *data, uint16_t dataLength) {
+        if (mergers[universe].isMerging()) {
+            data = mergers[universe].merge(data, dataLength, &dataLength);
+
+            if (!data) {
+                return;
+            }
+        }
+
+        sink.onDmxData(universe, 0, data, dataLength);
+        onDmxFrameReceived(universe);
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::onDmxPacket(uint32_t remoteIP, ArtNetDmxDataPacket *packet, uint32_t size) {
+        uint8_t universe;
+        uint16_t dataLength;
+
+        if (size < ART_NET_DMX_HEADER_SIZE) {
+            stats.badSize++;
+            return;
+        }
+
+        if (!acceptDmxHeader(remoteIP, packet, size - ART_NET_DMX_HEADER_SIZE, &universe, &dataLength)) {
+            return;
+        }
+
+        onDmxData(universe, packet->Data, dataLength);
+    }
+
+    template <typename Sink>
+    void BasicArtNet<Sink>::onNzsPacket(const ArtNetNzsDataPacket *packet, uint32_t size) {
+        stats.nzs++;
+
+        if (size < ART_NET_DMX_HEADER_SIZE) {
+            stats.badSize++;
+            return;
+        }
+
+        int8_t outputUniverse = getOutputUniverse(packet->Net, packet->SubUni);
+
+        if (outputUniverse < 0) {
+            stats.dmxForeign++;
+            return;
+        }
+
+        uint16_t length = ((uint16_t)packet->LengthHi << 8) | packet->LengthLo;
+
+        if (length > 512 || packet->StartCode == 0) {
+            stats.dmxBadLength++;
+            return;
+        }
+
+        if ((uint32_t)ART_NET_DMX_HEADER_SIZE + length > size) {
+            stats.dmxTruncated++;
+            return;
+        }
+
+        sink.onDmxData(outputUniverse, packet->StartCode, packet->Data, length);
+    }
+
+    template <typename Sink>
+    PacketParseStatus BasicArtNet<Sink>::onPacketReceived(uint32_t remoteIP, uint16_t remotePort, const uint8_t *data, uint32_t size) {
+        if (size < sizeof(ArtNetBasePacket)) {
+            stats.badSize++;
+            return PacketParseStatus::BadSize;
+        }
+
+        if (!art_net_has_valid_id(data)) {
+            stats.badId++;
+            return PacketParseStatus::BadId;
+        }
+
+        ArtNetBasePacket *basePacket = (ArtNetBasePacket*) data;
+
+        switch (art_net_get_packet_op_code(basePacket)) {
+            case OpCode::Address: {
+                stats.address++;
+                onAddressPacket(remoteIP, remotePort, data, size);
+                return PacketParseStatus::Success;
+            }
+            case OpCode::Input: {
+                stats.address++;
+                schedulePollReply(remoteIP, remotePort, 0);
+                return PacketParseStatus::Success;
+            }
+            case OpCode::Poll: {
+                stats.poll++;
+                onPollPacket(remoteIP, remotePort, data, size);
+                return PacketParseStatus::Success;
+            }
+            case OpCode::Dmx: {
+                onDmxPacket(remoteIP, (ArtNetDmxDataPacket*) basePacket, size);
+                return PacketParseStatus::Success;
+            }
+            case OpCode::Nzs: {
+                onNzsPacket((ArtNetNzsDataPacket*) basePacket, size);
+                return PacketParseStatus::Success;
+            }
+            case OpCode::Sync: {
+                stats.sync++;
+                onSyncPacket();
+                return PacketParseStatus::Success;
+            }
+            default: {
+                stats.otherOpCode++;
+                return PacketParseStatus::BadOpCode;
+            }
+        };
+
+        return PacketParseStatus::Invalid;
+    }
+
+    template <typename Sink>
+    HeaderClass BasicArtNet<Sink>::classifyHeader(const uint8_t *data, uint32_t size) const {
+        if (size < ART_NET_DMX_HEADER_SIZE || !art_net_has_valid_id(data)) {
+            return HeaderClass::Other;
+        }
+
+        const ArtNetDmxDataPacket *packet = (const ArtNetDmxDataPacket*) data;
+
+        if (packet->OpCodeLo != ((uint16_t)OpCode::Dmx & 0xFF) || packet->OpCodeHi != ((uint16_t)OpCode::Dmx >> 8)) {
+            return HeaderClass::Other;
+        }
+
+        if (getOutputUniverse(packet->Net, packet->SubUni) < 0) {
+            return HeaderClass::DmxRejected;
+        }
+
+        return HeaderClass::DmxAccepted;
+    }
+}
+
+#endif
@@ -0,0 +1,258 @@
+#include <ArtNetMerger.h>
+
+namespace art_net {
+    Merger::Merger() {
+        mode = MergeMode::Htp;
+        sequenceRule = SequenceRule::ArtNet;
+        sourceTimeoutMs = ART_NET_MERGE_SOURCE_TIMEOUT_MS;
+        sequenceRejected = 0;
+        sourceRejected = 0;
+        sourceCount = 0;
+        currentSource = 0;
+        outputValid = 0;
+        outputLength = 0;
+        memset(output, 0, sizeof(output));
+    }
+
+    uint8_t Merger::getSourceCount() const {
+        return sourceCount;
+    }
+
+    bool Merger::isMerging() const {
+        return sourceCount > 1;
+    }
+
+    void Merger::removeSourceAt(uint8_t index) {
+        sourceCount--;
+
+        if (index != sourceCount) {
+            memcpy(&sources[index], &sources[sourceCount], sizeof(MergeSource));
+        }
+    }
+
+    void Merger::onSourcesRemoved() {
+        if (sourceCount <= 1) {
+            // Back to pass through, stop keeping a copy of the data.
+            sources[0].hasData = 0;
+            outputValid = 0;
+        } else if (outputValid) {
+            recomputeOutput();
+        }
+    }
+
+    void Merger::removeExpiredSources(unsigned long now) {
+        uint8_t removed = 0;
+
+        for (uint8_t i = 0; i < sourceCount;) {
+            if (now - sources[i].lastReceived > sourceTimeoutMs) {
+                removeSourceAt(i);
+                removed = 1;
+            } else {
+                i++;
+            }
+        }
+
+        if (removed) {
+            onSourcesRemoved();
+        }
+    }
+
+    void Merger::ipToId(uint32_t ip, uint8_t *id) {
+        memset(id, 0, ART_NET_MERGE_SOURCE_ID_SIZE);
+        memcpy(id, &ip, sizeof(ip));
+    }
+
+    void Merger::removeSource(uint32_t ip) {
+        uint8_t id[ART_NET_MERGE_SOURCE_ID_SIZE];
+
+        ipToId(ip, id);
+        removeSource(id);
+    }
+
+    void Merger::removeSource(const uint8_t *id) {
+        for (uint8_t i = 0; i < sourceCount; i++) {
+            if (memcmp(sources[i].id, id, ART_NET_MERGE_SOURCE_ID_SIZE) == 0) {
+                removeSourceAt(i);
+                onSourcesRemoved();
+                return;
+            }
+        }
+    }
+
+    void Merger::clearSources() {
+        sourceCount = 0;
+        currentSource = 0;
+        outputValid = 0;
+    }
+
+    bool Merger::acceptSource(uint32_t ip, uint8_t sequence, unsigned long now) {
+        uint8_t id[ART_NET_MERGE_SOURCE_ID_SIZE];
+
+        ipToId(ip, id);
+        return acceptSource(id, sequence, now);
+    }
+
+    bool Merger::acceptSource(const uint8_t *id, uint8_t sequence, unsigned long now) {
+        removeExpiredSources(now);
+
+        uint8_t index = 0;
+
+        while (index < sourceCount && memcmp(sources[index].id, id, ART_NET_MERGE_SOURCE_ID_SIZE) != 0) {
+            index++;
+        }
+
+        bool added = index == sourceCount;
+
+        if (added) {
+            if (sourceCount == ART_NET_MERGE_MAX_SOURCES) {
+                sourceRejected++;
+                return false;
+            }
+
+            MergeSource *source = &sources[sourceCount++];
+            memcpy(source->id, id, ART_NET_MERGE_SOURCE_ID_SIZE);
+            source->sequence = 0;
+            source->hasData = 0;
+            source->length = 0;
+            memset(source->data, 0, sizeof(source->data));
+
+            if (sourceCount == 2) {
+                // The first source was passed through without keeping its data,
+                // the merge starts once it sends again.
+                sources[0].hasData = 0;
+                outputValid = 0;
+            }
+        }
+
+        MergeSource *source = &sources[index];
+
+        if (sequenceRule == SequenceRule::E131) {
+            int8_t ahead = (int8_t)(sequence - source->sequence);
+
+            if (!added && ahead <= 0 && ahead > -20) {
+                sequenceRejected++;
+                return false;
+            }
+
+            source->sequence = sequence;
+        } else if (sequence > 0) {
+            if (sequence <= (0xF + 1) && source->sequence >= (0xFF - 1 - 0xF)) {
+                source->sequence = sequence;
+            } else if (source->sequence > sequence) {
+                sequenceRejected++;
+                return false;
+            } else {
+                source->sequence = sequence;
+            }
+        }
+
+        source->lastReceived = now;
+        currentSource = index;
+
+        return true;
+    }
+
+    uint8_t Merger::highestValue(uint16_t channel) const {
+        uint8_t value = 0;
+
+        for (uint8_t i = 0; i < sourceCount; i++) {
+            if (sources[i].data[channel] > value) {
+                value = sources[i].data[channel];
+            }
+        }
+
+        return value;
+    }
+
+    void Merger::recomputeOutput() {
+        outputLength = 0;
+
+        for (uint8_t i = 0; i < sourceCount; i++) {
+            if (sources[i].length > outputLength) {
+                outputLength = sources[i].length;
+            }
+        }
+
+        const MergeSource *latest = &sources[currentSource];
+
+        // Channels past outputLength are kept merged too (at zero), so the
+        // incremental update never starts from a stale value.
+        for (uint16_t i = 0; i < sizeof(output); i++) {
+            if (mode == MergeMode::Ltp && i < latest->length) {
+                output[i] = latest->data[i];
+            } else {
+                output[i] = highestValue(i);
+            }
+        }
+    }
+
+    const uint8_t* Merger::merge(const uint8_t *data, uint16_t length, uint16_t *mergedLength) {
+        MergeSource *source = &sources[currentSource];
+
+        if (!outputValid) {
+            memcpy(source->data, data, length);
+            memset(&source->data[length], 0, sizeof(source->data) - length);
+            source->length = length;
+            source->hasData = 1;
+
+            for (uint8_t i = 0; i < sourceCount; i++) {
+                if (!sources[i].hasData) {
+                    return NULL;
+                }
+            }
+
+            recomputeOutput();
+            outputValid = 1;
+
+            *mergedLength = outputLength;
+            return output;
+        }
+
+        // Source data past its length is kept at zero, so a shorter packet is
+        // just a change to zero for the channels it no longer carries.
+        uint16_t end = length > source->length ? length : source->length;
+
+        for (uint16_t i = 0; i < end;) {
+            // Skip unchanged channels 4 at a time.
+            if ((i & 3) == 0 && i + 4 <= length) {
+                uint32_t previousWord, currentWord;
+                memcpy(&previousWord, &source->data[i], sizeof(previousWord));
+                memcpy(&currentWord, &data[i], sizeof(currentWord));
+
+                if (previousWord == currentWord) {
+                    i += 4;
+                    continue;
+                }
+            }
+
+            uint8_t previous = source->data[i];
+            uint8_t current = i < length ? data[i] : 0;
+
+            if (previous != current) {
+                source->data[i] = current;
+
+                if (mode == MergeMode::Ltp || current > output[i]) {
+                    output[i] = current;
+                } else if (previous == output[i]) {
+                    output[i] = highestValue(i);
+                }
+            }
+
+            i++;
+        }
+
+        if (length != source->length) {
+            source->length = length;
+            outputLength = 0;
+
+            for (uint8_t i = 0; i < sourceCount; i++) {
+                if (sources[i].length > outputLength) {
+                    outputLength = sources[i].length;
+                }
+            }
+        }
+
+        *mergedLength = outputLength;
+        return output;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef ART_NET_MERGER_H
+#define ART_NET_MERGER_H
+
+#include <Arduino.h>
+
+#ifndef ART_NET_MERGE_MAX_SOURCES
+#define ART_NET_MERGE_MAX_SOURCES 4
+#endif
+
+// A source that stops sending is dropped from the merge after this long.
+#ifndef ART_NET_MERGE_SOURCE_TIMEOUT_MS
+#define ART_NET_MERGE_SOURCE_TIMEOUT_MS 10000
+#endif
+
+// Bytes that tell sources apart: the CID of an sACN source, the IP of an
+// ArtNet one (zero padded).
+#define ART_NET_MERGE_SOURCE_ID_SIZE 16
+
+namespace art_net {
+    enum class MergeMode : uint8_t {
+        // Highest value of all sources wins, per channel.
+        Htp = 0,
+        // Last changed value wins, per channel.
+        Ltp = 1
+    };
+
+    enum class SequenceRule : uint8_t {
+        // 0 disables the check, 1-255 increase and wrap (ArtDmx).
+        ArtNet = 0,
+        // Every value counts, a packet up to 20 behind the last one is
+        // out of order, further back is a restart (E1.31 6.7.2).
+        E131 = 1
+    };
+
+    typedef struct {
+        uint8_t id[ART_NET_MERGE_SOURCE_ID_SIZE];
+        unsigned long lastReceived;
+        uint8_t sequence;
+        // Data below is only kept while merging.
+        uint8_t hasData;
+        uint16_t length;
+        uint8_t data[512];
+    } MergeSource;
+
+    // Tracks the senders of one output universe, keyed by IP or CID.
+    // A single sender is passed straight through; with more than one the
+    // merged frame is kept here and updated only for the channels that changed.
+    class Merger {
+        public:
+            MergeMode mode;
+            SequenceRule sequenceRule;
+            // A source is dropped from the merge after this long without data.
+            uint32_t sourceTimeoutMs;
+            // Packets refused by acceptSource, by reason.
+            uint32_t sequenceRejected;
+            uint32_t sourceRejected;
+
+            Merger();
+            // Registers a packet from `ip`. Returns false when it must be dropped
+            // (out of order sequence or no free source slot).
+            bool acceptSource(uint32_t ip, uint8_t sequence, unsigned long now);
+            // Same, for a source known by its ART_NET_MERGE_SOURCE_ID_SIZE bytes id.
+            bool acceptSource(const uint8_t *id, uint8_t sequence, unsigned long now);
+            // More than one live source: data must go through merge().
+            bool isMerging() const;
+            // Merges the data of the last accepted source. Returns the merged frame,
+            // or NULL while still waiting for data from the other sources.
+            const uint8_t* merge(const uint8_t *data, uint16_t length, uint16_t *mergedLength);
+            // Forgets one source, e.g. after it announced the end of its stream.
+            void removeSource(uint32_t ip);
+            void removeSource(const uint8_t *id);
+            // Forgets all sources, the next one is passed through again.
+            void clearSources();
+            uint8_t getSourceCount() const;
+        private:
+            MergeSource sources[ART_NET_MERGE_MAX_SOURCES];
+            uint8_t sourceCount;
+            uint8_t currentSource;
+            uint8_t outputValid;
+            uint16_t outputLength;
+            uint8_t output[512];
+
+            static void ipToId(uint32_t ip, uint8_t *id);
+            void removeExpiredSources(unsigned long now);
+            void removeSourceAt(uint8_t index);
+            void onSourcesRemoved();
+            void recomputeOutput();
+            uint8_t highestValue(uint16_t channel) const;
+    };
+}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef ART_NET_RECEIVER_H
+#define ART_NET_RECEIVER_H
+
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <DmxFrameBuffer.h>
+#include <DmxProcessor.h>
+
+// Datagrams handled per drain() call at most.
+#ifndef ART_NET_RECEIVE_MAX_PACKETS
+#define ART_NET_RECEIVE_MAX_PACKETS 16
+#endif
+
+// drain() stops taking new datagrams once it ran this long, so Bluetooth and
+// WiFi still get their turn in the loop under heavy traffic.
+#ifndef ART_NET_RECEIVE_BUDGET_MICROS
+#define ART_NET_RECEIVE_BUDGET_MICROS 2000
+#endif
+
+namespace art_net {
+    typedef struct {
+        uint32_t packets;
+        uint32_t dmxFrames;
+        // drain() calls that ended on the budget instead of an empty queue.
+        uint32_t budgetStops;
+    } ReceiveStats;
+
+    // Receive stage of the node: pulls the queued datagrams out of `Udp`
+    // (WiFiUDP on the device, a fake on the host) and feeds them to the
+    // `Protocol` listening on that socket, ArtNet or E131.
+    // Slot data of a non merged frame is read straight into the frame buffer
+    // of its port, unless the DmxProcessor of the port has work to do. Drops
+    // are counted in the protocol statistics.
+    template <typename Udp, typename Protocol = ArtNet>
+    class Receiver {
+        public:
+            uint16_t maxPackets;
+            uint32_t budgetMicros;
+            ReceiveStats stats;
+
+            // `processors`, one per port, is optional.
+            Receiver(Protocol *protocol, Udp *udp, DmxFrameBuffer *frameBuffers, DmxProcessor *processors = NULL) {
+                this->protocol = protocol;
+                this->udp = udp;
+                this->frameBuffers = frameBuffers;
+                this->processors = processors;
+                maxPackets = ART_NET_RECEIVE_MAX_PACKETS;
+                budgetMicros = ART_NET_RECEIVE_BUDGET_MICROS;
+                memset(&stats, 0, sizeof(stats));
+            }
+
+            // Handles queued datagrams until the queue is empty or the budget
+            // is spent. Returns the number handled.
+            uint16_t drain() {
+                unsigned long start = micros();
+                uint16_t packets = 0;
+
+                while (packets < maxPackets) {
+                    if (!udp->parsePacket()) {
+                        return packets;
+                    }
+
+                    receivePacket();
+                    packets++;
+
+                    if (micros() - start >= budgetMicros) {
+                        break;
+                    }
+                }
+
+                stats.budgetStops++;
+                return packets;
+            }
+        private:
+            Protocol *protocol;
+            Udp *udp;
+            DmxFrameBuffer *frameBuffers;
+            DmxProcessor *processors;
+            uint32_t buffer[512];
+
+            void receivePacket() {
+                stats.packets++;
+
+                size_t read = udp->read((uint8_t*)buffer, Protocol::DMX_HEADER_SIZE);
+
+                HeaderClass headerClass = protocol->classifyHeader((uint8_t*)buffer, read);
+
+                if (headerClass == HeaderClass::DmxRejected) {
+                    protocol->stats.dmx++;
+                    protocol->stats.dmxForeign++;
+                    udp->flush();
+                } else if (headerClass == HeaderClass::DmxAccepted) {
+                    receiveDmxPayload((typename Protocol::DmxPacket*)buffer);
+                } else {
+                    read += udp->read(((uint8_t*)buffer) + read, sizeof(buffer) - read);
+                    protocol->onPacketReceived(udp->remoteIP(), udp->remotePort(), (uint8_t*)buffer, read);
+                }
+            }
+
+            // Reads the slot data straight into the DMX back buffer, unless
+            // several sources have to be merged or the slots processed first.
+            void receiveDmxPayload(typename Protocol::DmxPacket *header) {
+                uint8_t universe;
+                uint16_t dataLength;
+
+                // Checks the slots are all there before the merger counts the source.
+                if (!protocol->acceptDmxHeader(udp->remoteIP(), header, udp->available(), &universe, &dataLength)) {
+                    udp->flush();
+                    return;
+                }
+
+                if (protocol->needsMerge(universe) || (processors && !processors[universe].isPassthrough())) {
+                    if (udp->read(header->Data, dataLength) == dataLength) {
+                        stats.dmxFrames++;
+                        protocol->onDmxData(universe, header->Data, dataLength);
+                    } else {
+                        protocol->stats.dmxTruncated++;
+                    }
+
+                    udp->flush();
+                    return;
+                }
+
+                DmxFrameBuffer *frameBuffer = &frameBuffers[universe];
+                uint8_t *slots = frameBuffer->beginWrite(0, dataLength);
+
+                if (udp->read(slots, dataLength) == dataLength) {
+                    stats.dmxFrames++;
+                    frameBuffer->stageWrite();
+                    protocol->onDmxFrameReceived(universe);
+                } else {
+                    protocol->stats.dmxTruncated++;
+                    frameBuffer->abortWrite();
+                }
+
+                udp->flush();
+            }
+    };
+}
+
+#endif
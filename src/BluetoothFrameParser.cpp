@@ -0,0 +1,153 @@
+#include <BluetoothFrameParser.h>
+#include <ConfigStore.h>
+
+enum BluetoothFrameState {
+    BLUETOOTH_FRAME_STATE_SYNC_0,
+    BLUETOOTH_FRAME_STATE_SYNC_1,
+    BLUETOOTH_FRAME_STATE_TYPE,
+    BLUETOOTH_FRAME_STATE_LENGTH_LO,
+    BLUETOOTH_FRAME_STATE_LENGTH_HI,
+    BLUETOOTH_FRAME_STATE_PAYLOAD,
+    BLUETOOTH_FRAME_STATE_CRC,
+};
+
+BluetoothFrameParser::BluetoothFrameParser() {
+    memset(&stats, 0, sizeof(BluetoothFrameStats));
+    timeoutMs = BLUETOOTH_FRAME_TIMEOUT_MS;
+    type = 0;
+    length = 0;
+    lastByteMillis = 0;
+    reset();
+}
+
+void BluetoothFrameParser::reset() {
+    state = BLUETOOTH_FRAME_STATE_SYNC_0;
+    received = 0;
+    crc = 0;
+    frameCrc = 0;
+}
+
+bool BluetoothFrameParser::isIdle() const {
+    return state == BLUETOOTH_FRAME_STATE_SYNC_0;
+}
+
+bool BluetoothFrameParser::expire(unsigned long now) {
+    if (isIdle() || now - lastByteMillis <= timeoutMs) {
+        return false;
+    }
+
+    stats.timeouts++;
+    reset();
+    return true;
+}
+
+BluetoothFrameResult BluetoothFrameParser::push(uint8_t value, unsigned long now) {
+    expire(now);
+    lastByteMillis = now;
+
+    switch (state) {
+        case BLUETOOTH_FRAME_STATE_SYNC_0:
+            if (value == BLUETOOTH_FRAME_SYNC_0) {
+                state = BLUETOOTH_FRAME_STATE_SYNC_1;
+            } else {
+                stats.skippedBytes++;
+            }
+            return BLUETOOTH_FRAME_PENDING;
+        case BLUETOOTH_FRAME_STATE_SYNC_1:
+            if (value == BLUETOOTH_FRAME_SYNC_1) {
+                state = BLUETOOTH_FRAME_STATE_TYPE;
+            } else if (value != BLUETOOTH_FRAME_SYNC_0) {
+                // The first sync byte was data too.
+                stats.skippedBytes += 2;
+                state = BLUETOOTH_FRAME_STATE_SYNC_0;
+            } else {
+                stats.skippedBytes++;
+            }
+            return BLUETOOTH_FRAME_PENDING;
+        case BLUETOOTH_FRAME_STATE_TYPE:
+            type = value;
+            break;
+        case BLUETOOTH_FRAME_STATE_LENGTH_LO:
+            length = value;
+            break;
+        case BLUETOOTH_FRAME_STATE_LENGTH_HI:
+            length |= value << 8;
+
+            if (length > BLUETOOTH_FRAME_MAX_PAYLOAD) {
+                stats.lengthErrors++;
+                reset();
+                return BLUETOOTH_FRAME_ERROR;
+            }
+            break;
+        case BLUETOOTH_FRAME_STATE_PAYLOAD:
+            payload[received++] = value;
+            crc = ConfigStoreCrc(crc, &value, 1);
+
+            if (received < length) {
+                return BLUETOOTH_FRAME_PENDING;
+            }
+
+            received = 0;
+            state = BLUETOOTH_FRAME_STATE_CRC;
+            return BLUETOOTH_FRAME_PENDING;
+        case BLUETOOTH_FRAME_STATE_CRC:
+            frameCrc |= (uint32_t) value << (8 * received++);
+
+            if (received < BLUETOOTH_FRAME_CRC_SIZE) {
+                return BLUETOOTH_FRAME_PENDING;
+            }
+
+            if (frameCrc != crc) {
+                stats.crcErrors++;
+                reset();
+                return BLUETOOTH_FRAME_ERROR;
+            }
+
+            stats.frames++;
+            reset();
+            return BLUETOOTH_FRAME_COMPLETE;
+    }
+
+    // Type and length bytes.
+    crc = ConfigStoreCrc(crc, &value, 1);
+    state++;
+
+    if (state == BLUETOOTH_FRAME_STATE_PAYLOAD && length == 0) {
+        state = BLUETOOTH_FRAME_STATE_CRC;
+    }
+
+    return BLUETOOTH_FRAME_PENDING;
+}
+
+uint8_t BluetoothFrameParser::getType() const {
+    return type;
+}
+
+const uint8_t* BluetoothFrameParser::getPayload() const {
+    return payload;
+}
+
+uint16_t BluetoothFrameParser::getLength() const {
+    return length;
+}
+
+uint32_t BluetoothFrameEncode(uint8_t type, const uint8_t *payload, uint16_t size, uint8_t *frame) {
+    frame[0] = BLUETOOTH_FRAME_SYNC_0;
+    frame[1] = BLUETOOTH_FRAME_SYNC_1;
+    frame[2] = type;
+    frame[3] = size & 0xFF;
+    frame[4] = size >> 8;
+
+    if (size) {
+        memcpy(frame + BLUETOOTH_FRAME_HEADER_SIZE, payload, size);
+    }
+
+    uint32_t crc = ConfigStoreCrc(0, frame + 2, BLUETOOTH_FRAME_HEADER_SIZE - 2 + size);
+    uint8_t *end = frame + BLUETOOTH_FRAME_HEADER_SIZE + size;
+
+    for (uint8_t i = 0; i < BLUETOOTH_FRAME_CRC_SIZE; i++) {
+        end[i] = crc >> (8 * i);
+    }
+
+    return BLUETOOTH_FRAME_HEADER_SIZE + size + BLUETOOTH_FRAME_CRC_SIZE;
+}
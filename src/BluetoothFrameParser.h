@@ -0,0 +1,80 @@
+#ifndef BLUETOOTH_FRAME_PARSER_H
+#define BLUETOOTH_FRAME_PARSER_H
+
+#include <Arduino.h>
+
+#define BLUETOOTH_FRAME_SYNC_0 0xA5
+#define BLUETOOTH_FRAME_SYNC_1 0x5A
+// Sync, type and length before the payload, CRC after it.
+#define BLUETOOTH_FRAME_HEADER_SIZE 5
+#define BLUETOOTH_FRAME_CRC_SIZE 4
+// Largest payload accepted, longer frames are dropped from their header.
+#ifndef BLUETOOTH_FRAME_MAX_PAYLOAD
+#define BLUETOOTH_FRAME_MAX_PAYLOAD 512
+#endif
+// A frame not complete this long after its last byte is dropped.
+#ifndef BLUETOOTH_FRAME_TIMEOUT_MS
+#define BLUETOOTH_FRAME_TIMEOUT_MS 1000
+#endif
+
+enum BluetoothFrameResult {
+    // Needs more bytes.
+    BLUETOOTH_FRAME_PENDING,
+    // The frame is in getType / getPayload until the next push.
+    BLUETOOTH_FRAME_COMPLETE,
+    // Bad length or CRC, the frame was dropped.
+    BLUETOOTH_FRAME_ERROR,
+};
+
+typedef struct {
+    uint32_t frames;
+    uint32_t crcErrors;
+    uint32_t lengthErrors;
+    uint32_t timeouts;
+    // Outside of any frame while looking for the sync bytes.
+    uint32_t skippedBytes;
+} BluetoothFrameStats;
+
+// Request framing of the Bluetooth serial link:
+//   0xA5 0x5A, type, payload length (2 bytes, little endian), payload,
+//   CRC-32 (zlib, little endian) of type, length and payload.
+// The link is a byte stream, a request can arrive in pieces or together with
+// the next one; the parser takes one byte at a time, so the loop reads what
+// is there up to its own budget and never waits for the rest. After a bad
+// frame it looks for the next sync bytes.
+class BluetoothFrameParser {
+    public:
+        BluetoothFrameStats stats;
+        uint32_t timeoutMs;
+
+        BluetoothFrameParser();
+
+        BluetoothFrameResult push(uint8_t value, unsigned long now);
+        // Drops a partial frame whose last byte is older than timeoutMs.
+        // Returns true if it did.
+        bool expire(unsigned long now);
+        // Drops a partial frame.
+        void reset();
+        bool isIdle() const;
+
+        // Of the frame push completed.
+        uint8_t getType() const;
+        const uint8_t* getPayload() const;
+        uint16_t getLength() const;
+    private:
+        uint8_t state;
+        uint8_t type;
+        uint16_t length;
+        uint16_t received;
+        uint32_t crc;
+        uint32_t frameCrc;
+        unsigned long lastByteMillis;
+        uint8_t payload[BLUETOOTH_FRAME_MAX_PAYLOAD];
+};
+
+// Writes the frame around `payload` to `frame`, which holds at least
+// BLUETOOTH_FRAME_HEADER_SIZE + size + BLUETOOTH_FRAME_CRC_SIZE bytes.
+// Returns the frame size.
+uint32_t BluetoothFrameEncode(uint8_t type, const uint8_t *payload, uint16_t size, uint8_t *frame);
+
+#endif
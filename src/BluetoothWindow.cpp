@@ -0,0 +1,77 @@
+#include <BluetoothWindow.h>
+
+BluetoothWindow::BluetoothWindow() {
+    windowMs = BLUETOOTH_WINDOW_MS;
+    starts = 0;
+    stops = 0;
+    on = 0;
+    startRequested = 0;
+    buttonDown = 0;
+    buttonHandled = 0;
+    buttonDownMillis = 0;
+    lastActivityMillis = 0;
+}
+
+void BluetoothWindow::begin(uint32_t windowMs, unsigned long now) {
+    this->windowMs = windowMs;
+    on = 1;
+    startRequested = 0;
+    lastActivityMillis = now;
+}
+
+void BluetoothWindow::touch(unsigned long now) {
+    lastActivityMillis = now;
+}
+
+void BluetoothWindow::setButton(bool pressed, unsigned long now) {
+    if (!pressed) {
+        buttonDown = 0;
+        buttonHandled = 0;
+        return;
+    }
+
+    if (!buttonDown) {
+        buttonDown = 1;
+        buttonDownMillis = now;
+    }
+
+    // Once per press, however long it is held.
+    if (!buttonHandled && now - buttonDownMillis >= BLUETOOTH_BUTTON_DEBOUNCE_MS) {
+        buttonHandled = 1;
+        startRequested = 1;
+        lastActivityMillis = now;
+    }
+}
+
+BluetoothWindowAction BluetoothWindow::update(unsigned long now, bool busy) {
+    if (!on) {
+        if (!startRequested) {
+            return BLUETOOTH_WINDOW_NONE;
+        }
+
+        on = 1;
+        startRequested = 0;
+        lastActivityMillis = now;
+        starts++;
+        return BLUETOOTH_WINDOW_START;
+    }
+
+    startRequested = 0;
+
+    if (busy) {
+        lastActivityMillis = now;
+        return BLUETOOTH_WINDOW_NONE;
+    }
+
+    if (windowMs == 0 || now - lastActivityMillis < windowMs) {
+        return BLUETOOTH_WINDOW_NONE;
+    }
+
+    on = 0;
+    stops++;
+    return BLUETOOTH_WINDOW_STOP;
+}
+
+bool BluetoothWindow::isOn() const {
+    return on;
+}
@@ -0,0 +1,54 @@
+#ifndef BLUETOOTH_WINDOW_H
+#define BLUETOOTH_WINDOW_H
+
+#include <Arduino.h>
+
+// How long Bluetooth stays on after boot, a button press or the last
+// request. 0 keeps it on all the time.
+#ifndef BLUETOOTH_WINDOW_MS
+#define BLUETOOTH_WINDOW_MS 0
+#endif
+// The button must read pressed this long to count.
+#ifndef BLUETOOTH_BUTTON_DEBOUNCE_MS
+#define BLUETOOTH_BUTTON_DEBOUNCE_MS 50
+#endif
+
+enum BluetoothWindowAction {
+    BLUETOOTH_WINDOW_NONE,
+    BLUETOOTH_WINDOW_START,
+    BLUETOOTH_WINDOW_STOP,
+};
+
+// Decides when the Bluetooth stack runs. It is on at boot; with a window
+// set, it is stopped once nothing used it for that long, and started again
+// by a press of the button. It is never stopped while busy (a client is
+// connected or a request is half received).
+class BluetoothWindow {
+    public:
+        uint32_t windowMs;
+        // Since begin.
+        uint32_t starts;
+        uint32_t stops;
+
+        BluetoothWindow();
+        // Bluetooth was started at `now`.
+        void begin(uint32_t windowMs, unsigned long now);
+
+        // A request came in, the window starts over.
+        void touch(unsigned long now);
+        // Level of the button, read every loop.
+        void setButton(bool pressed, unsigned long now);
+        // What to do with the stack now.
+        BluetoothWindowAction update(unsigned long now, bool busy);
+
+        bool isOn() const;
+    private:
+        uint8_t on;
+        uint8_t startRequested;
+        uint8_t buttonDown;
+        uint8_t buttonHandled;
+        unsigned long buttonDownMillis;
+        unsigned long lastActivityMillis;
+};
+
+#endif
@@ -0,0 +1,391 @@
+#include <ConfigStore.h>
+#include <stddef.h>
+
+#define CONFIG_STORE_ALIGN(size) (((size) + 3) & ~3)
+// Record header, range header and CRC of a whole config.
+#define CONFIG_STORE_WHOLE_RECORD_SIZE CONFIG_STORE_ALIGN(sizeof(ConfigStoreRecord) + sizeof(ConfigStoreRange) + CONFIG_STORE_MAX_SIZE + 4)
+
+static_assert(sizeof(ConfigStoreHeader) + CONFIG_STORE_WHOLE_RECORD_SIZE <= CONFIG_STORE_SECTOR_SIZE, "A sector must hold the whole config");
+
+// CRC-32 (as zlib), a nibble at a time to keep the table small.
+static const uint32_t crcTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint32_t ConfigStoreCrc(uint32_t crc, const uint8_t *data, uint32_t size) {
+    crc = ~crc;
+
+    for (uint32_t i = 0; i < size; i++) {
+        crc = crcTable[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = crcTable[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+
+    return ~crc;
+}
+
+static bool isNewer(uint32_t sequence, uint32_t than) {
+    return (int32_t)(sequence - than) > 0;
+}
+
+ConfigStore::ConfigStore() {
+    erases = 0;
+    records = 0;
+    bytesWritten = 0;
+    flash = NULL;
+    version = 0;
+    size = 0;
+    loaded = 0;
+    sector = 1;
+    sequence = 0;
+    writeOffset = 0;
+}
+
+void ConfigStore::begin(ConfigStoreFlash *flash, uint16_t version, uint16_t size) {
+    this->flash = flash;
+    this->version = version;
+    this->size = size;
+    loaded = 0;
+    sector = 1;
+    sequence = 0;
+    writeOffset = 0;
+}
+
+bool ConfigStore::isUsable() {
+    return flash && size > 0 && size <= CONFIG_STORE_MAX_SIZE && flash->getSize() >= 2 * CONFIG_STORE_SECTOR_SIZE;
+}
+
+bool ConfigStore::readHeader(uint8_t sector, ConfigStoreHeader *header) {
+    if (!flash->read(sector * CONFIG_STORE_SECTOR_SIZE, (uint8_t*) header, sizeof(ConfigStoreHeader))) {
+        return false;
+    }
+
+    return header->magic == CONFIG_STORE_MAGIC
+        && header->crc == ConfigStoreCrc(0, (const uint8_t*) header, offsetof(ConfigStoreHeader, crc));
+}
+
+bool ConfigStore::load(uint8_t *data) {
+    if (!isUsable()) {
+        return false;
+    }
+
+    ConfigStoreHeader headers[2];
+    bool valid[2];
+    bool seen = false;
+    uint8_t newestSeen = 1;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        valid[i] = readHeader(i, &headers[i]);
+
+        // New sectors stay above any seen, even of another layout, and don't
+        // go over the newest of them: it may be what the config is migrated
+        // from.
+        if (valid[i] && (!seen || isNewer(headers[i].sequence, sequence))) {
+            sequence = headers[i].sequence;
+            newestSeen = i;
+            seen = true;
+        }
+
+        valid[i] = valid[i] && headers[i].version == version && headers[i].size == size;
+    }
+
+    uint8_t newest = valid[1] && (!valid[0] || isNewer(headers[1].sequence, headers[0].sequence));
+
+    for (uint8_t i = 0; i < 2; i++) {
+        uint8_t candidate = i ? newest ^ 1 : newest;
+        bool complete;
+
+        if (!valid[candidate]) {
+            continue;
+        }
+
+        uint16_t end = replay(candidate, &complete);
+
+        if (end) {
+            loaded = 1;
+            sector = candidate;
+            // After a bad record: the next store goes to the other sector.
+            writeOffset = complete ? end : CONFIG_STORE_SECTOR_SIZE;
+            memcpy(data, stored, size);
+            return true;
+        }
+    }
+
+    loaded = 0;
+    sector = newestSeen;
+    return false;
+}
+
+// Reads the records of `sector` into `stored`, stopping at the end of the
+// journal or at the first bad record. Returns the offset after the last good
+// one, 0 if the first was bad.
+uint16_t ConfigStore::replay(uint8_t sector, bool *complete) {
+    uint32_t base = sector * CONFIG_STORE_SECTOR_SIZE;
+    uint16_t offset = sizeof(ConfigStoreHeader);
+    bool first = true;
+
+    *complete = false;
+
+    while (true) {
+        ConfigStoreRecord record;
+
+        if (offset + sizeof(ConfigStoreRecord) > CONFIG_STORE_SECTOR_SIZE) {
+            *complete = true;
+            break;
+        }
+
+        if (!flash->read(base + offset, (uint8_t*) &record, sizeof(ConfigStoreRecord))) {
+            break;
+        }
+
+        if (record.length == 0xFFFF && record.ranges == 0xFFFF) {
+            *complete = true;
+            break;
+        }
+
+        if (!checkRecord(base + offset, &record, first)) {
+            break;
+        }
+
+        uint32_t address = base + offset + sizeof(ConfigStoreRecord);
+
+        for (uint16_t i = 0; i < record.ranges; i++) {
+            ConfigStoreRange range;
+
+            flash->read(address, (uint8_t*) &range, sizeof(ConfigStoreRange));
+            flash->read(address + sizeof(ConfigStoreRange), stored + range.offset, range.length);
+            address += sizeof(ConfigStoreRange) + range.length;
+        }
+
+        offset += CONFIG_STORE_ALIGN(sizeof(ConfigStoreRecord) + record.length + 4);
+        first = false;
+    }
+
+    return first ? 0 : offset;
+}
+
+// Checks the layout and the CRC of a record without applying it.
+bool ConfigStore::checkRecord(uint32_t address, const ConfigStoreRecord *record, bool first) {
+    uint32_t end = address % CONFIG_STORE_SECTOR_SIZE + sizeof(ConfigStoreRecord) + record->length + 4;
+
+    if (record->length == 0 || record->ranges == 0 || end > CONFIG_STORE_SECTOR_SIZE) {
+        return false;
+    }
+
+    // A sector starts with the whole config.
+    if (first && (record->ranges != 1 || record->length != sizeof(ConfigStoreRange) + size)) {
+        return false;
+    }
+
+    uint32_t crc = ConfigStoreCrc(0, (const uint8_t*) record, sizeof(ConfigStoreRecord));
+    uint16_t remaining = record->length;
+    uint8_t chunk[32];
+
+    address += sizeof(ConfigStoreRecord);
+
+    for (uint16_t i = 0; i < record->ranges; i++) {
+        ConfigStoreRange range;
+
+        if (remaining < sizeof(ConfigStoreRange) || !flash->read(address, (uint8_t*) &range, sizeof(ConfigStoreRange))) {
+            return false;
+        }
+
+        remaining -= sizeof(ConfigStoreRange);
+        address += sizeof(ConfigStoreRange);
+
+        if (range.length == 0 || range.length > remaining || range.offset + range.length > size) {
+            return false;
+        }
+
+        crc = ConfigStoreCrc(crc, (const uint8_t*) &range, sizeof(ConfigStoreRange));
+        remaining -= range.length;
+
+        for (uint16_t done = 0; done < range.length; done += sizeof(chunk)) {
+            uint16_t length = range.length - done;
+
+            if (length > sizeof(chunk)) {
+                length = sizeof(chunk);
+            }
+
+            if (!flash->read(address, chunk, length)) {
+                return false;
+            }
+
+            crc = ConfigStoreCrc(crc, chunk, length);
+            address += length;
+        }
+    }
+
+    uint32_t storedCrc;
+
+    return remaining == 0 && flash->read(address, (uint8_t*) &storedCrc, sizeof(storedCrc)) && storedCrc == crc;
+}
+
+// Next bytes of `data` that differ from `stored`, from `from`. Ranges closer
+// than a range header are merged, a new range would cost more.
+bool ConfigStore::nextRange(const uint8_t *data, uint16_t from, uint16_t *start, uint16_t *end) const {
+    uint16_t i = from;
+
+    while (i < size && data[i] == stored[i]) {
+        i++;
+    }
+
+    if (i == size) {
+        return false;
+    }
+
+    *start = i;
+    *end = i + 1;
+
+    for (uint16_t j = *end; j < size && j < *end + sizeof(ConfigStoreRange); j++) {
+        if (data[j] != stored[j]) {
+            *end = j + 1;
+        }
+    }
+
+    return true;
+}
+
+// Bytes of ranges (headers included) a record of `data` takes.
+uint16_t ConfigStore::measure(const uint8_t *data, bool whole, uint16_t *ranges) const {
+    if (whole) {
+        *ranges = 1;
+        return sizeof(ConfigStoreRange) + size;
+    }
+
+    uint16_t length = 0;
+    uint16_t start;
+    uint16_t end = 0;
+
+    *ranges = 0;
+
+    while (nextRange(data, end, &start, &end)) {
+        length += sizeof(ConfigStoreRange) + end - start;
+        (*ranges)++;
+    }
+
+    return length;
+}
+
+bool ConfigStore::writeRecord(uint32_t address, const uint8_t *data, bool whole, uint16_t length, uint16_t ranges) {
+    ConfigStoreRecord record = { length, ranges };
+    uint32_t crc = ConfigStoreCrc(0, (const uint8_t*) &record, sizeof(ConfigStoreRecord));
+
+    if (!flash->write(address, (const uint8_t*) &record, sizeof(ConfigStoreRecord))) {
+        return false;
+    }
+
+    address += sizeof(ConfigStoreRecord);
+
+    uint16_t start = 0;
+    uint16_t end = whole ? size : 0;
+
+    while (whole ? start < end : nextRange(data, end, &start, &end)) {
+        ConfigStoreRange range = { start, (uint16_t)(end - start) };
+
+        crc = ConfigStoreCrc(crc, (const uint8_t*) &range, sizeof(ConfigStoreRange));
+        crc = ConfigStoreCrc(crc, data + start, range.length);
+
+        if (!flash->write(address, (const uint8_t*) &range, sizeof(ConfigStoreRange))
+            || !flash->write(address + sizeof(ConfigStoreRange), data + start, range.length)) {
+            return false;
+        }
+
+        address += sizeof(ConfigStoreRange) + range.length;
+
+        if (whole) {
+            break;
+        }
+    }
+
+    // Last, so a record cut short never checks.
+    if (!flash->write(address, (const uint8_t*) &crc, sizeof(crc))) {
+        return false;
+    }
+
+    records++;
+    bytesWritten += sizeof(ConfigStoreRecord) + length + sizeof(crc);
+    return true;
+}
+
+// Writes the whole config to the other sector, which becomes the one in use.
+bool ConfigStore::switchSector(const uint8_t *data) {
+    uint8_t target = sector ^ 1;
+    uint32_t base = target * CONFIG_STORE_SECTOR_SIZE;
+    ConfigStoreHeader header;
+    uint16_t ranges;
+    uint16_t length = measure(data, true, &ranges);
+
+    header.magic = CONFIG_STORE_MAGIC;
+    header.version = version;
+    header.size = size;
+    header.sequence = sequence + 1;
+    header.crc = ConfigStoreCrc(0, (const uint8_t*) &header, offsetof(ConfigStoreHeader, crc));
+
+    if (!flash->eraseSector(base)) {
+        return false;
+    }
+
+    erases++;
+
+    if (!flash->write(base, (const uint8_t*) &header, sizeof(ConfigStoreHeader))) {
+        return false;
+    }
+
+    bytesWritten += sizeof(ConfigStoreHeader);
+
+    // Until this is written, loading still finds the old sector.
+    if (!writeRecord(base + sizeof(ConfigStoreHeader), data, true, length, ranges)) {
+        return false;
+    }
+
+    loaded = 1;
+    sector = target;
+    sequence++;
+    writeOffset = sizeof(ConfigStoreHeader) + CONFIG_STORE_ALIGN(sizeof(ConfigStoreRecord) + length + 4);
+    memcpy(stored, data, size);
+    return true;
+}
+
+bool ConfigStore::store(const uint8_t *data) {
+    if (!isUsable()) {
+        return false;
+    }
+
+    if (!loaded) {
+        return switchSector(data);
+    }
+
+    uint16_t ranges;
+    uint16_t length = measure(data, false, &ranges);
+
+    if (ranges == 0) {
+        return true;
+    }
+
+    uint16_t recordSize = CONFIG_STORE_ALIGN(sizeof(ConfigStoreRecord) + length + 4);
+
+    if (writeOffset + recordSize > CONFIG_STORE_SECTOR_SIZE) {
+        return switchSector(data);
+    }
+
+    if (!writeRecord(sector * CONFIG_STORE_SECTOR_SIZE + writeOffset, data, false, length, ranges)) {
+        // Whatever got written is in the way of the next record.
+        writeOffset = CONFIG_STORE_SECTOR_SIZE;
+        return false;
+    }
+
+    writeOffset += recordSize;
+    memcpy(stored, data, size);
+    return true;
+}
+
+uint32_t ConfigStore::getSequence() const {
+    return sequence;
+}
+
+uint16_t ConfigStore::getUsed() const {
+    return loaded ? writeOffset : 0;
+}
@@ -0,0 +1,103 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+
+// Erase unit of the flash. The store uses two of them.
+#define CONFIG_STORE_SECTOR_SIZE 4096
+// Largest config it can hold.
+#ifndef CONFIG_STORE_MAX_SIZE
+#define CONFIG_STORE_MAX_SIZE 1024
+#endif
+
+#define CONFIG_STORE_MAGIC 0x47464E43
+
+// Raw storage of the config, at least two sectors, erased sector by sector.
+// Writes only go to erased bytes.
+class ConfigStoreFlash {
+    public:
+        virtual uint32_t getSize() = 0;
+        virtual bool eraseSector(uint32_t offset) = 0;
+        virtual bool write(uint32_t offset, const uint8_t *data, uint32_t size) = 0;
+        virtual bool read(uint32_t offset, uint8_t *data, uint32_t size) = 0;
+};
+
+// Start of a sector in use, written right after erasing it.
+typedef struct {
+    uint32_t magic;
+    // Of the config layout, a sector of another version is ignored.
+    uint16_t version;
+    uint16_t size;
+    // Higher in the newer sector.
+    uint32_t sequence;
+    uint32_t crc;
+} ConfigStoreHeader;
+
+// One store, followed by `ranges` ConfigStoreRange with their bytes
+// (`length` bytes in all), then the CRC of the whole record, padded to 4
+// bytes. All ones where the journal ends.
+typedef struct {
+    uint16_t length;
+    uint16_t ranges;
+} ConfigStoreRecord;
+
+// Changed bytes of the config, they follow right after.
+typedef struct {
+    uint16_t offset;
+    uint16_t length;
+} ConfigStoreRange;
+
+// Keeps a config struct in two flash sectors as a journal: each store
+// appends a record of only the byte ranges that changed since the last one,
+// so changing a field costs a few bytes of flash instead of an erase. The
+// first record of a sector is the whole config; once the sector is full the
+// config is written to the other one, erasing it, and the old sector stays
+// as it was until the next switch.
+// Every record has a CRC. Loading replays the newest sector up to the first
+// bad record, so a store cut by a reset is either all there or not at all.
+class ConfigStore {
+    public:
+        // Since begin.
+        uint32_t erases;
+        uint32_t records;
+        uint32_t bytesWritten;
+
+        ConfigStore();
+        void begin(ConfigStoreFlash *flash, uint16_t version, uint16_t size);
+
+        // Reads the stored config into `data`. Returns false if there is none
+        // of this version and size, `data` is then left untouched.
+        bool load(uint8_t *data);
+        // Writes what changed in `data` since the last load or store, nothing
+        // if it didn't change. Call load first.
+        bool store(const uint8_t *data);
+
+        // Of the sector in use.
+        uint32_t getSequence() const;
+        uint16_t getUsed() const;
+    private:
+        ConfigStoreFlash *flash;
+        uint16_t version;
+        uint16_t size;
+        uint8_t loaded;
+        // Sector in use.
+        uint8_t sector;
+        uint32_t sequence;
+        // Next record, from the start of the sector.
+        uint16_t writeOffset;
+        // As last stored.
+        uint8_t stored[CONFIG_STORE_MAX_SIZE];
+
+        bool isUsable();
+        bool readHeader(uint8_t sector, ConfigStoreHeader *header);
+        uint16_t replay(uint8_t sector, bool *complete);
+        bool checkRecord(uint32_t address, const ConfigStoreRecord *record, bool first);
+        bool nextRange(const uint8_t *data, uint16_t from, uint16_t *start, uint16_t *end) const;
+        uint16_t measure(const uint8_t *data, bool whole, uint16_t *ranges) const;
+        bool writeRecord(uint32_t address, const uint8_t *data, bool whole, uint16_t length, uint16_t ranges);
+        bool switchSector(const uint8_t *data);
+};
+
+uint32_t ConfigStoreCrc(uint32_t crc, const uint8_t *data, uint32_t size);
+
+#endif
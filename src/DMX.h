@@ -5,3 +5,5 @@
 #define DMX_MAX_TRANSMIT_INTERVAL_MS 1500
 #define DMX_BREAK_LOW_INTERVAL_MICROS 92
 #define DMX_BREAK_HIGH_INTERVAL_MICROS 12
+// 250 kbaud, 8N2.
+#define DMX_SLOT_MICROS 44
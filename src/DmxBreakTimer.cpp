@@ -0,0 +1,48 @@
+#include <DmxBreakTimer.h>
+
+DmxBreakTimer::DmxBreakTimer() {
+    breakMicros = DMX_BREAK_LOW_INTERVAL_MICROS;
+    markAfterBreakMicros = DMX_BREAK_HIGH_INTERVAL_MICROS;
+    hal = NULL;
+    state = DmxBreakState::Idle;
+}
+
+void DmxBreakTimer::begin(DmxLineHal *hal) {
+    this->hal = hal;
+    state = DmxBreakState::Idle;
+}
+
+bool DmxBreakTimer::start() {
+    if (state != DmxBreakState::Idle) {
+        return false;
+    }
+
+    state = DmxBreakState::Break;
+    hal->setBreak(true);
+    hal->startTimer(breakMicros);
+
+    return true;
+}
+
+void DmxBreakTimer::onTimer() {
+    switch (state) {
+        case DmxBreakState::Break: {
+            state = DmxBreakState::MarkAfterBreak;
+            hal->setBreak(false);
+            hal->startTimer(markAfterBreakMicros);
+            break;
+        }
+        case DmxBreakState::MarkAfterBreak: {
+            state = DmxBreakState::Idle;
+            hal->signalDone();
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+DmxBreakState DmxBreakTimer::getState() const {
+    return state;
+}
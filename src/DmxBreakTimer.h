@@ -0,0 +1,46 @@
+#ifndef DMX_BREAK_TIMER_H
+#define DMX_BREAK_TIMER_H
+
+#include <Arduino.h>
+#include <DMX.h>
+
+enum class DmxBreakState : uint8_t {
+    Idle = 0,
+    Break = 1,
+    MarkAfterBreak = 2
+};
+
+// What the break state machine needs from the hardware (or from a simulation).
+class DmxLineHal {
+    public:
+        virtual ~DmxLineHal() {}
+        // Holds the line low for the break, or releases it to mark.
+        virtual void setBreak(bool active) = 0;
+        // Must call DmxBreakTimer::onTimer once, no sooner than `micros` from now.
+        virtual void startTimer(uint32_t micros) = 0;
+        // Break and MAB are over, the slots can be sent.
+        virtual void signalDone() = 0;
+};
+
+// Generates break and mark after break from timer callbacks instead of busy
+// waiting. Each interval is timed from the line change that starts it, so a
+// late callback can only make it longer, never shorter than the minimum.
+class DmxBreakTimer {
+    public:
+        uint32_t breakMicros;
+        uint32_t markAfterBreakMicros;
+
+        DmxBreakTimer();
+        void begin(DmxLineHal *hal);
+
+        // Starts a break. Returns false while the previous one is still running.
+        bool start();
+        // Called by the HAL when the timer expires.
+        void onTimer();
+        DmxBreakState getState() const;
+    private:
+        DmxLineHal *hal;
+        volatile DmxBreakState state;
+};
+
+#endif
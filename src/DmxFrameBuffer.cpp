@@ -0,0 +1,125 @@
+#include <DmxFrameBuffer.h>
+
+DmxFrameBuffer::DmxFrameBuffer() {
+    memset(buffers, 0, sizeof(buffers));
+
+    writeIndex = 0;
+    middle.store(1, std::memory_order_relaxed);
+    readIndex = 2;
+
+    latestIndex = readIndex;
+    writeSize = 0;
+    hasStagedData = 0;
+    carriedBytes = 0;
+    highestSize = 0;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        staleSlots[i] = 0;
+        frameSizes[i] = 0;
+    }
+}
+
+uint8_t* DmxFrameBuffer::beginWrite(uint8_t startCode, uint16_t size) {
+    uint8_t *writeBuffer = buffers[writeIndex];
+
+    if (size > DMX_MAX_CHANNELS) {
+        size = DMX_MAX_CHANNELS;
+    }
+
+    // Slots past `size` are not touched by this packet, so they must hold the
+    // latest frame values. Only the part that went stale needs to be copied.
+    // The latest frame is either in the middle or being read, so it is only
+    // read here, never written.
+    if (staleSlots[writeIndex] > size) {
+        uint16_t count = staleSlots[writeIndex] - size;
+        memcpy(&writeBuffer[1 + size], &buffers[latestIndex][1 + size], count);
+        carriedBytes += count;
+    }
+
+    staleSlots[writeIndex] = 0;
+    writeSize = size;
+    writeBuffer[0] = startCode;
+
+    return &writeBuffer[1];
+}
+
+void DmxFrameBuffer::commitWrite() {
+    stageWrite();
+    publish();
+}
+
+void DmxFrameBuffer::stageWrite() {
+    for (uint8_t i = 0; i < 3; i++) {
+        if (i != writeIndex && staleSlots[i] < writeSize) {
+            staleSlots[i] = writeSize;
+        }
+    }
+
+    if (writeSize > highestSize) {
+        highestSize = writeSize;
+    }
+
+    frameSizes[writeIndex] = highestSize;
+    latestIndex = writeIndex;
+    hasStagedData = 1;
+}
+
+bool DmxFrameBuffer::publish() {
+    if (!hasStagedData) {
+        return false;
+    }
+
+    hasStagedData = 0;
+
+    // Release publishes the frame contents, acquire hands us a buffer the
+    // reader is done with.
+    uint8_t previous = middle.exchange(writeIndex | FRESH_FLAG, std::memory_order_acq_rel);
+    writeIndex = previous & INDEX_MASK;
+
+    return true;
+}
+
+void DmxFrameBuffer::abortWrite() {
+    // The back buffer may now hold partial data, fall back to the latest frame.
+    // When that frame is the staged one itself there is nothing to restore
+    // from, so callers should validate the size before beginWrite.
+    if (latestIndex != writeIndex) {
+        memcpy(buffers[writeIndex], buffers[latestIndex], DMX_FRAME_SIZE);
+        carriedBytes += DMX_FRAME_SIZE;
+    }
+
+    staleSlots[writeIndex] = 0;
+}
+
+const uint8_t* DmxFrameBuffer::getLatestFrame() const {
+    // The reader never writes, so the latest frame can be read from here
+    // even once it was handed over.
+    return &buffers[latestIndex][1];
+}
+
+uint16_t DmxFrameBuffer::getLatestSize() const {
+    return frameSizes[latestIndex];
+}
+
+bool DmxFrameBuffer::swap() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH_FLAG)) {
+        return false;
+    }
+
+    uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+    readIndex = previous & INDEX_MASK;
+
+    return true;
+}
+
+const uint8_t* DmxFrameBuffer::getReadBuffer() const {
+    return buffers[readIndex];
+}
+
+uint16_t DmxFrameBuffer::getReadSize() const {
+    return frameSizes[readIndex];
+}
+
+uint32_t DmxFrameBuffer::getCarriedBytes() const {
+    return carriedBytes;
+}
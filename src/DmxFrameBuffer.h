@@ -0,0 +1,79 @@
+#ifndef DMX_FRAME_BUFFER_H
+#define DMX_FRAME_BUFFER_H
+
+#include <Arduino.h>
+#include <DMX.h>
+#include <atomic>
+
+// Start code + slots
+#define DMX_FRAME_SIZE (DMX_MAX_CHANNELS + 1)
+
+// Lock-free triple buffered DMX frame storage, with one writer (network side)
+// and one reader (DMX output task).
+// The writer fills its back buffer and publishes it with commitWrite; the
+// reader picks up the latest published frame with swap. Neither side ever
+// waits for the other.
+// Incoming slot data is written straight into the back buffer; when a packet
+// carries less than a full frame, only the slots that changed since the back
+// buffer was last written are carried forward from the latest frame.
+class DmxFrameBuffer {
+    public:
+        DmxFrameBuffer();
+
+        // Writer side.
+        // Prepares the back buffer for `size` slots and returns where slot 1
+        // must be written. Must be followed by commitWrite, stageWrite or abortWrite.
+        uint8_t* beginWrite(uint8_t startCode, uint16_t size);
+        // stageWrite + publish.
+        void commitWrite();
+        // Keeps the written data in the back buffer without handing it to the
+        // reader; later writes build on top of it (ArtSync).
+        void stageWrite();
+        // Hands the staged frame to the reader. Returns false, doing nothing,
+        // when nothing is staged.
+        bool publish();
+        // Drops a write that could not be completed (e.g. short datagram).
+        void abortWrite();
+        // Slot 1 of the latest staged or published frame, and its slot count
+        // high-water mark. Valid until the next beginWrite.
+        const uint8_t* getLatestFrame() const;
+        uint16_t getLatestSize() const;
+
+        // Reader side.
+        // Makes the latest committed frame the read buffer.
+        // Returns false when there is nothing new.
+        bool swap();
+        const uint8_t* getReadBuffer() const;
+        // Highest slot count written up to the read frame. Slots past it were
+        // never received and hold zero.
+        uint16_t getReadSize() const;
+
+        // Bytes copied by the carry forward logic since construction.
+        uint32_t getCarriedBytes() const;
+    private:
+        static constexpr uint8_t INDEX_MASK {0x3};
+        static constexpr uint8_t FRESH_FLAG {0x4};
+
+        uint8_t buffers[3][DMX_FRAME_SIZE];
+
+        // Index of the buffer between writer and reader, plus FRESH_FLAG
+        // when it holds a frame the reader did not take yet.
+        std::atomic<uint8_t> middle;
+
+        // Owned by the writer.
+        uint8_t writeIndex;
+        uint8_t latestIndex;
+        uint16_t writeSize;
+        uint8_t hasStagedData;
+        // Slots of each buffer that may be older than the latest frame.
+        uint16_t staleSlots[3];
+        // Slot count high-water mark, and its value when each buffer was staged.
+        uint16_t highestSize;
+        uint16_t frameSizes[3];
+        uint32_t carriedBytes;
+
+        // Owned by the reader.
+        uint8_t readIndex;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include <DmxInputDecoder.h>
+
+DmxInputDecoder::DmxInputDecoder() {
+    breakByte = DMX_INPUT_BREAK_BYTE;
+    memset(&stats, 0, sizeof(stats));
+    frameBuffer = NULL;
+    state = State::WaitBreak;
+    frameLength = 0;
+}
+
+void DmxInputDecoder::begin(DmxFrameBuffer *frameBuffer) {
+    this->frameBuffer = frameBuffer;
+}
+
+void DmxInputDecoder::onBreak() {
+    if (state == State::Overrun) {
+        stats.overruns++;
+    } else if (state == State::Frame) {
+        endFrame();
+    }
+
+    state = State::Frame;
+    frameLength = 0;
+}
+
+void DmxInputDecoder::endFrame() {
+    uint16_t length = frameLength;
+
+    if (breakByte && length > 0 && frame[length - 1] == 0) {
+        length--;
+    }
+
+    if (length == 0) {
+        stats.emptyFrames++;
+        return;
+    }
+
+    if (length > DMX_FRAME_SIZE) {
+        stats.overruns++;
+        return;
+    }
+
+    if (frame[0] != 0) {
+        stats.nzsFrames++;
+        return;
+    }
+
+    memcpy(frameBuffer->beginWrite(0, length - 1), frame + 1, length - 1);
+    frameBuffer->commitWrite();
+    stats.frames++;
+}
+
+void DmxInputDecoder::onData(const uint8_t *data, uint16_t size) {
+    if (state != State::Frame) {
+        return;
+    }
+
+    if (frameLength + size > sizeof(frame)) {
+        state = State::Overrun;
+        return;
+    }
+
+    memcpy(frame + frameLength, data, size);
+    frameLength += size;
+}
+
+void DmxInputDecoder::onError() {
+    if (state != State::WaitBreak) {
+        stats.errors++;
+    }
+
+    state = State::WaitBreak;
+}
@@ -0,0 +1,63 @@
+#ifndef DMX_INPUT_DECODER_H
+#define DMX_INPUT_DECODER_H
+
+#include <Arduino.h>
+#include <DMX.h>
+#include <DmxFrameBuffer.h>
+
+// When 1 the UART hands the break over as a 0x00 byte (framing error) just
+// before reporting it, and that byte is dropped from the end of the frame.
+#ifndef DMX_INPUT_BREAK_BYTE
+#define DMX_INPUT_BREAK_BYTE 1
+#endif
+
+typedef struct {
+    // Null start code frames handed to the frame buffer.
+    uint32_t frames;
+    // Frames with another start code, ignored.
+    uint32_t nzsFrames;
+    // Break followed by another break, no start code.
+    uint32_t emptyFrames;
+    // More than DMX_MAX_CHANNELS slots between two breaks, dropped.
+    uint32_t overruns;
+    // Frames lost to UART errors (FIFO overflow, ...).
+    uint32_t errors;
+} DmxInputStats;
+
+// Rebuilds DMX frames from what a UART receives: a stream of bytes cut by
+// breaks. A frame is complete when the next break arrives; frames with a
+// null start code go to the frame buffer, as the writer side.
+// Bytes before the first break can't be placed in a frame and are ignored.
+class DmxInputDecoder {
+    public:
+        uint8_t breakByte;
+        DmxInputStats stats;
+
+        DmxInputDecoder();
+        void begin(DmxFrameBuffer *frameBuffer);
+
+        void onBreak();
+        void onData(const uint8_t *data, uint16_t size);
+        // Bytes were lost, the frame being received is dropped.
+        void onError();
+    private:
+        enum class State : uint8_t {
+            // Not synchronized or after an error, waiting for a break.
+            WaitBreak,
+            // Collecting start code + slots.
+            Frame,
+            // Frame too long, waiting for the next break.
+            Overrun
+        };
+
+        DmxFrameBuffer *frameBuffer;
+        State state;
+        // Start code + slots received since the last break, and room for
+        // the break byte of a full frame.
+        uint8_t frame[DMX_FRAME_SIZE + 1];
+        uint16_t frameLength;
+
+        void endFrame();
+};
+
+#endif
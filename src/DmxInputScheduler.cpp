@@ -0,0 +1,66 @@
+#include <DmxInputScheduler.h>
+
+DmxInputScheduler::DmxInputScheduler() {
+    minIntervalMs = DMX_INPUT_MIN_INTERVAL_MS;
+    keepAliveMs = DMX_INPUT_KEEP_ALIVE_MS;
+    memset(&stats, 0, sizeof(stats));
+    frameBuffer = NULL;
+    changePending = 0;
+    hasReceived = 0;
+    lastReceive = 0;
+    lastTransmit = 0;
+    lastSentLength = 0;
+}
+
+void DmxInputScheduler::begin(DmxFrameBuffer *frameBuffer) {
+    this->frameBuffer = frameBuffer;
+}
+
+DmxFrameKind DmxInputScheduler::next(unsigned long now) {
+    if (frameBuffer->swap()) {
+        uint16_t length = frameBuffer->getReadSize();
+        bool changed = length != lastSentLength || memcmp(lastSent, frameBuffer->getReadBuffer() + 1, length) != 0;
+
+        if (changePending) {
+            // The frame waiting for the rate limit is replaced by this one.
+            stats.coalesced++;
+        }
+
+        if (!changed) {
+            stats.unchanged++;
+        }
+
+        changePending = changed;
+        hasReceived = 1;
+        lastReceive = now;
+    }
+
+    if (changePending && (lastSentLength == 0 || now - lastTransmit >= minIntervalMs)) {
+        lastSentLength = frameBuffer->getReadSize();
+        memcpy(lastSent, frameBuffer->getReadBuffer() + 1, lastSentLength);
+        lastTransmit = now;
+        changePending = 0;
+        stats.changesSent++;
+        return DmxFrameKind::Fresh;
+    }
+
+    if (lastSentLength && now - lastTransmit >= keepAliveMs && isReceiving(now)) {
+        lastTransmit = now;
+        stats.keepAlivesSent++;
+        return DmxFrameKind::KeepAlive;
+    }
+
+    return DmxFrameKind::None;
+}
+
+const uint8_t* DmxInputScheduler::getData() const {
+    return lastSent;
+}
+
+uint16_t DmxInputScheduler::getLength() const {
+    return lastSentLength;
+}
+
+bool DmxInputScheduler::isReceiving(unsigned long now) const {
+    return hasReceived && now - lastReceive < DMX_INPUT_LOSS_TIMEOUT_MS;
+}
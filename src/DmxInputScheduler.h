@@ -0,0 +1,69 @@
+#ifndef DMX_INPUT_SCHEDULER_H
+#define DMX_INPUT_SCHEDULER_H
+
+#include <Arduino.h>
+#include <DMX.h>
+#include <DmxFrameBuffer.h>
+#include <DmxOutputScheduler.h>
+
+// Changed frames are sent at most this often; changes in between are
+// coalesced into the next one. 25 ms keeps a port at 40 packets/s.
+#ifndef DMX_INPUT_MIN_INTERVAL_MS
+#define DMX_INPUT_MIN_INTERVAL_MS 25
+#endif
+
+// Unchanged data is repeated this often (ArtDmx keep alive, 800 to 1000 ms).
+#ifndef DMX_INPUT_KEEP_ALIVE_MS
+#define DMX_INPUT_KEEP_ALIVE_MS 900
+#endif
+
+// Without DMX frames for this long the input is considered lost and the
+// keep alive stops.
+#ifndef DMX_INPUT_LOSS_TIMEOUT_MS
+#define DMX_INPUT_LOSS_TIMEOUT_MS DMX_MAX_TRANSMIT_INTERVAL_MS
+#endif
+
+typedef struct {
+    // Frames equal to the last one sent.
+    uint32_t unchanged;
+    // Changed frames replaced by a newer one before they could be sent.
+    uint32_t coalesced;
+    uint32_t changesSent;
+    uint32_t keepAlivesSent;
+} DmxInputSchedulerStats;
+
+// Read side of one input port: decides when the DMX received goes out as
+// ArtDmx. Frames are only sent when they differ from the last one sent, no
+// more often than minIntervalMs, and repeated every keepAliveMs while the
+// input is alive.
+class DmxInputScheduler {
+    public:
+        uint16_t minIntervalMs;
+        uint16_t keepAliveMs;
+        DmxInputSchedulerStats stats;
+
+        DmxInputScheduler();
+        void begin(DmxFrameBuffer *frameBuffer);
+
+        // Picks up new frames and returns what must be sent now: Fresh for
+        // changed data, KeepAlive, or None.
+        DmxFrameKind next(unsigned long now);
+        // Slots of the frame returned by next.
+        const uint8_t* getData() const;
+        uint16_t getLength() const;
+
+        // DMX frames arrived within DMX_INPUT_LOSS_TIMEOUT_MS.
+        bool isReceiving(unsigned long now) const;
+    private:
+        DmxFrameBuffer *frameBuffer;
+        // The read buffer holds a frame that differs from lastSent.
+        uint8_t changePending;
+        uint8_t hasReceived;
+        unsigned long lastReceive;
+        unsigned long lastTransmit;
+        uint16_t lastSentLength;
+        // Slots of the last frame sent.
+        uint8_t lastSent[DMX_MAX_CHANNELS];
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include <DmxInterpolator.h>
+
+// Fractions are in 1/256 of the way to the target.
+#define DMX_INTERPOLATOR_ONE 256
+
+#define DMX_INTERPOLATOR_EVEN_LANES 0x00FF00FF
+#define DMX_INTERPOLATOR_ODD_LANES 0xFF00FF00
+
+DmxInterpolator::DmxInterpolator() {
+    enabled = 0;
+    memset(from, 0, sizeof(from));
+    memset(to, 0, sizeof(to));
+    memset(output, 0, sizeof(output));
+    length = 0;
+    reset();
+}
+
+void DmxInterpolator::reset() {
+    memset(excluded, 0, sizeof(excluded));
+    moving = 0;
+    hasTarget = 0;
+    interval = 0;
+    start = 0;
+    lastTarget = 0;
+    lastRender = 0;
+}
+
+void DmxInterpolator::setExcluded(uint16_t channel, bool excluded) {
+    if (channel < DMX_MAX_CHANNELS) {
+        ((uint8_t*) this->excluded)[channel] = excluded ? 0xFF : 0x00;
+    }
+}
+
+bool DmxInterpolator::isExcluded(uint16_t channel) const {
+    return channel < DMX_MAX_CHANNELS && ((const uint8_t*) excluded)[channel];
+}
+
+void DmxInterpolator::jumpTo(const uint8_t *frame, uint16_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    if (length > DMX_FRAME_SIZE) {
+        length = DMX_FRAME_SIZE;
+    }
+
+    this->length = length;
+    ((uint8_t*) output)[3] = frame[0];
+    memcpy(to, frame + 1, length - 1);
+    memcpy(from, to, length - 1);
+    memcpy(&output[1], to, length - 1);
+    moving = 0;
+    hasTarget = 0;
+}
+
+void DmxInterpolator::setTarget(const uint8_t *frame, uint16_t length, unsigned long now) {
+    unsigned long gap = now - lastTarget;
+    bool inFade = hasTarget && gap <= DMX_INTERPOLATION_MAX_INTERVAL_MS;
+
+    if (!inFade || length == 0 || length > this->length) {
+        // Slots the output never had would fade in from stale values.
+        jumpTo(frame, length);
+        lastTarget = now;
+        hasTarget = 1;
+        return;
+    }
+
+    lastTarget = now;
+
+    // Smoothed, so one late packet doesn't stretch the next fade.
+    interval = interval ? (interval * 3 + gap) / 4 : gap;
+
+    this->length = length;
+    ((uint8_t*) output)[3] = frame[0];
+    memcpy(from, &output[1], length - 1);
+    memcpy(to, frame + 1, length - 1);
+    moving = interval > 0;
+
+    // The fade starts when the current output was shown, at most a frame
+    // time ago, so the frame sent now is already a step of it rather than a
+    // repeat.
+    unsigned long frameMillis = (length * DMX_SLOT_MICROS + DMX_BREAK_LOW_INTERVAL_MICROS + DMX_BREAK_HIGH_INTERVAL_MICROS) / 1000;
+    unsigned long lead = now - lastRender;
+
+    if (lead > frameMillis) {
+        lead = frameMillis;
+    }
+
+    start = now - (lead < interval ? lead : interval);
+
+    if (!moving) {
+        memcpy(&output[1], to, length - 1);
+    }
+}
+
+void DmxInterpolator::blend(uint32_t fraction) {
+    uint32_t remaining = DMX_INTERPOLATOR_ONE - fraction;
+    uint16_t words = (length - 1 + 3) / 4;
+
+    for (uint16_t i = 0; i < words; i++) {
+        uint32_t a = from[i];
+        uint32_t b = to[i];
+
+        // Each 16 bit lane holds at most 255 * 256, no carry into the next.
+        uint32_t even = (((a & DMX_INTERPOLATOR_EVEN_LANES) * remaining + (b & DMX_INTERPOLATOR_EVEN_LANES) * fraction) >> 8) & DMX_INTERPOLATOR_EVEN_LANES;
+        uint32_t odd = (((a >> 8) & DMX_INTERPOLATOR_EVEN_LANES) * remaining + ((b >> 8) & DMX_INTERPOLATOR_EVEN_LANES) * fraction) & DMX_INTERPOLATOR_ODD_LANES;
+
+        output[1 + i] = ((even | odd) & ~excluded[i]) | (b & excluded[i]);
+    }
+}
+
+bool DmxInterpolator::render(unsigned long now) {
+    lastRender = now;
+
+    if (!moving) {
+        return false;
+    }
+
+    unsigned long elapsed = now - start;
+
+    if (elapsed >= interval) {
+        memcpy(&output[1], to, length - 1);
+        moving = 0;
+        return false;
+    }
+
+    blend(elapsed * DMX_INTERPOLATOR_ONE / interval);
+    return true;
+}
+
+bool DmxInterpolator::isMoving() const {
+    return moving;
+}
+
+const uint8_t* DmxInterpolator::getFrame() const {
+    return ((const uint8_t*) output) + 3;
+}
+
+uint16_t DmxInterpolator::getInterval() const {
+    return interval;
+}
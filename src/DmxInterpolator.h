@@ -0,0 +1,71 @@
+#ifndef DMX_INTERPOLATOR_H
+#define DMX_INTERPOLATOR_H
+
+#include <Arduino.h>
+#include <DMX.h>
+#include <DmxFrameBuffer.h>
+
+// Frames further apart than this are not part of a fade: the output jumps
+// to them and they don't count in the measured interval.
+#ifndef DMX_INTERPOLATION_MAX_INTERVAL_MS
+#define DMX_INTERPOLATION_MAX_INTERVAL_MS 100
+#endif
+
+// Smoothing stage of one output port, on the read side of its frame buffer.
+// Each received frame becomes the target the output moves to, linearly,
+// over the average time between received frames, so the output reaches it
+// about when the next one comes in. It starts from the current output rather
+// than from the previous frame, so a frame arriving early bends the fade
+// instead of jumping. Excluded channels (gobos, modes, ...) jump straight to
+// the target.
+// Blends 4 slots per 32 bit word, 2 per 16 bit lane.
+//
+// Used by the output task; `enabled` and the exclusions may be changed from
+// another task, the output then picks them up within a frame.
+class DmxInterpolator {
+    public:
+        uint8_t enabled;
+
+        DmxInterpolator();
+
+        // No channel excluded, nothing measured.
+        void reset();
+        void setExcluded(uint16_t channel, bool excluded);
+        bool isExcluded(uint16_t channel) const;
+
+        // Output jumps to `frame` (start code + `length` - 1 slots), the next
+        // target is not faded to.
+        void jumpTo(const uint8_t *frame, uint16_t length);
+        // New received frame, the output starts moving to it.
+        void setTarget(const uint8_t *frame, uint16_t length, unsigned long now);
+        // Computes the output at `now`. Returns false once it reached the target.
+        bool render(unsigned long now);
+        bool isMoving() const;
+
+        // Start code + slots of the last render.
+        const uint8_t* getFrame() const;
+        // Average time between received frames, 0 until measured.
+        uint16_t getInterval() const;
+    private:
+        static constexpr uint16_t WORDS {DMX_MAX_CHANNELS / 4};
+
+        // Slots only, so they are word aligned.
+        uint32_t from[WORDS];
+        uint32_t to[WORDS];
+        // 0xFF in the byte of each excluded slot.
+        uint32_t excluded[WORDS];
+        // 3 bytes of padding, the start code, then word aligned slots.
+        uint32_t output[WORDS + 1];
+
+        uint16_t length;
+        uint8_t moving;
+        unsigned long start;
+        unsigned long lastTarget;
+        unsigned long lastRender;
+        uint8_t hasTarget;
+        uint16_t interval;
+
+        void blend(uint32_t fraction);
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include <DmxNzsQueue.h>
+
+DmxNzsQueue::DmxNzsQueue() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    dropped = 0;
+}
+
+bool DmxNzsQueue::push(uint8_t startCode, const uint8_t *slots, uint16_t size) {
+    uint32_t writeCount = tail.load(std::memory_order_relaxed);
+
+    if (writeCount - head.load(std::memory_order_acquire) == DMX_NZS_QUEUE_SIZE) {
+        dropped++;
+        return false;
+    }
+
+    if (size > DMX_MAX_CHANNELS) {
+        size = DMX_MAX_CHANNELS;
+    }
+
+    DmxNzsFrame *frame = &frames[writeCount % DMX_NZS_QUEUE_SIZE];
+    frame->data[0] = startCode;
+    memcpy(frame->data + 1, slots, size);
+    frame->length = size + 1;
+
+    // Frame content before the reader can see it.
+    tail.store(writeCount + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t DmxNzsQueue::getDropped() const {
+    return dropped;
+}
+
+bool DmxNzsQueue::isEmpty() const {
+    return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+}
+
+const DmxNzsFrame* DmxNzsQueue::front() const {
+    if (isEmpty()) {
+        return NULL;
+    }
+
+    return &frames[head.load(std::memory_order_relaxed) % DMX_NZS_QUEUE_SIZE];
+}
+
+void DmxNzsQueue::pop() {
+    if (isEmpty()) {
+        return;
+    }
+
+    // Done reading the frame before the writer may reuse it.
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,49 @@
+#ifndef DMX_NZS_QUEUE_H
+#define DMX_NZS_QUEUE_H
+
+#include <Arduino.h>
+#include <DMX.h>
+#include <DmxFrameBuffer.h>
+#include <atomic>
+
+// Frames with a non zero start code waiting for the output of one port.
+#ifndef DMX_NZS_QUEUE_SIZE
+#define DMX_NZS_QUEUE_SIZE 4
+#endif
+
+static_assert((DMX_NZS_QUEUE_SIZE & (DMX_NZS_QUEUE_SIZE - 1)) == 0, "The counters wrap cleanly only for a power of two");
+
+typedef struct {
+    // Start code + slots.
+    uint8_t data[DMX_FRAME_SIZE];
+    uint16_t length;
+} DmxNzsFrame;
+
+// Lock-free FIFO of non zero start code frames (text, system information,
+// vendor specific), one writer (network side) and one reader (DMX output
+// task). Unlike null start code data these are messages, not state: every
+// frame is sent once, in order, and a frame that finds the queue full is
+// dropped rather than replacing an older one.
+class DmxNzsQueue {
+    public:
+        DmxNzsQueue();
+
+        // Writer side. Returns false when the queue is full.
+        bool push(uint8_t startCode, const uint8_t *slots, uint16_t size);
+        // Frames refused by push.
+        uint32_t getDropped() const;
+
+        // Reader side.
+        bool isEmpty() const;
+        // Oldest frame, stays valid until pop. NULL when empty.
+        const DmxNzsFrame* front() const;
+        void pop();
+    private:
+        DmxNzsFrame frames[DMX_NZS_QUEUE_SIZE];
+        // Free running counters, the index is the counter modulo the size.
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+        uint32_t dropped;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <DmxOutputScheduler.h>
+
+DmxOutputScheduler::DmxOutputScheduler() {
+    adaptive = DMX_ADAPTIVE_REFRESH;
+    nscMinRefreshHz = DMX_NSC_MIN_REFRESH_HZ;
+    frameBuffer = NULL;
+    nzsQueue = NULL;
+    interpolator = NULL;
+    interpolating = 0;
+    lastTransmit = 0;
+    frameLength = 0;
+    lastSentLength = 0;
+    hasSent = 0;
+    nscPending = 0;
+    nzsFrame = NULL;
+    lastKind = DmxFrameKind::None;
+    unchangedSkipped = 0;
+}
+
+void DmxOutputScheduler::begin(DmxFrameBuffer *frameBuffer, DmxNzsQueue *nzsQueue, DmxInterpolator *interpolator) {
+    this->frameBuffer = frameBuffer;
+    this->nzsQueue = nzsQueue;
+    this->interpolator = interpolator;
+    lastTransmit = millis();
+}
+
+DmxFrameKind DmxOutputScheduler::next(unsigned long now, uint16_t channelCount) {
+    if (nzsFrame) {
+        nzsQueue->pop();
+        nzsFrame = NULL;
+    }
+
+    if (frameBuffer->swap()) {
+        nscPending = 1;
+    }
+
+    uint16_t slots = channelCount;
+
+    if (adaptive) {
+        slots = frameBuffer->getReadSize();
+
+        if (slots < DMX_MIN_CHANNELS) {
+            slots = DMX_MIN_CHANNELS;
+        }
+
+        if (slots > channelCount) {
+            slots = channelCount;
+        }
+
+        if (nscPending && hasSent && slots + 1 == lastSentLength && memcmp(lastSent, frameBuffer->getReadBuffer(), lastSentLength) == 0) {
+            unchangedSkipped++;
+            nscPending = 0;
+        }
+    }
+
+    const DmxNzsFrame *nzsNext = nzsQueue ? nzsQueue->front() : NULL;
+    bool nzsWaiting = nzsNext != NULL;
+    bool nscDue = now - lastTransmit > DMX_MAX_TRANSMIT_INTERVAL_MS;
+
+    if (nzsWaiting && nscMinRefreshHz) {
+        // The NSC frame goes first when it would be late by the end of the NZS one.
+        unsigned long nzsMillis = (nzsNext->length * DMX_SLOT_MICROS + DMX_BREAK_LOW_INTERVAL_MICROS + DMX_BREAK_HIGH_INTERVAL_MICROS + 999) / 1000;
+        nscDue = now - lastTransmit + nzsMillis >= 1000UL / nscMinRefreshHz;
+    }
+
+    // A fresh NSC frame waits for one NZS frame at most, and none once the
+    // minimum refresh is at stake.
+    if (nzsWaiting && !nscDue && !(nscPending && lastKind == DmxFrameKind::NonZeroStartCode)) {
+        nzsFrame = nzsNext;
+        frameLength = nzsFrame->length;
+        lastKind = DmxFrameKind::NonZeroStartCode;
+        return lastKind;
+    }
+
+    bool smoothing = interpolator && interpolator->enabled;
+    DmxFrameKind kind;
+
+    if (nscPending) {
+        kind = DmxFrameKind::Fresh;
+    } else if (smoothing && interpolating && interpolator->isMoving()) {
+        kind = DmxFrameKind::Interpolated;
+    } else if (nscDue) {
+        kind = DmxFrameKind::KeepAlive;
+    } else {
+        return DmxFrameKind::None;
+    }
+
+    if (smoothing && !interpolating) {
+        // Just enabled, start from what the output shows now.
+        interpolator->jumpTo(frameBuffer->getReadBuffer(), slots + 1);
+    }
+
+    if (smoothing && kind == DmxFrameKind::Fresh) {
+        interpolator->setTarget(frameBuffer->getReadBuffer(), slots + 1, now);
+    }
+
+    interpolating = smoothing;
+
+    if (interpolating) {
+        interpolator->render(now);
+    }
+
+    frameLength = slots + 1;
+    lastSentLength = frameLength;
+    lastTransmit = now;
+    lastKind = kind;
+    nscPending = 0;
+    hasSent = 1;
+
+    if (adaptive && kind == DmxFrameKind::Fresh) {
+        memcpy(lastSent, frameBuffer->getReadBuffer(), frameLength);
+    }
+
+    return kind;
+}
+
+const uint8_t* DmxOutputScheduler::getFrame() const {
+    if (nzsFrame) {
+        return nzsFrame->data;
+    }
+
+    if (interpolating) {
+        return interpolator->getFrame();
+    }
+
+    return frameBuffer->getReadBuffer();
+}
+
+uint16_t DmxOutputScheduler::getFrameLength() const {
+    return frameLength;
+}
+
+uint32_t DmxOutputScheduler::getUnchangedSkipped() const {
+    return unchangedSkipped;
+}
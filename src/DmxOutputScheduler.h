@@ -0,0 +1,82 @@
+#ifndef DMX_OUTPUT_SCHEDULER_H
+#define DMX_OUTPUT_SCHEDULER_H
+
+#include <Arduino.h>
+#include <DMX.h>
+#include <DmxFrameBuffer.h>
+#include <DmxInterpolator.h>
+#include <DmxNzsQueue.h>
+
+// When 1, frames are cut after the highest slot received (at least
+// DMX_MIN_CHANNELS) instead of always carrying the configured channel count,
+// and frames equal to the last one sent wait for the keep alive.
+#ifndef DMX_ADAPTIVE_REFRESH
+#define DMX_ADAPTIVE_REFRESH 0
+#endif
+
+// While non zero start code frames are waiting, null start code frames still
+// go out at least this often.
+#ifndef DMX_NSC_MIN_REFRESH_HZ
+#define DMX_NSC_MIN_REFRESH_HZ 20
+#endif
+
+enum class DmxFrameKind : uint8_t {
+    None = 0,
+    // New data from the network.
+    Fresh = 1,
+    // Repeat of the last frame after DMX_MAX_TRANSMIT_INTERVAL_MS, or to
+    // hold the NSC minimum refresh rate.
+    KeepAlive = 2,
+    // Frame from the NZS queue, start code other than 0.
+    NonZeroStartCode = 3,
+    // Step of the interpolator between two fresh frames.
+    Interpolated = 4
+};
+
+// Read side of one output port: decides when the next frame goes out and how
+// long it is. Owned by the output task.
+// NZS frames are interleaved with the null start code (NSC) stream: one goes
+// out whenever the NSC side has nothing new, or alternating with it, and never
+// when that would hold NSC frames back longer than nscMinRefreshHz allows.
+// With an enabled interpolator, NSC frames come from it and go out back to
+// back while it moves towards the latest fresh frame.
+class DmxOutputScheduler {
+    public:
+        uint8_t adaptive;
+        uint8_t nscMinRefreshHz;
+
+        DmxOutputScheduler();
+        // `nzsQueue` and `interpolator` are optional.
+        void begin(DmxFrameBuffer *frameBuffer, DmxNzsQueue *nzsQueue = NULL, DmxInterpolator *interpolator = NULL);
+
+        // Picks up new data and returns what must be sent now, if anything.
+        DmxFrameKind next(unsigned long now, uint16_t channelCount);
+        // Start code + slots of the frame returned by next.
+        const uint8_t* getFrame() const;
+        uint16_t getFrameLength() const;
+
+        // Fresh frames not sent because nothing changed.
+        uint32_t getUnchangedSkipped() const;
+    private:
+        DmxFrameBuffer *frameBuffer;
+        DmxNzsQueue *nzsQueue;
+        DmxInterpolator *interpolator;
+        // NSC frames come from the interpolator.
+        uint8_t interpolating;
+        // Last NSC frame sent.
+        unsigned long lastTransmit;
+        // A fresh NSC frame is in the read buffer, not sent yet.
+        uint8_t nscPending;
+        // The NZS frame returned by the last next() call, popped on the next one.
+        const DmxNzsFrame *nzsFrame;
+        DmxFrameKind lastKind;
+        uint16_t frameLength;
+        // Length of the last NSC frame sent.
+        uint16_t lastSentLength;
+        uint8_t hasSent;
+        uint32_t unchangedSkipped;
+        // Copy of the last fresh frame sent, adaptive mode only.
+        uint8_t lastSent[DMX_FRAME_SIZE];
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include <DmxProcessor.h>
+
+// Table row of an unpatched slot, all 0.
+#define DMX_PROCESSOR_ZERO_TABLE ((uint8_t)DmxCurve::Count * 2)
+// Curve settings byte: the curve, and this flag when it follows the master.
+#define DMX_PROCESSOR_FOLLOWS_MASTER 0x80
+
+namespace {
+    // x^(1/5) by Newton's method, x in [0, 1]. Single return so it stays
+    // a C++11 constexpr.
+    constexpr double fifthRoot(double x, double y, int steps) {
+        return steps == 0 ? y : fifthRoot(x, (4 * y + x / (y * y * y * y)) / 5, steps - 1);
+    }
+
+    constexpr uint8_t curveLinear(int x) {
+        return x;
+    }
+
+    constexpr uint8_t curveGamma(int x) {
+        return (uint8_t)(255.0 * (x / 255.0) * (x / 255.0) * fifthRoot(x / 255.0, 1.0, 60) + 0.5);
+    }
+
+    constexpr uint8_t curveSquare(int x) {
+        return (x * x + 127) / 255;
+    }
+
+    constexpr uint8_t curveInverse(int x) {
+        return 255 - x;
+    }
+
+    constexpr uint8_t curveLimit(int x) {
+        return x > DMX_PROCESSOR_LIMIT_LEVEL ? DMX_PROCESSOR_LIMIT_LEVEL : x;
+    }
+}
+
+#define DMX_CURVE_4(f, n) f(n), f(n + 1), f(n + 2), f(n + 3)
+#define DMX_CURVE_16(f, n) DMX_CURVE_4(f, n), DMX_CURVE_4(f, n + 4), DMX_CURVE_4(f, n + 8), DMX_CURVE_4(f, n + 12)
+#define DMX_CURVE_64(f, n) DMX_CURVE_16(f, n), DMX_CURVE_16(f, n + 16), DMX_CURVE_16(f, n + 32), DMX_CURVE_16(f, n + 48)
+#define DMX_CURVE_256(f) { DMX_CURVE_64(f, 0), DMX_CURVE_64(f, 64), DMX_CURVE_64(f, 128), DMX_CURVE_64(f, 192) }
+
+// Same order as DmxCurve.
+static const uint8_t CURVES[(uint8_t)DmxCurve::Count][256] = {
+    DMX_CURVE_256(curveLinear),
+    DMX_CURVE_256(curveGamma),
+    DMX_CURVE_256(curveSquare),
+    DMX_CURVE_256(curveInverse),
+    DMX_CURVE_256(curveLimit)
+};
+
+DmxProcessor::DmxProcessor() {
+    memcpy(tables, CURVES, sizeof(CURVES));
+    memset(tables[DMX_PROCESSOR_ZERO_TABLE], 0, 256);
+    input[DMX_MAX_CHANNELS] = 0;
+    reset();
+}
+
+void DmxProcessor::reset() {
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i++) {
+        source[i] = i;
+        curve[i] = (uint8_t)DmxCurve::Linear | DMX_PROCESSOR_FOLLOWS_MASTER;
+    }
+
+    master = 255;
+    updateMasterTables();
+    updateLookup();
+}
+
+void DmxProcessor::setPatch(uint16_t output, uint16_t input) {
+    if (output >= DMX_MAX_CHANNELS) {
+        return;
+    }
+
+    source[output] = input < DMX_MAX_CHANNELS ? input : DMX_MAX_CHANNELS;
+    updateLookup();
+}
+
+void DmxProcessor::setCurve(uint16_t output, DmxCurve curve, bool followsMaster) {
+    if (output >= DMX_MAX_CHANNELS || curve >= DmxCurve::Count) {
+        return;
+    }
+
+    this->curve[output] = (uint8_t)curve | (followsMaster ? DMX_PROCESSOR_FOLLOWS_MASTER : 0);
+    updateLookup();
+}
+
+void DmxProcessor::setMaster(uint8_t level) {
+    if (level != master) {
+        master = level;
+        updateMasterTables();
+        updateLookup();
+    }
+}
+
+uint8_t DmxProcessor::getMaster() const {
+    return master;
+}
+
+bool DmxProcessor::isPassthrough() const {
+    return passthrough;
+}
+
+uint16_t DmxProcessor::getOutputLength(uint16_t size) const {
+    if (identityPatch) {
+        return size > DMX_MAX_CHANNELS ? DMX_MAX_CHANNELS : size;
+    }
+
+    return patchedLength;
+}
+
+uint16_t DmxProcessor::process(const uint8_t *data, uint16_t size, uint8_t *output) {
+    if (size > DMX_MAX_CHANNELS) {
+        size = DMX_MAX_CHANNELS;
+    }
+
+    if (passthrough) {
+        memcpy(output, data, size);
+        return size;
+    }
+
+    if (identityPatch) {
+        processSlots(data, size, output);
+        return size;
+    }
+
+    // Patched slots may read any channel, including ones not received.
+    memcpy(input, data, size);
+    memset(input + size, 0, DMX_MAX_CHANNELS - size);
+    processSlots(input, patchedLength, output);
+
+    return patchedLength;
+}
+
+const uint8_t* DmxProcessor::getCurveTable(DmxCurve curve) {
+    return CURVES[(uint8_t)curve];
+}
+
+void DmxProcessor::updateMasterTables() {
+    for (uint8_t c = 0; c < (uint8_t)DmxCurve::Count; c++) {
+        uint8_t *table = tables[(uint8_t)DmxCurve::Count + c];
+
+        for (uint16_t x = 0; x < 256; x++) {
+            table[x] = (CURVES[c][x] * master + 127) / 255;
+        }
+    }
+}
+
+// Settings to what the pass reads: the table of each slot, and the flags
+// that let process() skip work.
+void DmxProcessor::updateLookup() {
+    identityPatch = 1;
+    passthrough = 1;
+    patchedLength = 0;
+
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i++) {
+        uint8_t c = curve[i] & ~DMX_PROCESSOR_FOLLOWS_MASTER;
+        bool followsMaster = (curve[i] & DMX_PROCESSOR_FOLLOWS_MASTER) && master != 255;
+
+        if (source[i] == DMX_MAX_CHANNELS) {
+            lookup[i] = DMX_PROCESSOR_ZERO_TABLE;
+        } else {
+            lookup[i] = followsMaster ? (uint8_t)DmxCurve::Count + c : c;
+            patchedLength = i + 1;
+        }
+
+        if (source[i] != i) {
+            identityPatch = 0;
+        }
+
+        if (lookup[i] != (uint8_t)DmxCurve::Linear) {
+            passthrough = 0;
+        }
+    }
+
+    if (!identityPatch) {
+        passthrough = 0;
+    }
+}
+
+// One table lookup per slot, 4 slots assembled into a word per store.
+// Both the ESP32 and the hosts the tests run on are little endian.
+void DmxProcessor::processSlots(const uint8_t *data, uint16_t length, uint8_t *output) const {
+    const uint8_t *base = tables[0];
+    uint16_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        uint32_t word = (uint32_t)base[(lookup[i] << 8) | data[source[i]]]
+            | ((uint32_t)base[(lookup[i + 1] << 8) | data[source[i + 1]]] << 8)
+            | ((uint32_t)base[(lookup[i + 2] << 8) | data[source[i + 2]]] << 16)
+            | ((uint32_t)base[(lookup[i + 3] << 8) | data[source[i + 3]]] << 24);
+        memcpy(output + i, &word, sizeof(word));
+    }
+
+    for (; i < length; i++) {
+        output[i] = base[(lookup[i] << 8) | data[source[i]]];
+    }
+}
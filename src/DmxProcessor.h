@@ -0,0 +1,82 @@
+#ifndef DMX_PROCESSOR_H
+#define DMX_PROCESSOR_H
+
+#include <Arduino.h>
+#include <DMX.h>
+
+// Input channel of an output slot that is not patched, the slot stays at 0.
+#define DMX_PROCESSOR_UNPATCHED 0xFFFF
+
+// Highest output of DmxCurve::Limit, about 80%.
+#ifndef DMX_PROCESSOR_LIMIT_LEVEL
+#define DMX_PROCESSOR_LIMIT_LEVEL 204
+#endif
+
+enum class DmxCurve : uint8_t {
+    Linear = 0,
+    // Gamma 2.2, for LED dimmers.
+    Gamma = 1,
+    Square = 2,
+    // 255 - x.
+    Inverse = 3,
+    // Linear, clamped at DMX_PROCESSOR_LIMIT_LEVEL.
+    Limit = 4,
+    Count = 5
+};
+
+// Processing stage of one output port, between the received slots and the
+// frame buffer: output slot N takes its value from the patched input channel,
+// through the curve of slot N and the master fader, which every slot follows
+// until told otherwise. Curves are built at compile time and the master is
+// folded into a copy of them when it changes, so the pass is a table lookup
+// per slot, written out 4 slots at a time.
+//
+// Configured and used by the network loop only.
+class DmxProcessor {
+    public:
+        DmxProcessor();
+
+        // Back to 1:1 patch, linear curves, master at full.
+        void reset();
+
+        // Channels are 0 based. Out of range outputs are ignored, an out of
+        // range input (DMX_PROCESSOR_UNPATCHED) unpatches the output.
+        void setPatch(uint16_t output, uint16_t input);
+        void setCurve(uint16_t output, DmxCurve curve, bool followsMaster);
+        void setMaster(uint8_t level);
+        uint8_t getMaster() const;
+
+        // Nothing to do, the input can be copied as is.
+        bool isPassthrough() const;
+
+        // Output slots written by process for `size` received slots.
+        uint16_t getOutputLength(uint16_t size) const;
+        // Processes `size` received slots into `output`, which must hold
+        // getOutputLength(size) slots. Returns that length.
+        uint16_t process(const uint8_t *data, uint16_t size, uint8_t *output);
+
+        static const uint8_t* getCurveTable(DmxCurve curve);
+    private:
+        uint8_t master;
+        uint8_t identityPatch;
+        uint8_t passthrough;
+        // 1 + highest patched output slot.
+        uint16_t patchedLength;
+        // Input channel of each output slot, DMX_MAX_CHANNELS when unpatched.
+        uint16_t source[DMX_MAX_CHANNELS];
+        // DmxCurve of each output slot, with the follows master flag.
+        uint8_t curve[DMX_MAX_CHANNELS];
+        // Row of tables each output slot is looked up in.
+        uint8_t lookup[DMX_MAX_CHANNELS];
+        // Curves, the same followed by the master, and a row of zeros.
+        uint8_t tables[(uint8_t)DmxCurve::Count * 2 + 1][256];
+        // Received slots, zero padded, when the patch isn't 1:1. The extra
+        // slot is what unpatched outputs read.
+        uint8_t input[DMX_MAX_CHANNELS + 1];
+
+        void updateMasterTables();
+        void updateLookup();
+        void processSlots(const uint8_t *data, uint16_t length, uint8_t *output) const;
+};
+
+#endif
@@ -0,0 +1,334 @@
+#include <DmxShow.h>
+#include <stddef.h>
+
+DmxShowRecorder::DmxShowRecorder() {
+    flash = NULL;
+    recording = 0;
+    full = 0;
+    writeOffset = DMX_SHOW_DATA_OFFSET;
+    queueEnd = DMX_SHOW_DATA_OFFSET;
+    erasedEnd = 0;
+    records = 0;
+    startMillis = 0;
+    lastRecordMillis = 0;
+    stopMillis = 0;
+}
+
+void DmxShowRecorder::begin(DmxShowFlash *flash) {
+    this->flash = flash;
+}
+
+bool DmxShowRecorder::start(unsigned long now) {
+    if (!flash || flash->getSize() < DMX_SHOW_SECTOR_SIZE) {
+        return false;
+    }
+
+    if (!flash->eraseSector(0)) {
+        return false;
+    }
+
+    DmxShowHeader header;
+    header.magic = DMX_SHOW_MAGIC;
+    header.version = DMX_SHOW_VERSION;
+
+    if (!flash->write(0, (const uint8_t*) &header, offsetof(DmxShowHeader, length))) {
+        return false;
+    }
+
+    encoder.reset();
+    writeOffset = DMX_SHOW_DATA_OFFSET;
+    queueEnd = DMX_SHOW_DATA_OFFSET;
+    erasedEnd = DMX_SHOW_SECTOR_SIZE;
+    records = 0;
+    startMillis = now;
+    lastRecordMillis = now;
+    full = 0;
+    recording = 1;
+
+    return true;
+}
+
+void DmxShowRecorder::enqueue(const uint8_t *data, uint16_t size) {
+    while (size) {
+        uint32_t pos = (queueEnd - DMX_SHOW_DATA_OFFSET) % DMX_SHOW_QUEUE_SIZE;
+        uint16_t count = DMX_SHOW_QUEUE_SIZE - pos < size ? DMX_SHOW_QUEUE_SIZE - pos : size;
+
+        memcpy(queue + pos, data, count);
+        queueEnd += count;
+        data += count;
+        size -= count;
+    }
+}
+
+// Writes start on a page boundary (but the last one), so a page is never
+// split by the end of the queue nor by a sector.
+bool DmxShowRecorder::writePage(uint16_t size, bool *erased) {
+    if (writeOffset >= erasedEnd) {
+        if (!flash->eraseSector(erasedEnd)) {
+            return false;
+        }
+
+        erasedEnd += DMX_SHOW_SECTOR_SIZE;
+        *erased = true;
+    }
+
+    if (!flash->write(writeOffset, queue + (writeOffset - DMX_SHOW_DATA_OFFSET) % DMX_SHOW_QUEUE_SIZE, size)) {
+        return false;
+    }
+
+    writeOffset += size;
+    return true;
+}
+
+bool DmxShowRecorder::record(uint8_t port, const uint8_t *slots, uint16_t length, unsigned long now) {
+    if (!recording || full) {
+        return false;
+    }
+
+    uint16_t size = encoder.encode(port, now - lastRecordMillis, slots, length, encoded);
+
+    if (size == 0) {
+        return true;
+    }
+
+    // Records are never cut, the show ends with the last one that fits.
+    if (queueEnd + size > flash->getSize() || queueEnd - writeOffset + size > DMX_SHOW_QUEUE_SIZE) {
+        full = 1;
+        stopMillis = now;
+        return false;
+    }
+
+    enqueue(encoded, size);
+    lastRecordMillis = now;
+    records++;
+
+    return true;
+}
+
+bool DmxShowRecorder::update() {
+    if (!recording) {
+        return false;
+    }
+
+    bool erased = false;
+
+    while (queueEnd - writeOffset >= DMX_SHOW_PAGE_SIZE) {
+        // The next erase waits for the next call.
+        if (erased && writeOffset >= erasedEnd) {
+            return true;
+        }
+
+        if (!writePage(DMX_SHOW_PAGE_SIZE, &erased)) {
+            recording = 0;
+            return false;
+        }
+    }
+
+    if (full) {
+        finish();
+        return false;
+    }
+
+    return true;
+}
+
+void DmxShowRecorder::stop(unsigned long now) {
+    if (!recording) {
+        return;
+    }
+
+    if (!full) {
+        stopMillis = now;
+    }
+
+    finish();
+}
+
+void DmxShowRecorder::finish() {
+    bool erased = false;
+
+    recording = 0;
+
+    while (writeOffset < queueEnd) {
+        uint16_t size = queueEnd - writeOffset < DMX_SHOW_PAGE_SIZE ? queueEnd - writeOffset : DMX_SHOW_PAGE_SIZE;
+
+        if (!writePage(size, &erased)) {
+            return;
+        }
+    }
+
+    DmxShowHeader header;
+    header.length = queueEnd - DMX_SHOW_DATA_OFFSET;
+    header.records = records;
+    header.durationMs = stopMillis - startMillis;
+
+    flash->write(offsetof(DmxShowHeader, length), (const uint8_t*) &header.length, sizeof(header) - offsetof(DmxShowHeader, length));
+}
+
+bool DmxShowRecorder::isRecording() const {
+    return recording;
+}
+
+uint32_t DmxShowRecorder::getRecordedBytes() const {
+    return queueEnd - DMX_SHOW_DATA_OFFSET;
+}
+
+uint32_t DmxShowRecorder::getRecords() const {
+    return records;
+}
+
+DmxShowPlayer::DmxShowPlayer() {
+    loop = 1;
+    flash = NULL;
+    memset(&header, 0, sizeof(header));
+    valid = 0;
+    playing = 0;
+    windowOffset = 0;
+    windowFill = 0;
+    windowPos = 0;
+    passStart = 0;
+    lastDue = 0;
+}
+
+void DmxShowPlayer::begin(DmxShowFlash *flash) {
+    this->flash = flash;
+    load();
+}
+
+void DmxShowPlayer::load() {
+    playing = 0;
+    valid = flash && flash->read(0, (uint8_t*) &header, sizeof(header)) &&
+        header.magic == DMX_SHOW_MAGIC &&
+        header.version == DMX_SHOW_VERSION &&
+        header.length != 0xFFFFFFFF &&
+        header.length > 0 &&
+        DMX_SHOW_DATA_OFFSET + header.length <= flash->getSize();
+}
+
+bool DmxShowPlayer::hasShow() const {
+    return valid;
+}
+
+const DmxShowHeader* DmxShowPlayer::getHeader() const {
+    return &header;
+}
+
+bool DmxShowPlayer::start(unsigned long now) {
+    if (!valid) {
+        return false;
+    }
+
+    rewind(now);
+    playing = 1;
+
+    return true;
+}
+
+void DmxShowPlayer::stop() {
+    playing = 0;
+}
+
+bool DmxShowPlayer::isPlaying() const {
+    return playing;
+}
+
+void DmxShowPlayer::rewind(unsigned long now) {
+    decoder.reset();
+    windowOffset = 0;
+    windowFill = 0;
+    windowPos = 0;
+    passStart = now;
+    lastDue = now;
+}
+
+bool DmxShowPlayer::fillWindow() {
+    uint16_t remaining = windowFill - windowPos;
+
+    memmove(window, window + windowPos, remaining);
+    windowOffset += windowPos;
+    windowPos = 0;
+    windowFill = remaining;
+
+    uint32_t streamLeft = header.length - (windowOffset + windowFill);
+    uint16_t count = sizeof(window) - windowFill;
+
+    if (count > streamLeft) {
+        count = streamLeft;
+    }
+
+    if (count && !flash->read(DMX_SHOW_DATA_OFFSET + windowOffset + windowFill, window + windowFill, count)) {
+        return false;
+    }
+
+    windowFill += count;
+    return true;
+}
+
+bool DmxShowPlayer::next(unsigned long now) {
+    if (!playing) {
+        return false;
+    }
+
+    if (windowFill - windowPos < DMX_SHOW_MAX_RECORD_SIZE && windowOffset + windowFill < header.length && !fillWindow()) {
+        playing = 0;
+        return false;
+    }
+
+    if (windowPos == windowFill) {
+        if (!loop) {
+            playing = 0;
+            return false;
+        }
+
+        // The next pass starts when the recording stopped.
+        unsigned long duration = header.durationMs ? header.durationMs : 1;
+
+        if ((long)(now - (passStart + duration)) < 0) {
+            return false;
+        }
+
+        rewind(passStart + duration);
+
+        if (!fillWindow()) {
+            playing = 0;
+            return false;
+        }
+    }
+
+    DmxShowRecordHeader recordHeader;
+
+    if (!DmxShowDecoder::readHeader(window + windowPos, windowFill - windowPos, &recordHeader)) {
+        playing = 0;
+        return false;
+    }
+
+    unsigned long due = lastDue + recordHeader.delayMs;
+
+    if ((long)(now - due) < 0) {
+        return false;
+    }
+
+    uint16_t size = decoder.decode(window + windowPos, windowFill - windowPos);
+
+    if (!size) {
+        playing = 0;
+        return false;
+    }
+
+    windowPos += size;
+    lastDue = due;
+
+    return true;
+}
+
+uint8_t DmxShowPlayer::getPort() const {
+    return decoder.getPort();
+}
+
+const uint8_t* DmxShowPlayer::getFrame() const {
+    return decoder.getFrame();
+}
+
+uint16_t DmxShowPlayer::getLength() const {
+    return decoder.getLength();
+}
@@ -0,0 +1,140 @@
+#ifndef DMX_SHOW_H
+#define DMX_SHOW_H
+
+#include <Arduino.h>
+#include <DMX.h>
+#include <DmxShowCodec.h>
+
+// Erase unit of the flash.
+#define DMX_SHOW_SECTOR_SIZE 4096
+// Records are written to the flash in blocks of this size.
+#define DMX_SHOW_PAGE_SIZE 256
+// Show header, then the record stream from DMX_SHOW_DATA_OFFSET.
+#define DMX_SHOW_DATA_OFFSET DMX_SHOW_PAGE_SIZE
+// Records read from the flash at a time while playing, at least a record.
+#define DMX_SHOW_READ_WINDOW_SIZE 2048
+// Records waiting in RAM for the flash, a multiple of DMX_SHOW_PAGE_SIZE. It
+// has to cover what arrives while a sector is erased.
+#ifndef DMX_SHOW_QUEUE_SIZE
+#define DMX_SHOW_QUEUE_SIZE 8192
+#endif
+
+#define DMX_SHOW_MAGIC 0x53584D44
+#define DMX_SHOW_VERSION 1
+
+static_assert(DMX_SHOW_READ_WINDOW_SIZE >= DMX_SHOW_MAX_RECORD_SIZE, "The window must hold a whole record");
+static_assert(DMX_SHOW_QUEUE_SIZE % DMX_SHOW_PAGE_SIZE == 0 && DMX_SHOW_QUEUE_SIZE >= DMX_SHOW_SECTOR_SIZE, "The queue holds whole pages");
+
+// Raw storage of the show, erased sector by sector. Reads and writes may
+// span sectors; writes only go to erased bytes.
+class DmxShowFlash {
+    public:
+        virtual uint32_t getSize() = 0;
+        virtual bool eraseSector(uint32_t offset) = 0;
+        virtual bool write(uint32_t offset, const uint8_t *data, uint32_t size) = 0;
+        virtual bool read(uint32_t offset, uint8_t *data, uint32_t size) = 0;
+};
+
+// Written when the recording starts; the fields after `version` stay erased
+// (all ones) until it stops, so an interrupted recording is never played.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    // Bytes of records after DMX_SHOW_DATA_OFFSET.
+    uint32_t length;
+    uint32_t records;
+    uint32_t durationMs;
+} DmxShowHeader;
+
+// Turns the frames it is given into DmxShowCodec records, queued in RAM.
+// Only update() and stop() touch the flash, so recording costs the network
+// receive no flash time; update() erases a sector every
+// DMX_SHOW_SECTOR_SIZE bytes of records, which blocks for tens of ms.
+class DmxShowRecorder {
+    public:
+        DmxShowRecorder();
+        void begin(DmxShowFlash *flash);
+
+        // Overwrites the stored show.
+        bool start(unsigned long now);
+        // Adds a frame of `port`; frames equal to the previous one of the port
+        // take no space. Returns false once the flash or the queue is full,
+        // update() then ends the recording.
+        bool record(uint8_t port, const uint8_t *slots, uint16_t length, unsigned long now);
+        // Writes the whole pages queued, erasing at most one sector. Returns
+        // false once the recording is over.
+        bool update();
+        // Writes everything left.
+        void stop(unsigned long now);
+        bool isRecording() const;
+
+        // Since start.
+        uint32_t getRecordedBytes() const;
+        uint32_t getRecords() const;
+    private:
+        DmxShowFlash *flash;
+        DmxShowEncoder encoder;
+        uint8_t recording;
+        // No more records, the rest still has to be written.
+        uint8_t full;
+        // Flash offsets: next byte to write, end of the queued records and
+        // end of the sectors erased.
+        uint32_t writeOffset;
+        uint32_t queueEnd;
+        uint32_t erasedEnd;
+        uint32_t records;
+        unsigned long startMillis;
+        unsigned long lastRecordMillis;
+        unsigned long stopMillis;
+        uint8_t queue[DMX_SHOW_QUEUE_SIZE];
+        uint8_t encoded[DMX_SHOW_MAX_RECORD_SIZE];
+
+        void enqueue(const uint8_t *data, uint16_t size);
+        bool writePage(uint16_t size, bool *erased);
+        void finish();
+};
+
+// Plays the stored show back with the recorded timing, optionally in a loop.
+class DmxShowPlayer {
+    public:
+        uint8_t loop;
+
+        DmxShowPlayer();
+        void begin(DmxShowFlash *flash);
+
+        // Reads the show header again, after a recording.
+        void load();
+        bool hasShow() const;
+        const DmxShowHeader* getHeader() const;
+
+        bool start(unsigned long now);
+        void stop();
+        bool isPlaying() const;
+
+        // Decodes the next frame once it is due. Returns false when no frame is
+        // due; call again until it does when catching up.
+        bool next(unsigned long now);
+        uint8_t getPort() const;
+        const uint8_t* getFrame() const;
+        uint16_t getLength() const;
+    private:
+        DmxShowFlash *flash;
+        DmxShowDecoder decoder;
+        DmxShowHeader header;
+        uint8_t valid;
+        uint8_t playing;
+        // Stream offset of window[0].
+        uint32_t windowOffset;
+        uint16_t windowFill;
+        uint16_t windowPos;
+        // Start of the current pass through the show.
+        unsigned long passStart;
+        // Due time of the last frame played.
+        unsigned long lastDue;
+        uint8_t window[DMX_SHOW_READ_WINDOW_SIZE];
+
+        void rewind(unsigned long now);
+        bool fillWindow();
+};
+
+#endif
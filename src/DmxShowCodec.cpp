@@ -0,0 +1,256 @@
+#include <DmxShowCodec.h>
+
+// Runs shorter than this are cheaper inside a literal than as their own token.
+#define DMX_SHOW_MIN_SKIP 3
+#define DMX_SHOW_MIN_FILL 4
+
+#define DMX_SHOW_TOKEN_MAX_COUNT 64
+
+static inline uint16_t dmx_show_write_varint(uint8_t *out, uint32_t value) {
+    uint16_t size = 0;
+
+    while (value >= 0x80) {
+        out[size++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+
+    out[size++] = value;
+    return size;
+}
+
+// Returns the bytes read, 0 when incomplete or longer than `maxSize`.
+static inline uint16_t dmx_show_read_varint(const uint8_t *data, uint32_t size, uint8_t maxSize, uint32_t *value) {
+    uint32_t result = 0;
+
+    for (uint8_t i = 0; i < maxSize && i < size; i++) {
+        result |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+
+        if ((data[i] & 0x80) == 0) {
+            *value = result;
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+// Slots from `from` equal in both frames, compared 4 at a time.
+static inline uint16_t dmx_show_count_unchanged(const uint8_t *slots, const uint8_t *previous, uint16_t from, uint16_t length) {
+    uint16_t i = from;
+
+    while (i + 4 <= length) {
+        uint32_t a, b;
+        memcpy(&a, slots + i, 4);
+        memcpy(&b, previous + i, 4);
+
+        if (a != b) {
+            break;
+        }
+
+        i += 4;
+    }
+
+    while (i < length && slots[i] == previous[i]) {
+        i++;
+    }
+
+    return i - from;
+}
+
+// Slots from `from` with the value of slots[from], up to `max`.
+static inline uint16_t dmx_show_count_same(const uint8_t *slots, uint16_t from, uint16_t length, uint16_t max) {
+    uint16_t i = from + 1;
+
+    while (i < length && i - from < max && slots[i] == slots[from]) {
+        i++;
+    }
+
+    return i - from;
+}
+
+DmxShowEncoder::DmxShowEncoder() {
+    reset();
+}
+
+void DmxShowEncoder::reset() {
+    memset(previous, 0, sizeof(previous));
+    memset(previousLength, 0, sizeof(previousLength));
+}
+
+uint16_t DmxShowEncoder::encode(uint8_t port, uint32_t delayMs, const uint8_t *slots, uint16_t length, uint8_t *out) {
+    if (port >= DMX_SHOW_MAX_PORTS) {
+        return 0;
+    }
+
+    if (length > DMX_MAX_CHANNELS) {
+        length = DMX_MAX_CHANNELS;
+    }
+
+    uint8_t *prev = previous[port];
+
+    if (length == previousLength[port] && memcmp(prev, slots, length) == 0) {
+        return 0;
+    }
+
+    uint8_t *p = out;
+    *p++ = port;
+    p += dmx_show_write_varint(p, delayMs);
+    p += dmx_show_write_varint(p, length);
+
+    uint16_t i = 0;
+
+    while (i < length) {
+        uint16_t unchanged = dmx_show_count_unchanged(slots, prev, i, length);
+
+        if (i + unchanged == length) {
+            *p++ = (uint8_t)DmxShowToken::End;
+            break;
+        }
+
+        if (unchanged) {
+            i += unchanged;
+
+            while (unchanged) {
+                uint16_t count = unchanged < DMX_SHOW_TOKEN_MAX_COUNT ? unchanged : DMX_SHOW_TOKEN_MAX_COUNT;
+                *p++ = (uint8_t)DmxShowToken::Skip | (count - 1);
+                unchanged -= count;
+            }
+
+            continue;
+        }
+
+        uint16_t same = dmx_show_count_same(slots, i, length, DMX_SHOW_TOKEN_MAX_COUNT);
+
+        if (same >= DMX_SHOW_MIN_FILL) {
+            *p++ = (uint8_t)DmxShowToken::Fill | (same - 1);
+            *p++ = slots[i];
+            i += same;
+            continue;
+        }
+
+        // Literal up to the next run worth its own token.
+        uint16_t count = 1;
+
+        while (i + count < length && count < DMX_SHOW_TOKEN_MAX_COUNT) {
+            uint16_t j = i + count;
+            uint16_t run = dmx_show_count_unchanged(slots, prev, j, j + DMX_SHOW_MIN_SKIP < length ? j + DMX_SHOW_MIN_SKIP : length);
+
+            if (run == DMX_SHOW_MIN_SKIP || j + run == length) {
+                break;
+            }
+
+            if (dmx_show_count_same(slots, j, length, DMX_SHOW_MIN_FILL) == DMX_SHOW_MIN_FILL) {
+                break;
+            }
+
+            count++;
+        }
+
+        *p++ = (uint8_t)DmxShowToken::Literal | (count - 1);
+        memcpy(p, slots + i, count);
+        p += count;
+        i += count;
+    }
+
+    memcpy(prev, slots, length);
+    previousLength[port] = length;
+
+    return p - out;
+}
+
+DmxShowDecoder::DmxShowDecoder() {
+    reset();
+}
+
+void DmxShowDecoder::reset() {
+    memset(frames, 0, sizeof(frames));
+    memset(&last, 0, sizeof(last));
+}
+
+uint16_t DmxShowDecoder::readHeader(const uint8_t *data, uint32_t size, DmxShowRecordHeader *header) {
+    if (size < 1 || data[0] >= DMX_SHOW_MAX_PORTS) {
+        return 0;
+    }
+
+    uint16_t pos = 1;
+    uint32_t length;
+    uint16_t read = dmx_show_read_varint(data + pos, size - pos, 5, &header->delayMs);
+
+    if (!read) {
+        return 0;
+    }
+
+    pos += read;
+    read = dmx_show_read_varint(data + pos, size - pos, 2, &length);
+
+    if (!read || length > DMX_MAX_CHANNELS) {
+        return 0;
+    }
+
+    header->port = data[0];
+    header->length = length;
+
+    return pos + read;
+}
+
+uint16_t DmxShowDecoder::decode(const uint8_t *data, uint32_t size) {
+    DmxShowRecordHeader header;
+    uint32_t pos = readHeader(data, size, &header);
+
+    if (!pos) {
+        return 0;
+    }
+
+    uint8_t *frame = frames[header.port];
+    uint16_t slot = 0;
+
+    while (slot < header.length) {
+        if (pos >= size) {
+            return 0;
+        }
+
+        uint8_t token = data[pos++];
+        uint8_t type = token & 0xC0;
+        uint16_t count = (token & 0x3F) + 1;
+
+        if (type == (uint8_t)DmxShowToken::End) {
+            break;
+        }
+
+        if (slot + count > header.length) {
+            return 0;
+        }
+
+        if (type == (uint8_t)DmxShowToken::Literal) {
+            if (pos + count > size) {
+                return 0;
+            }
+
+            memcpy(frame + slot, data + pos, count);
+            pos += count;
+        } else if (type == (uint8_t)DmxShowToken::Fill) {
+            if (pos >= size) {
+                return 0;
+            }
+
+            memset(frame + slot, data[pos++], count);
+        }
+
+        slot += count;
+    }
+
+    last = header;
+    return pos;
+}
+
+uint8_t DmxShowDecoder::getPort() const {
+    return last.port;
+}
+
+const uint8_t* DmxShowDecoder::getFrame() const {
+    return frames[last.port];
+}
+
+uint16_t DmxShowDecoder::getLength() const {
+    return last.length;
+}
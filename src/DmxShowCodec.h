@@ -0,0 +1,75 @@
+#ifndef DMX_SHOW_CODEC_H
+#define DMX_SHOW_CODEC_H
+
+#include <Arduino.h>
+#include <DMX.h>
+
+// Ports a show can hold.
+#define DMX_SHOW_MAX_PORTS 4
+
+// Port byte, delay (up to 5 bytes) and slot count (up to 2 bytes).
+#define DMX_SHOW_MAX_HEADER_SIZE 8
+
+// A token never costs more than 2 bytes per slot.
+#define DMX_SHOW_MAX_RECORD_SIZE (DMX_SHOW_MAX_HEADER_SIZE + 2 * DMX_MAX_CHANNELS)
+
+// Record of one frame:
+//   port (1 byte) | delay since the previous record, ms (varint) |
+//   slot count (varint) | tokens
+// Tokens rebuild the frame from the previous one of the same port (all zero
+// at the start of the stream). Top 2 bits are the type, low 6 bits the slot
+// count - 1:
+//   skip     slots unchanged
+//   literal  followed by the new value of each slot
+//   fill     followed by one value for all slots
+//   end      every remaining slot unchanged, count unused
+// The frame is complete once the tokens cover the slot count.
+enum class DmxShowToken : uint8_t {
+    Skip = 0x00,
+    Literal = 0x40,
+    Fill = 0x80,
+    End = 0xC0
+};
+
+typedef struct {
+    uint8_t port;
+    uint32_t delayMs;
+    uint16_t length;
+} DmxShowRecordHeader;
+
+class DmxShowEncoder {
+    public:
+        DmxShowEncoder();
+        // Back to all zero frames, for a new stream.
+        void reset();
+        // Writes the record of a frame to `out` (DMX_SHOW_MAX_RECORD_SIZE bytes)
+        // and returns its size, or 0 when the frame is the same as the
+        // previous one of the port and nothing needs to be recorded.
+        uint16_t encode(uint8_t port, uint32_t delayMs, const uint8_t *slots, uint16_t length, uint8_t *out);
+    private:
+        uint8_t previous[DMX_SHOW_MAX_PORTS][DMX_MAX_CHANNELS];
+        uint16_t previousLength[DMX_SHOW_MAX_PORTS];
+};
+
+class DmxShowDecoder {
+    public:
+        DmxShowDecoder();
+        void reset();
+        // Reads the header of the record at `data`. Returns the header size, 0
+        // when it is incomplete or invalid.
+        static uint16_t readHeader(const uint8_t *data, uint32_t size, DmxShowRecordHeader *header);
+        // Applies the record at `data` to the frame of its port and returns the
+        // record size. 0 when the record is incomplete or invalid, the frame
+        // may then be partly updated. With DMX_SHOW_MAX_RECORD_SIZE bytes
+        // available, 0 means the stream is corrupt.
+        uint16_t decode(const uint8_t *data, uint32_t size);
+        // Last record decoded.
+        uint8_t getPort() const;
+        const uint8_t* getFrame() const;
+        uint16_t getLength() const;
+    private:
+        uint8_t frames[DMX_SHOW_MAX_PORTS][DMX_MAX_CHANNELS];
+        DmxShowRecordHeader last;
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include <E131.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+
+namespace art_net {
+    static inline bool e131_has_valid_id(const uint8_t *data) {
+        uint64_t id[2];
+        memcpy(id, data, sizeof(id));
+        return id[0] == E131_ID_WORD_0 && id[1] == E131_ID_WORD_1;
+    }
+
+    static inline uint32_t e131_get_vector(const uint8_t *vector) {
+        return ((uint32_t)vector[0] << 24) | ((uint32_t)vector[1] << 16) | ((uint32_t)vector[2] << 8) | vector[3];
+    }
+
+    E131::E131() {
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            portUniverse[i] = i + 1;
+            mergers[i].sequenceRule = SequenceRule::E131;
+            mergers[i].sourceTimeoutMs = E131_SOURCE_TIMEOUT_MS;
+            activePriority[i] = 0;
+            activePriorityMillis[i] = 0;
+            hasActivePriority[i] = 0;
+        }
+
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    void E131::setDmxDataCallback(std::function<void(uint8_t, uint8_t, const uint8_t*, uint16_t)> func) {
+        dmxDataCallback = func;
+    }
+
+    void E131::setDmxCommitCallback(std::function<void(uint32_t)> func) {
+        dmxCommitCallback = func;
+    }
+
+    uint32_t E131::getMulticastGroup(uint16_t universe) {
+        return 239 | (255 << 8) | ((uint32_t)(universe >> 8) << 16) | ((uint32_t)(universe & 0xFF) << 24);
+    }
+
+    int16_t E131::getActivePriority(uint8_t port) const {
+        return hasActivePriority[port] ? activePriority[port] : -1;
+    }
+
+    uint32_t E131::getSequenceRejected() const {
+        uint32_t count = 0;
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            count += mergers[i].sequenceRejected;
+        }
+
+        return count;
+    }
+
+    void E131::formatStats(char *buffer, size_t size) const {
+        snprintf(buffer, size,
+            "sACN Data: %" PRIu32 "\r\n"
+            "sACN Sync/Discovery: %" PRIu32 "\r\n"
+            "sACN Bad Size: %" PRIu32 "\r\n"
+            "sACN Bad ID: %" PRIu32 "\r\n"
+            "sACN Foreign Universe: %" PRIu32 "\r\n"
+            "sACN Sequence Rejected: %" PRIu32 "\r\n"
+            "sACN Priority Rejected: %" PRIu32 "\r\n"
+            "sACN Bad Length: %" PRIu32 "\r\n"
+            "sACN Truncated: %" PRIu32 "\r\n"
+            "sACN Other Start Code: %" PRIu32 "\r\n"
+            "sACN Preview: %" PRIu32 "\r\n"
+            "sACN Terminated: %" PRIu32 "\r\n",
+            stats.dmx, stats.extended, stats.badSize, stats.badId, stats.dmxForeign,
+            getSequenceRejected(), stats.dmxPriority, stats.dmxBadLength, stats.dmxTruncated,
+            stats.dmxStartCode, stats.dmxPreview, stats.dmxTerminated);
+    }
+
+    int8_t E131::getOutputPort(const E131DataPacket *header) const {
+        uint16_t universe = ((uint16_t)header->UniverseHi << 8) | header->UniverseLo;
+
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            if (universe != 0 && portUniverse[i] == universe) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    // Only the sources of the highest priority heard are output; a lower one
+    // takes over once they are all lost.
+    bool E131::acceptPriority(uint8_t port, uint8_t priority, unsigned long now) {
+        if (priority > E131_MAX_PRIORITY) {
+            priority = E131_MAX_PRIORITY;
+        }
+
+        bool lost = !hasActivePriority[port] || now - activePriorityMillis[port] > E131_SOURCE_TIMEOUT_MS;
+
+        if (!lost && priority < activePriority[port]) {
+            stats.dmxPriority++;
+            return false;
+        }
+
+        if (lost || priority != activePriority[port]) {
+            // Sources of the previous priority are not merged with this one.
+            if (hasActivePriority[port] && priority != activePriority[port]) {
+                mergers[port].clearSources();
+            }
+
+            activePriority[port] = priority;
+            hasActivePriority[port] = 1;
+        }
+
+        return true;
+    }
+
+    bool E131::acceptDmxHeader(uint32_t remoteIP, const E131DataPacket *header, uint32_t payloadSize, uint8_t *universe, uint16_t *dataLength) {
+        stats.dmx++;
+
+        int8_t port = getOutputPort(header);
+
+        if (port < 0) {
+            stats.dmxForeign++;
+            return false;
+        }
+
+        uint16_t count = ((uint16_t)header->PropertyCountHi << 8) | header->PropertyCountLo;
+
+        if (
+            header->DmpVector != 0x02 || header->AddressType != 0xA1 ||
+            header->FirstAddressHi != 0 || header->FirstAddressLo != 0 ||
+            header->AddressIncrementHi != 0 || header->AddressIncrementLo != 1 ||
+            count < 1 || count > 513
+        ) {
+            stats.dmxBadLength++;
+            return false;
+        }
+
+        if (header->StartCode != 0) {
+            stats.dmxStartCode++;
+            return false;
+        }
+
+        if (header->Options & E131_OPTION_PREVIEW) {
+            stats.dmxPreview++;
+            return false;
+        }
+
+        if (header->Options & E131_OPTION_TERMINATED) {
+            stats.dmxTerminated++;
+            mergers[port].removeSource(header->Cid);
+
+            if (mergers[port].getSourceCount() == 0) {
+                hasActivePriority[port] = 0;
+            }
+
+            return false;
+        }
+
+        // Before the priority and the source count it.
+        if ((uint32_t)(count - 1) > payloadSize) {
+            stats.dmxTruncated++;
+            return false;
+        }
+
+        unsigned long now = millis();
+
+        if (!acceptPriority(port, header->Priority, now)) {
+            return false;
+        }
+
+        // Sources are told apart by CID, several can share a host.
+        if (!mergers[port].acceptSource(header->Cid, header->Sequence, now)) {
+            return false;
+        }
+
+        activePriorityMillis[port] = now;
+        *universe = port;
+        *dataLength = count - 1;
+
+        return true;
+    }
+
+    bool E131::needsMerge(uint8_t universe) const {
+        return mergers[universe].isMerging();
+    }
+
+    void E131::onDmxData(uint8_t universe, const uint8_t *data, uint16_t dataLength) {
+        if (mergers[universe].isMerging()) {
+            data = mergers[universe].merge(data, dataLength, &dataLength);
+
+            if (!data) {
+                return;
+            }
+        }
+
+        dmxDataCallback(universe, 0, data, dataLength);
+        onDmxFrameReceived(universe);
+    }
+
+    void E131::onDmxFrameReceived(uint8_t universe) {
+        dmxCommitCallback(1UL << universe);
+    }
+
+    void E131::onDmxPacket(uint32_t remoteIP, const E131DataPacket *packet, uint32_t size) {
+        uint8_t universe;
+        uint16_t dataLength;
+
+        if (!acceptDmxHeader(remoteIP, packet, size - E131_DMX_HEADER_SIZE, &universe, &dataLength)) {
+            return;
+        }
+
+        onDmxData(universe, packet->Data, dataLength);
+    }
+
+    PacketParseStatus E131::onPacketReceived(uint32_t remoteIP, uint16_t remotePort, const uint8_t *data, uint32_t size) {
+        if (size < offsetof(E131DataPacket, Cid)) {
+            stats.badSize++;
+            return PacketParseStatus::BadSize;
+        }
+
+        if (!e131_has_valid_id(data)) {
+            stats.badId++;
+            return PacketParseStatus::BadId;
+        }
+
+        const E131DataPacket *packet = (const E131DataPacket*) data;
+
+        switch (e131_get_vector(packet->RootVector)) {
+            case E131_VECTOR_ROOT_DATA: {
+                if (size < E131_DMX_HEADER_SIZE) {
+                    stats.badSize++;
+                    return PacketParseStatus::BadSize;
+                }
+
+                if (e131_get_vector(packet->FramingVector) != E131_VECTOR_FRAMING_DATA) {
+                    stats.badId++;
+                    return PacketParseStatus::BadOpCode;
+                }
+
+                onDmxPacket(remoteIP, packet, size);
+                return PacketParseStatus::Success;
+            }
+            case E131_VECTOR_ROOT_EXTENDED: {
+                stats.extended++;
+                return PacketParseStatus::Success;
+            }
+            default: {
+                stats.badId++;
+                return PacketParseStatus::BadOpCode;
+            }
+        }
+    }
+
+    HeaderClass E131::classifyHeader(const uint8_t *data, uint32_t size) const {
+        if (size < E131_DMX_HEADER_SIZE || !e131_has_valid_id(data)) {
+            return HeaderClass::Other;
+        }
+
+        const E131DataPacket *packet = (const E131DataPacket*) data;
+
+        if (
+            e131_get_vector(packet->RootVector) != E131_VECTOR_ROOT_DATA ||
+            e131_get_vector(packet->FramingVector) != E131_VECTOR_FRAMING_DATA
+        ) {
+            return HeaderClass::Other;
+        }
+
+        if (getOutputPort(packet) < 0) {
+            return HeaderClass::DmxRejected;
+        }
+
+        return HeaderClass::DmxAccepted;
+    }
+}
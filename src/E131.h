@@ -0,0 +1,147 @@
+#ifndef E131_H
+#define E131_H
+
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <ArtNetMerger.h>
+
+#define E131_PORT 5568
+
+// Bytes of an E1.31 data packet before the slot data (root layer .. start code).
+#define E131_DMX_HEADER_SIZE 126
+
+// Sources of the active priority not heard from for this long are lost
+// (E131_NETWORK_DATA_LOSS_TIMEOUT), lower priorities may take over.
+#ifndef E131_SOURCE_TIMEOUT_MS
+#define E131_SOURCE_TIMEOUT_MS 2500
+#endif
+
+#define E131_MAX_PRIORITY 200
+
+// Root and framing layer vectors.
+#define E131_VECTOR_ROOT_DATA 0x00000004
+#define E131_VECTOR_ROOT_EXTENDED 0x00000008
+#define E131_VECTOR_FRAMING_DATA 0x00000002
+
+// Framing layer Options bits.
+#define E131_OPTION_PREVIEW 0x80
+#define E131_OPTION_TERMINATED 0x40
+
+namespace art_net {
+    // Preamble size, postamble size and "ASC-E1.17\0\0\0", read as two
+    // little endian 64 bit words.
+    static constexpr uint64_t E131_ID_WORD_0 {
+        ((uint64_t)0x00) | ((uint64_t)0x10 << 8) | ((uint64_t)0x00 << 16) | ((uint64_t)0x00 << 24) |
+        ((uint64_t)'A' << 32) | ((uint64_t)'S' << 40) | ((uint64_t)'C' << 48) | ((uint64_t)'-' << 56)
+    };
+
+    static constexpr uint64_t E131_ID_WORD_1 {
+        ((uint64_t)'E') | ((uint64_t)'1' << 8) | ((uint64_t)'.' << 16) | ((uint64_t)'1' << 24) |
+        ((uint64_t)'7' << 32)
+    };
+
+    typedef struct E131DataPacket {
+        // Root layer
+        uint8_t PreambleSizeHi, PreambleSizeLo;
+        uint8_t PostambleSizeHi, PostambleSizeLo;
+        char AcnId[12];
+        uint8_t RootFlagsLengthHi, RootFlagsLengthLo;
+        uint8_t RootVector[4];
+        uint8_t Cid[16];
+        // Framing layer
+        uint8_t FramingFlagsLengthHi, FramingFlagsLengthLo;
+        uint8_t FramingVector[4];
+        char SourceName[64];
+        uint8_t Priority;
+        uint8_t SyncAddressHi, SyncAddressLo;
+        uint8_t Sequence;
+        uint8_t Options;
+        uint8_t UniverseHi, UniverseLo;
+        // DMP layer
+        uint8_t DmpFlagsLengthHi, DmpFlagsLengthLo;
+        uint8_t DmpVector;
+        uint8_t AddressType;
+        uint8_t FirstAddressHi, FirstAddressLo;
+        uint8_t AddressIncrementHi, AddressIncrementLo;
+        uint8_t PropertyCountHi, PropertyCountLo;
+        uint8_t StartCode;
+        uint8_t Data[512];
+    } E131DataPacket;
+
+    // Received packet counters, only touched by the network side.
+    typedef struct {
+        uint32_t dmx;
+        // Universe sync and discovery, not used by this node.
+        uint32_t extended;
+        uint32_t badSize;
+        uint32_t badId;
+        // Data for universes we don't output.
+        uint32_t dmxForeign;
+        // Bad DMP layer or more than 512 slots.
+        uint32_t dmxBadLength;
+        // Datagram shorter than its property count.
+        uint32_t dmxTruncated;
+        // Start code other than 0 (e.g. 0xDD per slot priority).
+        uint32_t dmxStartCode;
+        uint32_t dmxPreview;
+        uint32_t dmxTerminated;
+        // Sources below the active priority of the universe.
+        uint32_t dmxPriority;
+    } E131Stats;
+
+    // E1.31 (sACN) receiver. Delivers to the same data and commit callbacks as
+    // ArtNet, so both feed the output ports through one pipeline. Only the
+    // sources of the highest priority heard on a universe are output, merged
+    // like ArtNet sources when there are several.
+    class E131 {
+        public:
+            // What the Receiver reads before deciding where the slots go.
+            typedef E131DataPacket DmxPacket;
+            static constexpr uint16_t DMX_HEADER_SIZE {E131_DMX_HEADER_SIZE};
+
+            // sACN universe (1-63999) of each output port, 0 when disabled.
+            uint16_t portUniverse[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            Merger mergers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            E131Stats stats;
+
+            E131();
+            void setDmxDataCallback(std::function<void(uint8_t, uint8_t, const uint8_t*, uint16_t)> func);
+            // Called with the mask (bit n for port n) of the port written, so
+            // frames of other ports waiting for an ArtSync stay staged.
+            void setDmxCommitCallback(std::function<void(uint32_t)> func);
+            PacketParseStatus onPacketReceived(uint32_t remoteIP, uint16_t remotePort, const uint8_t *data, uint32_t size);
+            // Classifies a datagram from its first E131_DMX_HEADER_SIZE bytes so
+            // data for foreign universes can be discarded without reading the slots.
+            HeaderClass classifyHeader(const uint8_t *data, uint32_t size) const;
+            // Validates addressing, priority, source, sequence and length of a
+            // data packet header, followed by `payloadSize` bytes of slots.
+            // Returns false when the frame must be dropped.
+            bool acceptDmxHeader(uint32_t remoteIP, const E131DataPacket *header, uint32_t payloadSize, uint8_t *universe, uint16_t *dataLength);
+            // Same contract as in ArtNet.
+            bool needsMerge(uint8_t universe) const;
+            void onDmxData(uint8_t universe, const uint8_t *data, uint16_t dataLength);
+            void onDmxFrameReceived(uint8_t universe);
+            // Priority currently output on a port, -1 when no source is active.
+            int16_t getActivePriority(uint8_t port) const;
+            // Sums of the merger rejections over all ports.
+            uint32_t getSequenceRejected() const;
+            // Writes all counters as "Label: value" lines.
+            void formatStats(char *buffer, size_t size) const;
+
+            // 239.255.{universe hi}.{universe lo}, in the layout of IPAddress.
+            static uint32_t getMulticastGroup(uint16_t universe);
+        private:
+            std::function<void(uint8_t, uint8_t, const uint8_t*, uint16_t)> dmxDataCallback;
+            std::function<void(uint32_t)> dmxCommitCallback;
+            uint8_t activePriority[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            uint8_t hasActivePriority[ART_NET_OUTPUT_UNIVERSE_COUNT];
+            // Last packet accepted at the active priority.
+            unsigned long activePriorityMillis[ART_NET_OUTPUT_UNIVERSE_COUNT];
+
+            bool acceptPriority(uint8_t port, uint8_t priority, unsigned long now);
+            void onDmxPacket(uint32_t remoteIP, const E131DataPacket *packet, uint32_t size);
+            int8_t getOutputPort(const E131DataPacket *header) const;
+    };
+}
+
+#endif
@@ -3,16 +3,48 @@
 #include <EEPROM_Data.h>
 #include <ArtNet.h>
 
+static_assert(sizeof(EEPROM_Data) <= CONFIG_STORE_MAX_SIZE, "Settings too large for the config store");
+static_assert(EEPROM_DATA_SHORT_NAME_SIZE == ART_NET_SHORT_NAME_SIZE && EEPROM_DATA_LONG_NAME_SIZE == ART_NET_LONG_NAME_SIZE, "Node name sizes differ");
+
 EEPROM_Data currentData;
 EEPROM_Data storedData;
+ConfigStore configStore;
+
+
+void EEPROM_DataInitialize(ConfigStoreFlash *flash) {
+    configStore.begin(flash, EEPROM_DATA_VERSION, sizeof(EEPROM_Data));
+
+    if (configStore.load((uint8_t*) &storedData)) {
+        if (EEPROM_DataIsValid(&storedData, 0)) {
+            memcpy(&currentData, &storedData, sizeof(EEPROM_Data));
+        } else {
+            EEPROM_DataReset();
+        }
 
+        return;
+    }
+
+    // The fields an older layout lacks start empty.
+    memset(&storedData, 0, sizeof(EEPROM_Data));
+
+    ConfigStore previous;
+    previous.begin(flash, 1, EEPROM_DATA_BLUETOOTH_SIZE);
 
-void EEPROM_DataInitialize() {
-    EEPROM.begin(sizeof(EEPROM_Data));
-    EEPROM.readBytes(0, &storedData, sizeof(EEPROM_Data));
+    if (!previous.load((uint8_t*) &storedData)) {
+        // Nothing journaled yet: settings of the firmware before, if any.
+        EEPROM.begin(EEPROM_DATA_LEGACY_SIZE);
+        EEPROM.readBytes(0, &storedData, EEPROM_DATA_LEGACY_SIZE);
+        EEPROM.end();
+
+        // Port 1 keeps the universe the node had, the others follow it.
+        for (uint8_t i = 0; i < EEPROM_DATA_OUTPUT_PORTS; i++) {
+            storedData.portUniverse[i] = (storedData.subuni + i) & 0x0F;
+        }
+    }
 
     if (EEPROM_DataIsValid(&storedData, 0)) {
         memcpy(&currentData, &storedData, sizeof(EEPROM_Data));
+        EEPROM_DataStore();
     } else {
         EEPROM_DataReset();
     }
@@ -23,9 +55,7 @@ EEPROM_Data* EEPROM_DataGet() {
 }
 
 void EEPROM_DataStore() {
-    EEPROM.writeBytes(0, &currentData, sizeof(EEPROM_Data));
-    EEPROM.commit();
-    memcpy(&storedData, &currentData, sizeof(EEPROM_Data));
+    configStore.store((const uint8_t*) &currentData);
 }
 
 void EEPROM_DataReset() {
@@ -35,10 +65,19 @@ void EEPROM_DataReset() {
     currentData.wirelessSSID[0] = 0;
     currentData.wirelessPassword[0] = 0;
 
+    for (uint8_t i = 0; i < EEPROM_DATA_OUTPUT_PORTS; i++) {
+        currentData.portUniverse[i] = i;
+        currentData.portMode[i] = PORT_MODE_OUTPUT;
+        currentData.portMergeMode[i] = 0;
+    }
+
+    memset(currentData.nodeShortName, 0, sizeof(currentData.nodeShortName));
+    memset(currentData.nodeLongName, 0, sizeof(currentData.nodeLongName));
+
     EEPROM_DataStore();
 }
 
-uint8_t EEPROM_DataIsValid(EEPROM_Data *data, char **err) {
+uint8_t EEPROM_DataIsValid(EEPROM_Data *data, const char **err) {
 
     uint8_t dataValid = true;
     uint8_t found = false;
@@ -78,6 +117,40 @@ uint8_t EEPROM_DataIsValid(EEPROM_Data *data, char **err) {
         return false;
     }
 
+    for (uint8_t i = 0; i < EEPROM_DATA_OUTPUT_PORTS; i++) {
+        dataValid = dataValid && data->portUniverse[i] <= 0xF;
+    }
+
+    if (!dataValid && err) {
+        (*err) = "Port Universe invalid.";
+        return false;
+    }
+
+    for (uint8_t i = 0; i < EEPROM_DATA_OUTPUT_PORTS; i++) {
+        dataValid = dataValid && data->portMode[i] <= PORT_MODE_INPUT;
+    }
+
+    if (!dataValid && err) {
+        (*err) = "Port Mode invalid.";
+        return false;
+    }
+
+    for (uint8_t i = 0; i < EEPROM_DATA_OUTPUT_PORTS; i++) {
+        dataValid = dataValid && data->portMergeMode[i] <= (uint8_t) art_net::MergeMode::Ltp;
+    }
+
+    if (!dataValid && err) {
+        (*err) = "Port Merge Mode invalid.";
+        return false;
+    }
+
+    dataValid = dataValid && memchr(data->nodeShortName, 0, sizeof(data->nodeShortName)) && memchr(data->nodeLongName, 0, sizeof(data->nodeLongName));
+
+    if (!dataValid && err) {
+        (*err) = "Node name has no termination char.";
+        return false;
+    }
+
     found = false;
 
     for (uint8_t i = 0; i < WIFI_SSID_MAX_LENGTH + 1; i++) {
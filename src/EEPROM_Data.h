@@ -1,11 +1,21 @@
 #include <Arduino.h>
+#include <ConfigStore.h>
 #include <DMX.h>
+#include <stddef.h>
 
 #define SYSTEM_PASSWORD_MAX_LENGTH 12
 #define WIFI_SSID_MIN_LENGTH 1
 #define WIFI_SSID_MAX_LENGTH 200
 #define WIFI_PASSWORD_MIN_LENGTH 8
 #define WIFI_PASSWORD_MAX_LENGTH 200
+// Fixed so the Bluetooth settings layout doesn't depend on build flags.
+#define EEPROM_DATA_OUTPUT_PORTS 3
+// Of the stored layout, bump it when EEPROM_Data changes. Fields are only
+// added at the end, an older layout is this one cut short.
+#define EEPROM_DATA_VERSION 2
+// As ART_NET_SHORT_NAME_SIZE / ART_NET_LONG_NAME_SIZE.
+#define EEPROM_DATA_SHORT_NAME_SIZE 18
+#define EEPROM_DATA_LONG_NAME_SIZE 64
 
 enum EEPROM_DataWirelessMode {
     WIRELESS_MODE_UNINITIALIZED = 0,
@@ -13,6 +23,11 @@ enum EEPROM_DataWirelessMode {
     WIRELESS_MODE_AP = 2
 };
 
+enum EEPROM_DataPortMode {
+    PORT_MODE_OUTPUT = 0,
+    PORT_MODE_INPUT = 1
+};
+
 typedef struct {
     char systemPassword[SYSTEM_PASSWORD_MAX_LENGTH + 1];
     uint16_t channelCount;
@@ -21,10 +36,29 @@ typedef struct {
     uint8_t wirelessMode;
     char wirelessSSID[WIFI_SSID_MAX_LENGTH + 1];
     char wirelessPassword[WIFI_PASSWORD_MAX_LENGTH + 1];
+    // ArtNet universe (0-15) of each DMX output port, within net/subnet.
+    uint8_t portUniverse[EEPROM_DATA_OUTPUT_PORTS];
+    // EEPROM_DataPortMode of each DMX port, applied on boot.
+    uint8_t portMode[EEPROM_DATA_OUTPUT_PORTS];
+    // Set by ArtAddress, empty for the built in names.
+    char nodeShortName[EEPROM_DATA_SHORT_NAME_SIZE];
+    char nodeLongName[EEPROM_DATA_LONG_NAME_SIZE];
+    // art_net::MergeMode of each output port, set by ArtAddress.
+    uint8_t portMergeMode[EEPROM_DATA_OUTPUT_PORTS];
 } EEPROM_Data;
 
-void EEPROM_DataInitialize();
+// What the Bluetooth settings request carries, the fields before the ones
+// only set over ArtNet. Also the whole of layout version 1.
+#define EEPROM_DATA_BLUETOOTH_SIZE offsetof(EEPROM_Data, nodeShortName)
+// Settings in the EEPROM of the firmware before ports, with a single
+// universe in the low nibble of subuni.
+#define EEPROM_DATA_LEGACY_SIZE offsetof(EEPROM_Data, portUniverse)
+
+// Loads the settings journaled in `flash`, or those of the EEPROM of older
+// firmware the first time.
+void EEPROM_DataInitialize(ConfigStoreFlash *flash);
 EEPROM_Data* EEPROM_DataGet();
+// Writes the fields changed since the last store.
 void EEPROM_DataStore();
 void EEPROM_DataReset();
-uint8_t EEPROM_DataIsValid(EEPROM_Data *data, char **err);
+uint8_t EEPROM_DataIsValid(EEPROM_Data *data, const char **err);
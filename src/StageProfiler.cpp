@@ -0,0 +1,93 @@
+#include <StageProfiler.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    memset(buckets, 0, sizeof(buckets));
+    count = 0;
+    max = 0;
+}
+
+uint8_t LatencyHistogram::getBucket(uint32_t micros) {
+    if (micros < LATENCY_HISTOGRAM_LINEAR_LIMIT) {
+        return micros;
+    }
+
+    uint8_t octave = 31 - __builtin_clz(micros);
+
+    if (octave >= LATENCY_HISTOGRAM_MAX_OCTAVE) {
+        return LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+
+    // Two bits below the leading one pick the quarter of the octave.
+    uint8_t quarter = (micros >> (octave - 2)) & 0x3;
+
+    return LATENCY_HISTOGRAM_LINEAR_LIMIT + (octave - 4) * 4 + quarter;
+}
+
+uint32_t LatencyHistogram::getBucketUpperBound(uint8_t bucket) {
+    if (bucket < LATENCY_HISTOGRAM_LINEAR_LIMIT) {
+        return bucket;
+    }
+
+    uint8_t octave = 4 + (bucket - LATENCY_HISTOGRAM_LINEAR_LIMIT) / 4;
+    uint8_t quarter = (bucket - LATENCY_HISTOGRAM_LINEAR_LIMIT) % 4;
+
+    return ((uint32_t)(4 + quarter + 1) << (octave - 2)) - 1;
+}
+
+void LatencyHistogram::record(uint32_t micros) {
+    buckets[getBucket(micros)]++;
+    count++;
+
+    if (micros > max) {
+        max = micros;
+    }
+}
+
+uint32_t LatencyHistogram::getPercentile(uint8_t percent) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    // Rank of the sample, rounded up: p50 of 3 samples is the 2nd.
+    uint32_t rank = ((uint64_t)count * percent + 99) / 100;
+    uint32_t seen = 0;
+
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    for (uint8_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        seen += buckets[i];
+
+        if (seen >= rank) {
+            if (i == LATENCY_HISTOGRAM_BUCKETS - 1) {
+                // Open ended.
+                return max;
+            }
+
+            uint32_t upperBound = getBucketUpperBound(i);
+            return upperBound < max ? upperBound : max;
+        }
+    }
+
+    return max;
+}
+
+uint32_t LatencyHistogram::getMax() const {
+    return max;
+}
+
+uint32_t LatencyHistogram::getCount() const {
+    return count;
+}
+
+int LatencyHistogram::format(char *buffer, size_t size, const char *name) const {
+    return snprintf(buffer, size, "%s: p50 %" PRIu32 " us, p99 %" PRIu32 " us, max %" PRIu32 " us, n %" PRIu32 "\r\n",
+        name, getPercentile(50), getPercentile(99), max, count);
+}
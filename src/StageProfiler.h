@@ -0,0 +1,62 @@
+#ifndef STAGE_PROFILER_H
+#define STAGE_PROFILER_H
+
+#include <Arduino.h>
+
+// Build with -DSTAGE_PROFILER_ENABLED=1 to time the loop and output stages.
+// When 0, PROFILE_STAGE only runs its statement and no histogram is kept.
+#ifndef STAGE_PROFILER_ENABLED
+#define STAGE_PROFILER_ENABLED 0
+#endif
+
+// Values below this get a bucket each, above it every power of two is split
+// in 4, so percentiles are within 25% up to ~16 s.
+#define LATENCY_HISTOGRAM_LINEAR_LIMIT 16
+#define LATENCY_HISTOGRAM_MAX_OCTAVE 24
+#define LATENCY_HISTOGRAM_BUCKETS (LATENCY_HISTOGRAM_LINEAR_LIMIT + (LATENCY_HISTOGRAM_MAX_OCTAVE - 4) * 4)
+
+// Fixed bucket histogram of durations in microseconds. Recording is a few
+// instructions and never allocates.
+class LatencyHistogram {
+    public:
+        LatencyHistogram();
+
+        void record(uint32_t micros);
+        void reset();
+
+        // Upper bound of the bucket holding the given percentile, capped to the max.
+        uint32_t getPercentile(uint8_t percent) const;
+        uint32_t getMax() const;
+        uint32_t getCount() const;
+
+        // "name: p50 12 us, p99 340 us, max 1200 us, n 12345\r\n"
+        int format(char *buffer, size_t size, const char *name) const;
+    private:
+        uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+        uint32_t count;
+        uint32_t max;
+
+        static uint8_t getBucket(uint32_t micros);
+        static uint32_t getBucketUpperBound(uint8_t bucket);
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+// CPU cycle counter of the running core: cheaper and finer than micros().
+#define STAGE_PROFILER_TICKS() ESP.getCycleCount()
+#define STAGE_PROFILER_TICKS_PER_MICRO (F_CPU / 1000000)
+#else
+#define STAGE_PROFILER_TICKS() ((uint32_t) micros())
+#define STAGE_PROFILER_TICKS_PER_MICRO 1
+#endif
+
+#if STAGE_PROFILER_ENABLED
+#define PROFILE_STAGE(histogram, statement) do { \
+        uint32_t stageStartTicks = STAGE_PROFILER_TICKS(); \
+        statement; \
+        (histogram)->record((STAGE_PROFILER_TICKS() - stageStartTicks) / STAGE_PROFILER_TICKS_PER_MICRO); \
+    } while (0)
+#else
+#define PROFILE_STAGE(histogram, statement) do { statement; } while (0)
+#endif
+
+#endif
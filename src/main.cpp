@@ -1,57 +1,306 @@
 #include <Arduino.h>
 #include <EEPROM_Data.h>
 #include <BluetoothSerial.h>
+#include <BluetoothFrameParser.h>
+#include <BluetoothWindow.h>
 #include <string.h>
+#include <inttypes.h>
 #include <WiFi.h>
-#include <ArtNet.h>
+#include <ArtNetImpl.h>
+#include <ArtNetReceiver.h>
+#include <E131.h>
+#include <DmxFrameBuffer.h>
+#include <DmxNzsQueue.h>
+#include <DmxProcessor.h>
+#include <DmxOutputScheduler.h>
+#include <DmxInputDecoder.h>
+#include <DmxInputScheduler.h>
+#include <DmxInterpolator.h>
+#include <DmxBreakTimer.h>
+#include <DmxShow.h>
+#include <StageProfiler.h>
+#include <ArrivalJitter.h>
 
 #include "hal/uart_ll.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
 
 using namespace art_net;
 
 #define LED_CATHODE_PIN GPIO_NUM_4
 #define RESET_PREFERENCES_PIN GPIO_NUM_14
 #define BLUETOOTH_DATA_RECEIVE_TIMEOUT_MILLIS 1000
+// Bytes read from Bluetooth per loop.
+#define BLUETOOTH_READ_BUDGET 64
+#define BLUETOOTH_DEVICE_NAME "ArtNet Mini ESP32"
+
+// Loop task runs on core 1 at priority 1, output preempts it while it is not
+// blocked in the UART driver.
+#define DMX_OUTPUT_TASK_CORE 1
+#define DMX_OUTPUT_TASK_PRIORITY 3
+#define DMX_OUTPUT_TASK_STACK_SIZE 2048
+
+// Input ports share the core and priority of the output tasks.
+#define DMX_INPUT_TASK_STACK_SIZE 2048
+// One UART_DATA event per byte while a frame comes in.
+#define DMX_INPUT_EVENT_QUEUE_SIZE 128
+#define DMX_INPUT_RX_BUFFER_SIZE 1024
+
+// Port 1 keeps the original Serial2 wiring, UART1 and UART0 drive ports 2 and 3.
+#define DMX_PORT_2_TX_PIN GPIO_NUM_18
+#define DMX_PORT_3_TX_PIN GPIO_NUM_1
+
+// Line receiver of each port, used when the port is an input.
+#define DMX_PORT_1_RX_PIN GPIO_NUM_16
+#define DMX_PORT_2_RX_PIN GPIO_NUM_19
+#define DMX_PORT_3_RX_PIN GPIO_NUM_3
+
+// Without network data for this long the stored show plays, also after boot.
+#define DMX_SHOW_FAILOVER_TIMEOUT_MS 5000
+// ArtAddress changes are saved once the console stopped sending them for this long.
+#define ART_ADDRESS_SAVE_DELAY_MS 2000
+
+static_assert(ART_NET_OUTPUT_UNIVERSE_COUNT <= EEPROM_DATA_OUTPUT_PORTS, "More ports than the settings can address");
+
+typedef struct {
+  HardwareSerial *serial;
+  uint8_t uartNum;
+  int8_t txPin;
+  int8_t rxPin;
+  // Pin that forces the line low for the break, -1 to invert the UART TX instead.
+  int8_t breakPin;
+} DmxOutputPort;
 
 enum BluetoothRequestType {
   BLUETOOTH_REQUEST_TYPE_NONE,
   BLUETOOTH_REQUEST_TYPE_CHANGE_SETTINGS,
   BLUETOOTH_REQUEST_TYPE_CHANGE_PASSWORD,
   BLUETOOTH_REQUEST_TYPE_GET_INFO,
+  BLUETOOTH_REQUEST_TYPE_CHANGE_PROCESSING,
+  BLUETOOTH_REQUEST_TYPE_SHOW,
+};
+
+typedef struct __attribute__((packed)) {
+  char oldPassword[SYSTEM_PASSWORD_MAX_LENGTH + 1];
+  char newPassword[SYSTEM_PASSWORD_MAX_LENGTH + 1];
+} BluetoothPasswordRequest;
+
+static_assert(EEPROM_DATA_BLUETOOTH_SIZE <= BLUETOOTH_FRAME_MAX_PAYLOAD, "Settings don't fit in a Bluetooth frame");
+
+enum BluetoothProcessingCommand {
+  // value: input channel, 1 based, 0 to unpatch.
+  BLUETOOTH_PROCESSING_PATCH,
+  // value: DmxCurve, + 0x100 when the channel follows the master.
+  BLUETOOTH_PROCESSING_CURVE,
+  // value: 0-255, channel is ignored.
+  BLUETOOTH_PROCESSING_MASTER,
+  // Port back to 1:1, channel and value are ignored.
+  BLUETOOTH_PROCESSING_RESET,
+  // value: 1 to interpolate between received frames, channel is ignored.
+  BLUETOOTH_PROCESSING_SMOOTHING,
+  // value: 1 when the channel must not be interpolated (gobo, mode, ...).
+  BLUETOOTH_PROCESSING_SMOOTHING_EXCLUDE,
 };
 
+// Processing settings are kept until reboot only.
+typedef struct __attribute__((packed)) {
+  char systemPassword[SYSTEM_PASSWORD_MAX_LENGTH];
+  uint8_t port;
+  uint8_t command;
+  // Output channel, 1 based, little endian like the rest.
+  uint16_t channel;
+  uint16_t value;
+} BluetoothProcessingRequest;
+
+enum BluetoothShowCommand {
+  // Stops recording or playing; failover waits for the network to come back
+  // and drop again.
+  BLUETOOTH_SHOW_STOP,
+  // Replaces the stored show with the output frames from now on, until stopped
+  // or the flash is full.
+  BLUETOOTH_SHOW_RECORD,
+  BLUETOOTH_SHOW_PLAY,
+  BLUETOOTH_SHOW_ERASE,
+};
+
+typedef struct __attribute__((packed)) {
+  char systemPassword[SYSTEM_PASSWORD_MAX_LENGTH];
+  uint8_t command;
+} BluetoothShowRequest;
+
 EEPROM_Data* settings;
 EEPROM_Data tempSettings;
 BluetoothSerial SerialBT;
 
+BluetoothFrameParser bluetoothFrameParser;
+BluetoothWindow bluetoothWindow;
+// Free heap right after the stack was last started / stopped, 0 until then.
+uint32_t bluetoothOnFreeHeap;
+uint32_t bluetoothOffFreeHeap;
+
 unsigned long lastSettingsAuthFail;
-unsigned long lastBTReceivedData;
 uint8_t lastSettingsAuthFailCount;
-uint8_t bluetoothRequestType;
 
 wl_status_t lastWiFiStatus;
 uint8_t settingReloadWiFi;
 WiFiUDP UDP;
-uint32_t udpBuffer[512];
+WiFiUDP SacnUDP;
+// Only holds the sACN multicast memberships, closing it leaves the groups.
+int sacnGroupSocket = -1;
+
+// ArtNet calls straight into the functions below, inlined in the packet path.
+class NodeArtNetSink {
+  public:
+    void sendPacket(uint32_t dstIP, uint16_t dstPort, const uint8_t *data, uint32_t size);
+    void onDmxData(uint8_t universe, uint8_t startCode, const uint8_t *data, uint16_t size);
+    void onDmxCommit();
+};
+
+typedef BasicArtNet<NodeArtNetSink> NodeArtNet;
+
+NodeArtNet MyArtNet;
+E131 MyE131;
+
+#if STAGE_PROFILER_ENABLED
+enum LoopStage {
+  LOOP_STAGE_BLUETOOTH,
+  LOOP_STAGE_WIFI,
+  LOOP_STAGE_RECEIVE,
+  LOOP_STAGE_SHOW,
+  LOOP_STAGE_REPLIES,
+  LOOP_STAGE_COUNT,
+};
+
+enum OutputStage {
+  OUTPUT_STAGE_BREAK,
+  OUTPUT_STAGE_FILL,
+  OUTPUT_STAGE_COUNT,
+};
+
+const char *loopStageNames[LOOP_STAGE_COUNT] = { "Loop Bluetooth", "Loop WiFi", "Loop UDP Receive", "Loop Show Flash", "Loop Replies" };
+const char *outputStageNames[OUTPUT_STAGE_COUNT] = { "Break", "UART Fill" };
+
+LatencyHistogram loopStageHistograms[LOOP_STAGE_COUNT];
+LatencyHistogram outputStageHistograms[ART_NET_OUTPUT_UNIVERSE_COUNT][OUTPUT_STAGE_COUNT];
+#endif
+
+DmxOutputPort dmxOutputPorts[EEPROM_DATA_OUTPUT_PORTS] = {
+  { &Serial2, 2, GPIO_NUM_17, DMX_PORT_1_RX_PIN, LED_CATHODE_PIN },
+  { &Serial1, 1, DMX_PORT_2_TX_PIN, DMX_PORT_2_RX_PIN, -1 },
+  { &Serial, 0, DMX_PORT_3_TX_PIN, DMX_PORT_3_RX_PIN, -1 },
+};
+
+DmxFrameBuffer dmxFrameBuffers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+DmxOutputScheduler dmxOutputSchedulers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+DmxNzsQueue dmxNzsQueues[ART_NET_OUTPUT_UNIVERSE_COUNT];
+DmxProcessor dmxProcessors[ART_NET_OUTPUT_UNIVERSE_COUNT];
+DmxInterpolator dmxInterpolators[ART_NET_OUTPUT_UNIVERSE_COUNT];
+DmxInputDecoder dmxInputDecoders[ART_NET_OUTPUT_UNIVERSE_COUNT];
+DmxInputScheduler dmxInputSchedulers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+// Where ArtDmx of input ports goes.
+uint32_t dmxInputDestinationIP = 0xFFFFFFFF;
+
+// Part of the data partition of no_ota.csv, unused otherwise: the show, then
+// the settings journal in its last sectors.
+class PartitionFlash : public DmxShowFlash, public ConfigStoreFlash {
+  public:
+    void begin(const esp_partition_t *partition, uint32_t offset, uint32_t size) {
+      if (partition && offset + size <= partition->size) {
+        this->partition = partition;
+        this->offset = offset;
+        this->size = size;
+      }
+    }
+
+    uint32_t getSize() override {
+      return partition ? size : 0;
+    }
+
+    bool eraseSector(uint32_t offset) override {
+      return partition && offset < size && esp_partition_erase_range(partition, this->offset + offset, DMX_SHOW_SECTOR_SIZE) == ESP_OK;
+    }
+
+    bool write(uint32_t offset, const uint8_t *data, uint32_t size) override {
+      return partition && offset + size <= this->size && esp_partition_write(partition, this->offset + offset, data, size) == ESP_OK;
+    }
+
+    bool read(uint32_t offset, uint8_t *data, uint32_t size) override {
+      return partition && offset + size <= this->size && esp_partition_read(partition, this->offset + offset, data, size) == ESP_OK;
+    }
+  private:
+    const esp_partition_t *partition = NULL;
+    uint32_t offset = 0;
+    uint32_t size = 0;
+};
 
-ArtNet MyArtNet;
+static_assert(DMX_SHOW_SECTOR_SIZE == CONFIG_STORE_SECTOR_SIZE, "The show and the settings share the flash");
 
-uint8_t dmxDataBuffers[2][513];
-uint8_t* dmxWriteDataBuffer;
-uint8_t* dmxReadDataBuffer;
-uint8_t dmxWriteDataBufferHasNewData;
+#define SETTINGS_FLASH_SIZE (2 * CONFIG_STORE_SECTOR_SIZE)
 
-uint16_t currentWriteBufferIndex;
-unsigned long lastTransmit;
-unsigned long breakStartedAt;
+PartitionFlash settingsFlash;
+PartitionFlash dmxShowFlash;
+DmxShowRecorder dmxShowRecorder;
+DmxShowPlayer dmxShowPlayer;
+unsigned long lastNetworkFrameMillis;
+// Frames of the first output port, with Bluetooth off and on.
+ArrivalJitter arrivalJitter[2];
+int8_t jitterPort = -1;
+// Cleared by BLUETOOTH_SHOW_STOP, set again by network data.
+uint8_t dmxShowFailoverArmed = 1;
+// MyArtNet.addressChanges already copied to the settings.
+uint32_t seenAddressChanges;
+unsigned long lastAddressChangeMillis;
+uint8_t addressSavePending;
+
+Receiver<WiFiUDP, NodeArtNet> MyReceiver(&MyArtNet, &UDP, dmxFrameBuffers, dmxProcessors);
+Receiver<WiFiUDP, E131> MySacnReceiver(&MyE131, &SacnUDP, dmxFrameBuffers, dmxProcessors);
+
+TaskHandle_t dmxOutputTaskHandles[ART_NET_OUTPUT_UNIVERSE_COUNT];
+TaskHandle_t dmxInputTaskHandles[ART_NET_OUTPUT_UNIVERSE_COUNT];
 
 
 void onDmxDataSend(uint8_t universe, uint8_t ctrlByte, const uint8_t *data, const uint16_t size) {
-  if (size <= DMX_MAX_CHANNELS) { 
-    memcpy(dmxWriteDataBuffer, dmxReadDataBuffer, 513);
-    dmxWriteDataBuffer[0] = ctrlByte;
-    memcpy(&dmxWriteDataBuffer[1], data, size);
-    dmxWriteDataBufferHasNewData = 1;
+  if (size <= DMX_MAX_CHANNELS && universe < ART_NET_OUTPUT_UNIVERSE_COUNT) { 
+    if (ctrlByte != 0) {
+      // Messages for downstream gear, sent as is between the NSC frames.
+      dmxNzsQueues[universe].push(ctrlByte, data, size);
+      return;
+    }
+
+    DmxFrameBuffer *frameBuffer = &dmxFrameBuffers[universe];
+    DmxProcessor *processor = &dmxProcessors[universe];
+
+    processor->process(data, size, frameBuffer->beginWrite(0, processor->getOutputLength(size)));
+    frameBuffer->stageWrite();
+  }
+}
+
+// Publishes the staged frames of the ports in `portMask`, bit n for port n.
+void onDmxDataCommit(uint32_t portMask) {
+  unsigned long now = millis();
+
+  for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    // The input task is the writer of input ports.
+    if (!(portMask & (1UL << i)) || MyArtNet.portMode[i] != PortMode::Output || !dmxFrameBuffers[i].publish()) {
+      continue;
+    }
+
+    if (i == jitterPort) {
+      arrivalJitter[bluetoothWindow.isOn()].record(micros());
+    }
+
+    // Live data always wins over the stored show.
+    lastNetworkFrameMillis = now;
+    dmxShowFailoverArmed = 1;
+    dmxShowPlayer.stop();
+
+    // Only queued in RAM, saveDmxShow() writes it.
+    if (dmxShowRecorder.isRecording()) {
+      dmxShowRecorder.record(i, dmxFrameBuffers[i].getLatestFrame(), dmxFrameBuffers[i].getLatestSize(), now);
+    }
   }
 }
 
@@ -61,42 +310,781 @@ void sendAtrNetPacket(uint32_t dstIP, uint16_t dstPort, const uint8_t *data, uin
   UDP.endPacket();
 }
 
+inline void NodeArtNetSink::sendPacket(uint32_t dstIP, uint16_t dstPort, const uint8_t *data, uint32_t size) {
+  sendAtrNetPacket(dstIP, dstPort, data, size);
+}
+
+inline void NodeArtNetSink::onDmxData(uint8_t universe, uint8_t startCode, const uint8_t *data, uint16_t size) {
+  onDmxDataSend(universe, startCode, data, size);
+}
+
+// ArtNet frames go out all together, at once or on ArtSync.
+inline void NodeArtNetSink::onDmxCommit() {
+  onDmxDataCommit((1UL << ART_NET_OUTPUT_UNIVERSE_COUNT) - 1);
+}
+
+// Break of one port, timed by a one-shot esp_timer. The output task sleeps
+// on a notification meanwhile instead of busy waiting.
+class DmxPortLineHal : public DmxLineHal {
+  public:
+    void begin(DmxOutputPort *port, DmxBreakTimer *breakTimer) {
+      this->port = port;
+      task = xTaskGetCurrentTaskHandle();
+
+      esp_timer_create_args_t timerArgs = {};
+      timerArgs.callback = onTimerExpired;
+      timerArgs.arg = breakTimer;
+      timerArgs.dispatch_method = ESP_TIMER_TASK;
+      timerArgs.name = "dmx_break";
+      esp_timer_create(&timerArgs, &timer);
+
+      breakTimer->begin(this);
+    }
+
+    void setBreak(bool active) override {
+      if (port->breakPin >= 0) {
+        if (active) {
+          pinMode(port->breakPin, INPUT);
+        } else {
+          pinMode(port->breakPin, OUTPUT);
+          digitalWrite(port->breakPin, LOW);
+        }
+      } else {
+        uart_set_line_inverse(port->uartNum, active ? UART_SIGNAL_TXD_INV : UART_SIGNAL_INV_DISABLE);
+      }
+    }
+
+    void startTimer(uint32_t micros) override {
+      esp_timer_start_once(timer, micros);
+    }
+
+    void signalDone() override {
+      xTaskNotifyGive(task);
+    }
+  private:
+    DmxOutputPort *port;
+    TaskHandle_t task;
+    esp_timer_handle_t timer;
+
+    static void onTimerExpired(void *arg) {
+      ((DmxBreakTimer*)arg)->onTimer();
+    }
+};
+
+DmxBreakTimer dmxBreakTimers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+DmxPortLineHal dmxLineHals[ART_NET_OUTPUT_UNIVERSE_COUNT];
+
+void sendDmxBreak(uint8_t portIndex) {
+  dmxBreakTimers[portIndex].start();
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+// One task per output port, owning its UART and the read side of its frame
+// buffer. Frames are sent back to back while new data arrives, otherwise the
+// last one is repeated as keep alive.
+void dmxOutputTask(void *param) {
+  uint8_t portIndex = (uintptr_t)param;
+  DmxOutputPort *port = &dmxOutputPorts[portIndex];
+  DmxOutputScheduler *scheduler = &dmxOutputSchedulers[portIndex];
+  OutputStats *stats = &MyArtNet.outputStats[portIndex];
+  unsigned long rateWindowStart = millis();
+  uint16_t rateWindowFrames = 0;
+
+  scheduler->begin(&dmxFrameBuffers[portIndex], &dmxNzsQueues[portIndex], &dmxInterpolators[portIndex]);
+  dmxLineHals[portIndex].begin(port, &dmxBreakTimers[portIndex]);
+
+  for (;;) {
+    DmxFrameKind frameKind = scheduler->next(millis(), settings->channelCount);
+
+    if (frameKind != DmxFrameKind::None) {
+      if (frameKind == DmxFrameKind::Fresh) {
+        stats->framesSwapped++;
+      } else if (frameKind == DmxFrameKind::NonZeroStartCode) {
+        stats->nzsFrames++;
+      } else if (frameKind == DmxFrameKind::Interpolated) {
+        stats->interpolated++;
+      } else {
+        stats->keepAlives++;
+      }
+
+      PROFILE_STAGE(&outputStageHistograms[portIndex][OUTPUT_STAGE_BREAK], sendDmxBreak(portIndex));
+
+      // Blocks in the UART driver until the frame is queued, then until it is out.
+      PROFILE_STAGE(&outputStageHistograms[portIndex][OUTPUT_STAGE_FILL], {
+        port->serial->write(scheduler->getFrame(), scheduler->getFrameLength());
+        port->serial->flush();
+
+        while (!uart_ll_is_tx_idle(UART_LL_GET_HW(port->uartNum))) {
+          taskYIELD();
+        }
+      });
+
+      // Refresh rate of the NSC stream, what fixtures see.
+      if (frameKind != DmxFrameKind::NonZeroStartCode) {
+        rateWindowFrames++;
+      }
+    } else {
+      vTaskDelay(1);
+    }
+
+    if (millis() - rateWindowStart >= 1000) {
+      stats->refreshRate = rateWindowFrames * 1000UL / (millis() - rateWindowStart);
+      rateWindowStart = millis();
+      rateWindowFrames = 0;
+    }
+  }
+}
+
+// One task per input port, owning its UART and the write side of its frame
+// buffer. With the RX FIFO threshold at one byte every byte is handed over as
+// it arrives, so the data events before a UART_BREAK event hold exactly the
+// bytes of the frame it ends (break byte included). They are only counted
+// and read in one go at the break.
+void dmxInputTask(void *param) {
+  uint8_t portIndex = (uintptr_t)param;
+  DmxOutputPort *port = &dmxOutputPorts[portIndex];
+  DmxInputDecoder *decoder = &dmxInputDecoders[portIndex];
+  uart_port_t uartNum = (uart_port_t)port->uartNum;
+  QueueHandle_t events;
+
+  uart_config_t config = {};
+  config.baud_rate = 250000;
+  config.data_bits = UART_DATA_8_BITS;
+  config.parity = UART_PARITY_DISABLE;
+  config.stop_bits = UART_STOP_BITS_2;
+  config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+
+  uart_driver_install(uartNum, DMX_INPUT_RX_BUFFER_SIZE, 0, DMX_INPUT_EVENT_QUEUE_SIZE, &events, 0);
+  uart_param_config(uartNum, &config);
+  uart_set_pin(uartNum, UART_PIN_NO_CHANGE, port->rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+  uart_set_rx_full_threshold(uartNum, 1);
+
+  decoder->begin(&dmxFrameBuffers[portIndex]);
+
+  uint8_t data[128];
+  size_t pending = 0;
+  uart_event_t event;
+
+  for (;;) {
+    if (xQueueReceive(events, &event, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+
+    switch (event.type) {
+      case UART_DATA:
+        pending += event.size;
+        break;
+      case UART_BREAK:
+        while (pending) {
+          int count = uart_read_bytes(uartNum, data, pending < sizeof(data) ? pending : sizeof(data), 0);
+
+          if (count <= 0) {
+            break;
+          }
+
+          decoder->onData(data, count);
+          pending -= count;
+        }
+
+        pending = 0;
+        decoder->onBreak();
+        break;
+      case UART_FIFO_OVF:
+      case UART_BUFFER_FULL:
+        uart_flush_input(uartNum);
+        xQueueReset(events);
+        pending = 0;
+        decoder->onError();
+        break;
+      default:
+        // The break also shows up as a framing error, nothing to do.
+        break;
+    }
+  }
+}
+
+// Sends the DMX received on input ports as ArtDmx, from the loop like every
+// other UDP send.
+void sendDmxInputs() {
+  unsigned long now = millis();
+
+  for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    if (MyArtNet.portMode[i] != PortMode::Input) {
+      continue;
+    }
+
+    DmxInputScheduler *scheduler = &dmxInputSchedulers[i];
+    DmxFrameKind frameKind = scheduler->next(now);
+
+    if (frameKind != DmxFrameKind::None && WiFi.isConnected()) {
+      MyArtNet.sendDmx(i, dmxInputDestinationIP, scheduler->getData(), scheduler->getLength());
+    }
+
+    const DmxInputStats *stats = &dmxInputDecoders[i].stats;
+    uint8_t goodInput = scheduler->isReceiving(now) ? ART_NET_GOOD_INPUT_DATA : 0;
+
+    if (stats->errors || stats->overruns) {
+      goodInput |= ART_NET_GOOD_INPUT_ERRORS;
+    }
+
+    MyArtNet.goodInput[i] = goodInput;
+  }
+}
+
+// Writes the frames of the stored show that are due, taking over from the
+// network after DMX_SHOW_FAILOVER_TIMEOUT_MS without data. The loop is the
+// writer of output frame buffers, like for network data.
+void playDmxShow() {
+  unsigned long now = millis();
+
+  if (!dmxShowPlayer.isPlaying()) {
+    if (
+      dmxShowFailoverArmed &&
+      dmxShowPlayer.hasShow() &&
+      !dmxShowRecorder.isRecording() &&
+      now - lastNetworkFrameMillis >= DMX_SHOW_FAILOVER_TIMEOUT_MS
+    ) {
+      dmxShowPlayer.start(now);
+    }
+
+    return;
+  }
+
+  while (dmxShowPlayer.next(now)) {
+    uint8_t port = dmxShowPlayer.getPort();
+    uint16_t length = dmxShowPlayer.getLength();
+
+    if (port < ART_NET_OUTPUT_UNIVERSE_COUNT && MyArtNet.portMode[port] == PortMode::Output) {
+      memcpy(dmxFrameBuffers[port].beginWrite(0, length), dmxShowPlayer.getFrame(), length);
+      dmxFrameBuffers[port].commitWrite();
+    }
+  }
+}
+
+// Writes the recorded frames to the flash in a stage of their own: a write or
+// an erase stops the flash cache, which must not happen in the middle of the
+// network receive.
+void saveDmxShow() {
+  // Ends by itself once the flash is full.
+  if (dmxShowRecorder.isRecording() && !dmxShowRecorder.update()) {
+    dmxShowPlayer.load();
+  }
+}
+
+// The sACN socket is bound to any address, so it gets the data of every
+// group joined on the interface.
+void joinSacnGroups() {
+  if (sacnGroupSocket >= 0) {
+    close(sacnGroupSocket);
+  }
+
+  sacnGroupSocket = socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (sacnGroupSocket < 0) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    if (MyE131.portUniverse[i] == 0) {
+      continue;
+    }
+
+    struct ip_mreq group;
+    group.imr_multiaddr.s_addr = E131::getMulticastGroup(MyE131.portUniverse[i]);
+    group.imr_interface.s_addr = htonl(INADDR_ANY);
+    setsockopt(sacnGroupSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group));
+  }
+}
+
+void applyArtNetSettings() {
+  MyArtNet.net = settings->net;
+  MyArtNet.subnet = settings->subuni >> 4;
+  strncpy(MyArtNet.shortName, settings->nodeShortName[0] ? settings->nodeShortName : ART_NET_SHORT_NAME, ART_NET_SHORT_NAME_SIZE - 1);
+  strncpy(MyArtNet.longName, settings->nodeLongName[0] ? settings->nodeLongName : ART_NET_LONG_NAME, ART_NET_LONG_NAME_SIZE - 1);
+
+  for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    MyArtNet.portUniverse[i] = settings->portUniverse[i];
+    MyArtNet.mergers[i].mode = (MergeMode) settings->portMergeMode[i];
+    // sACN universes start at 1: universe N is ArtNet port address N - 1.
+    // Universe 0 is never received, input ports only send ArtDmx.
+    if (MyArtNet.portMode[i] == PortMode::Input) {
+      MyE131.portUniverse[i] = 0;
+    } else {
+      MyE131.portUniverse[i] = (((uint16_t)settings->net << 8) | (settings->subuni & 0xF0) | settings->portUniverse[i]) + 1;
+    }
+  }
+
+  if (WiFi.isConnected()) {
+    joinSacnGroups();
+  }
+}
+
+// Takes what ArtAddress changed into the settings right away, so sACN follows
+// the new addressing, and saves them once the console is done, away from the
+// packet path.
+void saveArtAddress() {
+  if (MyArtNet.addressChanges != seenAddressChanges) {
+    seenAddressChanges = MyArtNet.addressChanges;
+    lastAddressChangeMillis = millis();
+    addressSavePending = 1;
+
+    settings->net = MyArtNet.net;
+    settings->subuni = (MyArtNet.subnet << 4) | (settings->subuni & 0x0F);
+    strncpy(settings->nodeShortName, MyArtNet.shortName, sizeof(settings->nodeShortName) - 1);
+    strncpy(settings->nodeLongName, MyArtNet.longName, sizeof(settings->nodeLongName) - 1);
+
+    for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+      settings->portUniverse[i] = MyArtNet.portUniverse[i];
+      settings->portMergeMode[i] = (uint8_t) MyArtNet.mergers[i].mode;
+    }
+
+    applyArtNetSettings();
+  }
+
+  if (addressSavePending && millis() - lastAddressChangeMillis >= ART_ADDRESS_SAVE_DELAY_MS) {
+    addressSavePending = 0;
+    EEPROM_DataStore();
+  }
+}
+
 void setup() {
+#if ART_NET_OUTPUT_UNIVERSE_COUNT > 2
+  // UART0 is also the console: keep the core and IDF logs off port 3. The
+  // boot ROM still prints at 115200 before this runs.
+  Serial.setDebugOutput(false);
+  esp_log_level_set("*", ESP_LOG_NONE);
+#endif
+
   pinMode(LED_CATHODE_PIN, OUTPUT);
   digitalWrite(LED_CATHODE_PIN, LOW);
 
   pinMode(RESET_PREFERENCES_PIN, INPUT_PULLDOWN);
 
-  Serial2.begin(250000, SERIAL_8N2);
+  const esp_partition_t *dataPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
 
-  EEPROM_DataInitialize();
+  if (dataPartition && dataPartition->size > SETTINGS_FLASH_SIZE) {
+    uint32_t showFlashSize = dataPartition->size - SETTINGS_FLASH_SIZE;
+
+    dmxShowFlash.begin(dataPartition, 0, showFlashSize);
+    settingsFlash.begin(dataPartition, showFlashSize, SETTINGS_FLASH_SIZE);
+  }
+
+  EEPROM_DataInitialize(&settingsFlash);
 
   if (digitalRead(RESET_PREFERENCES_PIN) == HIGH) {
     EEPROM_DataReset();
   }
 
-  SerialBT.begin("ArtNet Mini ESP32");
+  SerialBT.begin(BLUETOOTH_DEVICE_NAME);
+  bluetoothWindow.begin(BLUETOOTH_WINDOW_MS, millis());
+  bluetoothOnFreeHeap = ESP.getFreeHeap();
 
   settings = EEPROM_DataGet();
+
+  // Port direction only changes on boot, the UART and the task depend on it.
+  for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    MyArtNet.portMode[i] = settings->portMode[i] == PORT_MODE_INPUT ? PortMode::Input : PortMode::Output;
+
+    if (MyArtNet.portMode[i] == PortMode::Input) {
+      dmxInputSchedulers[i].begin(&dmxFrameBuffers[i]);
+    } else {
+      dmxOutputPorts[i].serial->begin(250000, SERIAL_8N2, -1, dmxOutputPorts[i].txPin);
+
+      if (jitterPort < 0) {
+        jitterPort = i;
+      }
+    }
+  }
+
   settingReloadWiFi = 1;
   lastSettingsAuthFail = 0;
   lastSettingsAuthFailCount = 0;
-  bluetoothRequestType = BLUETOOTH_REQUEST_TYPE_NONE;
-  lastBTReceivedData = 0;
+  bluetoothFrameParser.timeoutMs = BLUETOOTH_DATA_RECEIVE_TIMEOUT_MILLIS;
 
   lastWiFiStatus = WiFi.status();
 
-  MyArtNet.net = settings->net;
-  MyArtNet.subnet = settings->subuni >> 4;
-  MyArtNet.setDmxDataCallback(onDmxDataSend);
-  MyArtNet.setSendPacketCallback(sendAtrNetPacket);
-
-  dmxWriteDataBuffer = dmxDataBuffers[0];
-  dmxReadDataBuffer = dmxDataBuffers[1];
-  dmxWriteDataBufferHasNewData = 0;
-  currentWriteBufferIndex = 0;
-  lastTransmit = 0;
-  breakStartedAt = 0;
+  dmxShowRecorder.begin(&dmxShowFlash);
+  dmxShowPlayer.begin(&dmxShowFlash);
+  lastNetworkFrameMillis = millis();
+
+  applyArtNetSettings();
+  MyE131.setDmxDataCallback(onDmxDataSend);
+  MyE131.setDmxCommitCallback(onDmxDataCommit);
+
+  for (uint32_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    if (MyArtNet.portMode[i] == PortMode::Input) {
+      xTaskCreatePinnedToCore(dmxInputTask, "dmx_input", DMX_INPUT_TASK_STACK_SIZE, (void*)i, DMX_OUTPUT_TASK_PRIORITY, &dmxInputTaskHandles[i], DMX_OUTPUT_TASK_CORE);
+    } else {
+      xTaskCreatePinnedToCore(dmxOutputTask, "dmx_output", DMX_OUTPUT_TASK_STACK_SIZE, (void*)i, DMX_OUTPUT_TASK_PRIORITY, &dmxOutputTaskHandles[i], DMX_OUTPUT_TASK_CORE);
+    }
+  }
+}
+
+uint8_t applyProcessingRequest(BluetoothProcessingRequest *request) {
+  DmxProcessor *processor = &dmxProcessors[request->port];
+  DmxInterpolator *interpolator = &dmxInterpolators[request->port];
+  uint16_t channel = request->channel - 1;
+
+  switch (request->command) {
+    case BLUETOOTH_PROCESSING_PATCH:
+      if (channel >= DMX_MAX_CHANNELS || request->value > DMX_MAX_CHANNELS) {
+        return 0;
+      }
+
+      processor->setPatch(channel, request->value ? request->value - 1 : DMX_PROCESSOR_UNPATCHED);
+      return 1;
+    case BLUETOOTH_PROCESSING_CURVE:
+      if (channel >= DMX_MAX_CHANNELS || (request->value & 0xFF) >= (uint8_t)DmxCurve::Count) {
+        return 0;
+      }
+
+      processor->setCurve(channel, (DmxCurve)(request->value & 0xFF), request->value & 0x100);
+      return 1;
+    case BLUETOOTH_PROCESSING_MASTER:
+      if (request->value > 255) {
+        return 0;
+      }
+
+      processor->setMaster(request->value);
+      return 1;
+    case BLUETOOTH_PROCESSING_RESET:
+      processor->reset();
+      interpolator->enabled = 0;
+      interpolator->reset();
+      return 1;
+    case BLUETOOTH_PROCESSING_SMOOTHING:
+      if (request->value > 1) {
+        return 0;
+      }
+
+      interpolator->enabled = request->value;
+      return 1;
+    case BLUETOOTH_PROCESSING_SMOOTHING_EXCLUDE:
+      if (channel >= DMX_MAX_CHANNELS || request->value > 1) {
+        return 0;
+      }
+
+      interpolator->setExcluded(channel, request->value);
+      return 1;
+  }
+
+  return 0;
+}
+
+uint8_t applyShowRequest(BluetoothShowRequest *request) {
+  unsigned long now = millis();
+
+  switch (request->command) {
+    case BLUETOOTH_SHOW_STOP:
+      dmxShowFailoverArmed = 0;
+      dmxShowPlayer.stop();
+      dmxShowRecorder.stop(now);
+      dmxShowPlayer.load();
+      return 1;
+    case BLUETOOTH_SHOW_RECORD:
+      dmxShowPlayer.stop();
+      return dmxShowRecorder.start(now);
+    case BLUETOOTH_SHOW_PLAY:
+      if (dmxShowRecorder.isRecording()) {
+        return 0;
+      }
+
+      return dmxShowPlayer.start(now);
+    case BLUETOOTH_SHOW_ERASE:
+      dmxShowRecorder.stop(now);
+      dmxShowFlash.eraseSector(0);
+      dmxShowPlayer.load();
+      return 1;
+  }
+
+  return 0;
+}
+
+void printBluetoothInfo() {
+  SerialBT.print("Channel Count: ");
+  SerialBT.println(settings->channelCount);
+  SerialBT.print("ArtNet NET: ");
+  SerialBT.println(settings->net);
+  SerialBT.print("ArtNet Subnet: ");
+  SerialBT.println(settings->subuni >> 4);
+  SerialBT.print("ArtNet Name: ");
+  SerialBT.print(MyArtNet.shortName);
+  SerialBT.print(" / ");
+  SerialBT.println(MyArtNet.longName);
+
+  for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    SerialBT.print("ArtNet Universe Port ");
+    SerialBT.print(i + 1);
+    SerialBT.print(": ");
+    SerialBT.print(settings->portUniverse[i]);
+    SerialBT.print(settings->portMode[i] == PORT_MODE_INPUT ? " (input)" : " (output)");
+    SerialBT.println(settings->portMergeMode[i] == (uint8_t) MergeMode::Ltp ? " LTP" : " HTP");
+  }
+
+  SerialBT.print("WiFi Mode: ");
+
+  switch (settings->wirelessMode) {
+    case WIRELESS_MODE_UNINITIALIZED:
+      SerialBT.println("Wireless not initialized.");
+      break;
+    case WIRELESS_MODE_CLIENT_DHCP:
+      SerialBT.println("Client DHCP");
+      break;
+    case WIRELESS_MODE_AP:
+      SerialBT.println("AP");
+      break;
+  }
+
+  SerialBT.print("WiFi Local IP: ");
+  SerialBT.println(WiFi.localIP().toString());
+  
+  SerialBT.print("WiFi SSID: ");
+  SerialBT.println(settings->wirelessSSID);
+
+  SerialBT.print("WiFi Status: ");
+  switch (WiFi.status()) {
+    case WL_IDLE_STATUS:
+      SerialBT.println("WL_IDLE_STATUS");
+      break;
+    case WL_CONNECT_FAILED:
+      SerialBT.println("WL_CONNECT_FAILED");
+      break;
+    case WL_CONNECTED:
+      SerialBT.println("WL_CONNECTED");
+      break;
+    case WL_CONNECTION_LOST:
+      SerialBT.println("WL_CONNECTION_LOST");
+      break;
+    case WL_DISCONNECTED:
+      SerialBT.println("WL_DISCONNECTED");
+      break;
+    case WL_NO_SSID_AVAIL:
+      SerialBT.println("WL_NO_SSID_AVAIL");
+      break;
+  }
+
+  static char statsText[768];
+  MyArtNet.formatStats(statsText, sizeof(statsText));
+  SerialBT.print(statsText);
+
+  MyE131.formatStats(statsText, sizeof(statsText));
+  SerialBT.print(statsText);
+
+  SerialBT.print("Receive Budget Stops: ");
+  SerialBT.println(MyReceiver.stats.budgetStops + MySacnReceiver.stats.budgetStops);
+
+  const BluetoothFrameStats *frameStats = &bluetoothFrameParser.stats;
+  snprintf(statsText, sizeof(statsText), "Bluetooth: %" PRIu32 " requests, %" PRIu32 " CRC errors, %" PRIu32 " length errors, %" PRIu32 " timeouts\r\n",
+    frameStats->frames, frameStats->crcErrors, frameStats->lengthErrors, frameStats->timeouts);
+  SerialBT.print(statsText);
+
+  for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    if (MyArtNet.portMode[i] == PortMode::Input) {
+      const DmxInputStats *inputStats = &dmxInputDecoders[i].stats;
+      const DmxInputSchedulerStats *sendStats = &dmxInputSchedulers[i].stats;
+
+      snprintf(statsText, sizeof(statsText),
+        "Port %u Input: %" PRIu32 " frames, %" PRIu32 " NZS, %" PRIu32 " empty, %" PRIu32 " overruns, %" PRIu32 " errors, "
+        "%" PRIu32 " changes sent, %" PRIu32 " keep alive, %" PRIu32 " coalesced\r\n",
+        i + 1, inputStats->frames, inputStats->nzsFrames, inputStats->emptyFrames, inputStats->overruns, inputStats->errors,
+        sendStats->changesSent, sendStats->keepAlivesSent, sendStats->coalesced);
+      SerialBT.print(statsText);
+      continue;
+    }
+
+    SerialBT.print("Port ");
+    SerialBT.print(i + 1);
+    SerialBT.print(" Master: ");
+    SerialBT.print(dmxProcessors[i].getMaster());
+    SerialBT.print(dmxProcessors[i].isPassthrough() ? ", passthrough" : ", processing");
+
+    if (dmxInterpolators[i].enabled) {
+      SerialBT.print(", smoothing over ");
+      SerialBT.print(dmxInterpolators[i].getInterval());
+      SerialBT.print(" ms");
+    }
+
+    SerialBT.println();
+  }
+
+  if (bluetoothWindow.windowMs) {
+    snprintf(statsText, sizeof(statsText), "Bluetooth Window: %" PRIu32 " s, %" PRIu32 " stops\r\n",
+      bluetoothWindow.windowMs / 1000, bluetoothWindow.stops);
+  } else {
+    snprintf(statsText, sizeof(statsText), "Bluetooth Window: always on\r\n");
+  }
+  SerialBT.print(statsText);
+
+  snprintf(statsText, sizeof(statsText), "Free Heap: %" PRIu32 " now, %" PRIu32 " min, %" PRIu32 " with Bluetooth, %" PRIu32 " without\r\n",
+    ESP.getFreeHeap(), ESP.getMinFreeHeap(), bluetoothOnFreeHeap, bluetoothOffFreeHeap);
+  SerialBT.print(statsText);
+
+  if (jitterPort >= 0) {
+    arrivalJitter[0].format(statsText, sizeof(statsText), "Arrival Bluetooth off");
+    SerialBT.print(statsText);
+    arrivalJitter[1].format(statsText, sizeof(statsText), "Arrival Bluetooth on");
+    SerialBT.print(statsText);
+  }
+
+  SerialBT.print("Show: ");
+
+  if (dmxShowRecorder.isRecording()) {
+    snprintf(statsText, sizeof(statsText), "recording, %" PRIu32 " of %" PRIu32 " bytes\r\n",
+      dmxShowRecorder.getRecordedBytes(), dmxShowFlash.getSize() - DMX_SHOW_DATA_OFFSET);
+    SerialBT.print(statsText);
+  } else if (dmxShowPlayer.hasShow()) {
+    const DmxShowHeader *header = dmxShowPlayer.getHeader();
+
+    snprintf(statsText, sizeof(statsText), "%" PRIu32 " s, %" PRIu32 " frames, %" PRIu32 " bytes%s\r\n",
+      header->durationMs / 1000, header->records, header->length, dmxShowPlayer.isPlaying() ? ", playing" : "");
+    SerialBT.print(statsText);
+  } else {
+    SerialBT.println("none");
+  }
+
+#if STAGE_PROFILER_ENABLED
+  for (uint8_t i = 0; i < LOOP_STAGE_COUNT; i++) {
+    loopStageHistograms[i].format(statsText, sizeof(statsText), loopStageNames[i]);
+    SerialBT.print(statsText);
+  }
+
+  for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+    for (uint8_t j = 0; j < OUTPUT_STAGE_COUNT; j++) {
+      SerialBT.print("Port ");
+      SerialBT.print(i + 1);
+      SerialBT.print(" ");
+      outputStageHistograms[i][j].format(statsText, sizeof(statsText), outputStageNames[j]);
+      SerialBT.print(statsText);
+    }
+  }
+#endif
+}
+
+void bluetoothAuthFailed() {
+  lastSettingsAuthFail = millis();
+  lastSettingsAuthFailCount++;
+}
+
+void bluetoothAuthPassed() {
+  lastSettingsAuthFail = 0;
+  lastSettingsAuthFailCount = 0;
+}
+
+void changeSettingsFromBluetooth(const uint8_t *payload) {
+  memcpy(&tempSettings, payload, EEPROM_DATA_BLUETOOTH_SIZE);
+  // Only set over ArtNet.
+  memcpy(((uint8_t*)&tempSettings) + EEPROM_DATA_BLUETOOTH_SIZE, ((uint8_t*)settings) + EEPROM_DATA_BLUETOOTH_SIZE, sizeof(EEPROM_Data) - EEPROM_DATA_BLUETOOTH_SIZE);
+
+  const char *err;
+
+  if (!EEPROM_DataIsValid(&tempSettings, &err)) {
+    SerialBT.println("[ER] Settings are invalid! Rolled back.");
+    SerialBT.println(err);
+    return;
+  }
+
+  if (strncmp(tempSettings.systemPassword, settings->systemPassword, SYSTEM_PASSWORD_MAX_LENGTH)) {
+    bluetoothAuthFailed();
+    return;
+  }
+
+  bluetoothAuthPassed();
+
+  if (settings->wirelessMode != tempSettings.wirelessMode || strcmp(settings->wirelessSSID, tempSettings.wirelessSSID) || strcmp(settings->wirelessPassword, tempSettings.wirelessPassword)) {
+    settingReloadWiFi = 1;
+  }
+
+  memcpy(settings, &tempSettings, sizeof(EEPROM_Data));
+  EEPROM_DataStore();
+
+  applyArtNetSettings();
+
+  SerialBT.println("[OK] Settings Loaded!");
+}
+
+void changePasswordFromBluetooth(const BluetoothPasswordRequest *request) {
+  if (strncmp(request->oldPassword, settings->systemPassword, SYSTEM_PASSWORD_MAX_LENGTH)) {
+    bluetoothAuthFailed();
+    return;
+  }
+
+  bluetoothAuthPassed();
+  memcpy(settings->systemPassword, request->newPassword, SYSTEM_PASSWORD_MAX_LENGTH);
+  settings->systemPassword[SYSTEM_PASSWORD_MAX_LENGTH] = 0;
+  EEPROM_DataStore();
+  SerialBT.println("[OK] Password Changed!");
+}
+
+void changeProcessingFromBluetooth(const uint8_t *payload) {
+  BluetoothProcessingRequest request;
+  memcpy(&request, payload, sizeof(BluetoothProcessingRequest));
+
+  if (strncmp(request.systemPassword, settings->systemPassword, SYSTEM_PASSWORD_MAX_LENGTH)) {
+    bluetoothAuthFailed();
+    return;
+  }
+
+  bluetoothAuthPassed();
+
+  if (request.port < ART_NET_OUTPUT_UNIVERSE_COUNT && applyProcessingRequest(&request)) {
+    SerialBT.println("[OK] Processing Changed!");
+  } else {
+    SerialBT.println("[ER] Processing request is invalid!");
+  }
+}
+
+void changeShowFromBluetooth(const uint8_t *payload) {
+  BluetoothShowRequest request;
+  memcpy(&request, payload, sizeof(BluetoothShowRequest));
+
+  if (strncmp(request.systemPassword, settings->systemPassword, SYSTEM_PASSWORD_MAX_LENGTH)) {
+    bluetoothAuthFailed();
+    return;
+  }
+
+  bluetoothAuthPassed();
+
+  if (applyShowRequest(&request)) {
+    SerialBT.println("[OK] Show Changed!");
+  } else {
+    SerialBT.println("[ER] Show request failed!");
+  }
+}
+
+void handleBluetoothFrame(uint8_t type, const uint8_t *payload, uint16_t length) {
+  bluetoothWindow.touch(millis());
+
+  switch (type) {
+    case BLUETOOTH_REQUEST_TYPE_GET_INFO:
+      printBluetoothInfo();
+      return;
+    case BLUETOOTH_REQUEST_TYPE_CHANGE_SETTINGS:
+      if (length == EEPROM_DATA_BLUETOOTH_SIZE) {
+        changeSettingsFromBluetooth(payload);
+        return;
+      }
+      break;
+    case BLUETOOTH_REQUEST_TYPE_CHANGE_PASSWORD:
+      if (length == sizeof(BluetoothPasswordRequest)) {
+        changePasswordFromBluetooth((const BluetoothPasswordRequest*) payload);
+        return;
+      }
+      break;
+    case BLUETOOTH_REQUEST_TYPE_CHANGE_PROCESSING:
+      if (length == sizeof(BluetoothProcessingRequest)) {
+        changeProcessingFromBluetooth(payload);
+        return;
+      }
+      break;
+    case BLUETOOTH_REQUEST_TYPE_SHOW:
+      if (length == sizeof(BluetoothShowRequest)) {
+        changeShowFromBluetooth(payload);
+        return;
+      }
+      break;
+  }
+
+  SerialBT.println("[ER] Protocol Fail");
 }
 
 void loadSettingsFromBluetooth() {
@@ -104,7 +1092,9 @@ void loadSettingsFromBluetooth() {
     if (millis() - lastSettingsAuthFail > (1000 * lastSettingsAuthFailCount)) {
       SerialBT.println("[ER] BAD Password");
 
+      // Along with whatever was sent meanwhile.
       while (SerialBT.available()) { SerialBT.read(); }
+      bluetoothFrameParser.reset();
 
       lastSettingsAuthFail = 0;
 
@@ -112,135 +1102,56 @@ void loadSettingsFromBluetooth() {
         lastSettingsAuthFailCount = 200;
       }
     }
-  } else if (bluetoothRequestType == BLUETOOTH_REQUEST_TYPE_NONE && SerialBT.available()) { 
-    bluetoothRequestType = SerialBT.read();
-    lastBTReceivedData = 0;
-    
-    if (
-      bluetoothRequestType != BLUETOOTH_REQUEST_TYPE_CHANGE_SETTINGS && 
-      bluetoothRequestType != BLUETOOTH_REQUEST_TYPE_CHANGE_PASSWORD &&
-      bluetoothRequestType != BLUETOOTH_REQUEST_TYPE_GET_INFO
-    ) {
-      bluetoothRequestType = BLUETOOTH_REQUEST_TYPE_NONE;
-      while (SerialBT.available()) { SerialBT.read(); }
-    }
 
-    if (bluetoothRequestType == BLUETOOTH_REQUEST_TYPE_GET_INFO) {
-      SerialBT.print("Channel Count: ");
-      SerialBT.println(settings->channelCount);
-      SerialBT.print("ArtNet NET: ");
-      SerialBT.println(settings->net);
-      SerialBT.print("ArtNet Subnet: ");
-      SerialBT.println(settings->subuni >> 4);
-      SerialBT.print("ArtNet Universe: ");
-      SerialBT.println(settings->subuni & 0xF);
-
-      SerialBT.print("WiFi Mode: ");
-
-      switch (settings->wirelessMode) {
-        case WIRELESS_MODE_UNINITIALIZED:
-          SerialBT.println("Wireless not initialized.");
-          break;
-        case WIRELESS_MODE_CLIENT_DHCP:
-          SerialBT.println("Client DHCP");
-          break;
-        case WIRELESS_MODE_AP:
-          SerialBT.println("AP");
-          break;
-      }
+    return;
+  }
 
-      SerialBT.print("WiFi Local IP: ");
-      SerialBT.println(WiFi.localIP().toString());
-      
-      SerialBT.print("WiFi SSID: ");
-      SerialBT.println(settings->wirelessSSID);
-
-      SerialBT.print("WiFi Status: ");
-      switch (WiFi.status()) {
-        case WL_IDLE_STATUS:
-          SerialBT.println("WL_IDLE_STATUS");
-          break;
-        case WL_CONNECT_FAILED:
-          SerialBT.println("WL_CONNECT_FAILED");
-          break;
-        case WL_CONNECTED:
-          SerialBT.println("WL_CONNECTED");
-          break;
-        case WL_CONNECTION_LOST:
-          SerialBT.println("WL_CONNECTION_LOST");
-          break;
-        case WL_DISCONNECTED:
-          SerialBT.println("WL_DISCONNECTED");
-          break;
-        case WL_NO_SSID_AVAIL:
-          SerialBT.println("WL_NO_SSID_AVAIL");
-          break;
-      }
-      
-      bluetoothRequestType = BLUETOOTH_REQUEST_TYPE_NONE;
-    }
-  } else if (SerialBT.available() > sizeof(EEPROM_Data)) {
-    while (SerialBT.available()) { SerialBT.read(); }
-    SerialBT.println("[ER] Protocol Fail");
-  } else if (bluetoothRequestType == BLUETOOTH_REQUEST_TYPE_CHANGE_SETTINGS && SerialBT.available() == sizeof(EEPROM_Data)) {
-    lastBTReceivedData = 0;
-    SerialBT.readBytes((uint8_t*)&tempSettings, sizeof(EEPROM_Data));
+  unsigned long now = millis();
 
-    char *err;
+  if (bluetoothFrameParser.expire(now)) {
+    SerialBT.println("[ER] Read Timeout");
+  }
 
-    if (EEPROM_DataIsValid(&tempSettings, &err)) {
-      if (strncmp(tempSettings.systemPassword, settings->systemPassword, SYSTEM_PASSWORD_MAX_LENGTH) == 0) {
-        lastSettingsAuthFail = 0;
-        lastSettingsAuthFailCount = 0;
+  // A frame not all there yet goes on in the next loop. At most one request
+  // is handled per loop.
+  for (uint16_t i = 0; i < BLUETOOTH_READ_BUDGET && SerialBT.available(); i++) {
+    BluetoothFrameResult result = bluetoothFrameParser.push(SerialBT.read(), now);
 
-        if (settings->wirelessMode != tempSettings.wirelessMode || strcmp(settings->wirelessSSID, tempSettings.wirelessSSID) || strcmp(settings->wirelessPassword, tempSettings.wirelessPassword)) {
-          settingReloadWiFi = 1;
-        }
+    if (result == BLUETOOTH_FRAME_COMPLETE) {
+      handleBluetoothFrame(bluetoothFrameParser.getType(), bluetoothFrameParser.getPayload(), bluetoothFrameParser.getLength());
+      break;
+    }
 
-        memcpy(settings, &tempSettings, sizeof(EEPROM_Data));
-        EEPROM_DataStore();
+    if (result == BLUETOOTH_FRAME_ERROR) {
+      SerialBT.println("[ER] Protocol Fail");
+    }
+  }
+}
 
-        MyArtNet.net = settings->net;
-        MyArtNet.subnet = settings->subuni >> 4;
+// Starts and stops the stack for the Bluetooth window. Stopping it frees the
+// Bluedroid and controller heap and leaves the radio to WiFi.
+void updateBluetooth() {
+  unsigned long now = millis();
 
-        SerialBT.println("[OK] Settings Loaded!");
-      } else {
-        lastSettingsAuthFail = millis();
-        lastSettingsAuthFailCount++;
-      }
+  bluetoothWindow.setButton(digitalRead(RESET_PREFERENCES_PIN) == HIGH, now);
 
-      bluetoothRequestType = BLUETOOTH_REQUEST_TYPE_NONE;
-    } else {
-      SerialBT.println("[ER] Settings are invalid! Rolled back.");
-      SerialBT.println(err);
-      bluetoothRequestType = BLUETOOTH_REQUEST_TYPE_NONE;
-    }
-  } else if (bluetoothRequestType == BLUETOOTH_REQUEST_TYPE_CHANGE_PASSWORD && SerialBT.available() == SYSTEM_PASSWORD_MAX_LENGTH * 2) {
-    lastBTReceivedData = 0;
-    SerialBT.readBytes((uint8_t*)&tempSettings, SYSTEM_PASSWORD_MAX_LENGTH);
-    if (strncmp(tempSettings.systemPassword, settings->systemPassword, SYSTEM_PASSWORD_MAX_LENGTH)) {
-      SerialBT.readBytes((uint8_t*)&settings, SYSTEM_PASSWORD_MAX_LENGTH);
-      settings->systemPassword[SYSTEM_PASSWORD_MAX_LENGTH] = 0;
-      lastSettingsAuthFail = 0;
-      lastSettingsAuthFailCount = 0;
-      EEPROM_DataStore();
-      SerialBT.println("[OK] Password Changed!");
-    } else {
-      lastSettingsAuthFail = millis();
-      lastSettingsAuthFailCount++;
-    }
-    bluetoothRequestType = BLUETOOTH_REQUEST_TYPE_NONE;
-  } else if (bluetoothRequestType != BLUETOOTH_REQUEST_TYPE_NONE && SerialBT.available()) {
-    if (lastBTReceivedData == 0) {
-      lastBTReceivedData = millis();
-    } else if (millis() - lastBTReceivedData > BLUETOOTH_DATA_RECEIVE_TIMEOUT_MILLIS) {
-      SerialBT.print("[ER] Read Timeout. Available: ");
-      SerialBT.print(SerialBT.available());
-      while (SerialBT.available()) { SerialBT.read(); }
-      lastBTReceivedData = 0;
-      bluetoothRequestType = BLUETOOTH_REQUEST_TYPE_NONE;
-    }
-  } 
+  switch (bluetoothWindow.update(now, SerialBT.hasClient() || !bluetoothFrameParser.isIdle())) {
+    case BLUETOOTH_WINDOW_START:
+      SerialBT.begin(BLUETOOTH_DEVICE_NAME);
+      bluetoothOnFreeHeap = ESP.getFreeHeap();
+      break;
+    case BLUETOOTH_WINDOW_STOP:
+      SerialBT.end();
+      bluetoothFrameParser.reset();
+      bluetoothOffFreeHeap = ESP.getFreeHeap();
+      break;
+    case BLUETOOTH_WINDOW_NONE:
+      break;
+  }
+
+  if (bluetoothWindow.isOn()) {
+    loadSettingsFromBluetooth();
+  }
 }
 
 void reconnectWiFi() {
@@ -268,10 +1179,14 @@ void reconnectWiFi() {
     if (wifiStatus == WL_CONNECTED) {
       MyArtNet.ip = WiFi.localIP();
       WiFi.macAddress(MyArtNet.mac);
+      dmxInputDestinationIP = WiFi.broadcastIP();
 
       UDP.begin(0x1936);
+      SacnUDP.begin(E131_PORT);
+      joinSacnGroups();
     } else {
       UDP.stop();
+      SacnUDP.stop();
     }
 
     lastWiFiStatus = wifiStatus;
@@ -279,44 +1194,23 @@ void reconnectWiFi() {
 }
 
 void loop() {
-  loadSettingsFromBluetooth();
-  reconnectWiFi();
-
-  if (UDP.parsePacket()) {
-    size_t read = UDP.read((uint8_t*)udpBuffer, sizeof(udpBuffer));
-    MyArtNet.onPacketReceived(UDP.remoteIP(), UDP.remotePort(), (uint8_t*)udpBuffer, read);
-    yield();
-  }
+  PROFILE_STAGE(&loopStageHistograms[LOOP_STAGE_BLUETOOTH], updateBluetooth());
+  PROFILE_STAGE(&loopStageHistograms[LOOP_STAGE_WIFI], reconnectWiFi());
 
-  if (currentWriteBufferIndex == 0) {
-    if (breakStartedAt == 0) {
-      pinMode(LED_CATHODE_PIN, INPUT);
-      breakStartedAt = micros();
-    } else if (micros() - breakStartedAt >= DMX_BREAK_LOW_INTERVAL_MICROS) {
-      pinMode(LED_CATHODE_PIN, OUTPUT);
-      digitalWrite(LED_CATHODE_PIN, LOW);
-      delayMicroseconds(DMX_BREAK_HIGH_INTERVAL_MICROS);
-      breakStartedAt = 0;
+  // Everything lwIP queued since the last iteration, within the receive budget.
+  PROFILE_STAGE(&loopStageHistograms[LOOP_STAGE_RECEIVE], {
+    if (MyReceiver.drain() + MySacnReceiver.drain()) {
+      yield();
     }
-  }
+  });
 
-  while (breakStartedAt == 0 && Serial2.availableForWrite() && currentWriteBufferIndex < settings->channelCount + 1) {
-    Serial2.write(dmxReadDataBuffer[currentWriteBufferIndex]);
-    currentWriteBufferIndex++;
-  }
+  PROFILE_STAGE(&loopStageHistograms[LOOP_STAGE_SHOW], saveDmxShow());
 
-  if (uart_ll_is_tx_idle(UART_LL_GET_HW(2)) && currentWriteBufferIndex >= settings->channelCount + 1) {
-    if (dmxWriteDataBufferHasNewData) {
-      uint8_t *aux = dmxWriteDataBuffer;
-      dmxWriteDataBuffer = dmxReadDataBuffer;
-      dmxReadDataBuffer = aux;
-      currentWriteBufferIndex = 0;
-      lastTransmit = 0;
-    } else if (lastTransmit == 0) {
-      lastTransmit = millis();
-    } else if (millis() - lastTransmit > DMX_MAX_TRANSMIT_INTERVAL_MS) {
-      currentWriteBufferIndex = 0;
-      lastTransmit = 0;
-    }
-  }
+  PROFILE_STAGE(&loopStageHistograms[LOOP_STAGE_REPLIES], {
+    playDmxShow();
+    sendDmxInputs();
+    MyArtNet.processPendingReplies();
+    MyArtNet.processDiagnostics();
+    saveArtAddress();
+  });
 }
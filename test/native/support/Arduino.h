@@ -0,0 +1,72 @@
+// Minimal Arduino shim so the protocol code in src/ can be built and
+// benchmarked on the host (pio test -e native).
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#define HIGH 0x1
+#define LOW 0x0
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+namespace arduino_shim {
+    // When enabled, millis()/micros() return a simulated clock that only
+    // moves when the test advances it.
+    inline bool fakeClockEnabled = false;
+    inline uint64_t fakeClockMicros = 0;
+
+    inline uint64_t hostMicros() {
+        static const auto start = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    inline void setFakeClock(uint64_t us) {
+        fakeClockEnabled = true;
+        fakeClockMicros = us;
+    }
+
+    inline void advanceFakeClock(uint64_t us) {
+        fakeClockMicros += us;
+    }
+
+    inline void useHostClock() {
+        fakeClockEnabled = false;
+    }
+}
+
+// Same 32-bit wrap-around as on the ESP32.
+inline unsigned long micros() {
+    return (uint32_t)(arduino_shim::fakeClockEnabled ? arduino_shim::fakeClockMicros : arduino_shim::hostMicros());
+}
+
+inline unsigned long millis() {
+    return (uint32_t)((arduino_shim::fakeClockEnabled ? arduino_shim::fakeClockMicros : arduino_shim::hostMicros()) / 1000);
+}
+
+inline void delayMicroseconds(uint32_t us) {
+    if (arduino_shim::fakeClockEnabled) {
+        arduino_shim::advanceFakeClock(us);
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+inline void delay(uint32_t ms) {
+    delayMicroseconds(ms * 1000);
+}
+
+inline void yield() {}
+
+inline long random(long howBig) {
+    return howBig > 0 ? rand() % howBig : 0;
+}
+
+inline long random(long howSmall, long howBig) {
+    return howSmall < howBig ? howSmall + random(howBig - howSmall) : howSmall;
+}
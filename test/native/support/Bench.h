@@ -0,0 +1,28 @@
+// Tiny helpers shared by the host benchmarks.
+#pragma once
+
+#include <stdio.h>
+#include <chrono>
+
+namespace bench {
+    // Keeps the optimizer from dropping the measured work.
+    template <typename T>
+    inline void doNotOptimize(T const &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Runs fn() `iterations` times and returns the mean cost in nanoseconds.
+    template <typename Fn>
+    double nsPerOp(uint32_t iterations, Fn &&fn) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            fn(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    }
+
+    inline void report(const char *name, double ns) {
+        printf("[bench] %-32s %10.1f ns/op %14.0f ops/s\n", name, ns, ns > 0 ? 1e9 / ns : 0.0);
+    }
+}
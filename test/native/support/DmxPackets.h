@@ -0,0 +1,56 @@
+// Data packets of both protocols for the host tests and benchmarks: 512
+// slots for one universe, ramping 0, 1, 2... unless a value is given.
+#pragma once
+
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <E131.h>
+
+// Root layer preamble, postamble and ACN packet identifier of sACN.
+static const uint8_t E131_ROOT_LAYER[] = {
+    0x00, 0x10, 0x00, 0x00, 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0x00, 0x00, 0x00
+};
+
+static inline void buildDmxPacket(uint8_t *buffer, uint8_t net, uint8_t subUni) {
+    art_net::ArtNetDmxDataPacket *packet = (art_net::ArtNetDmxDataPacket*) buffer;
+
+    memset(buffer, 0, sizeof(art_net::ArtNetDmxDataPacket));
+    memcpy(packet->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    packet->OpCodeLo = ((uint16_t)art_net::OpCode::Dmx & 0xFF);
+    packet->OpCodeHi = ((uint16_t)art_net::OpCode::Dmx >> 8);
+    packet->ProtVerLo = 14;
+    packet->Net = net;
+    packet->SubUni = subUni;
+    packet->LengthHi = 512 >> 8;
+    packet->LengthLo = 512 & 0xFF;
+
+    for (uint16_t i = 0; i < 512; i++) {
+        packet->Data[i] = i & 0xFF;
+    }
+}
+
+static inline void buildDmxPacket(uint8_t *buffer, uint8_t net, uint8_t subUni, uint8_t value) {
+    buildDmxPacket(buffer, net, subUni);
+    memset(((art_net::ArtNetDmxDataPacket*) buffer)->Data, value, 512);
+}
+
+static inline void buildE131Packet(uint8_t *buffer, uint16_t universe) {
+    art_net::E131DataPacket *packet = (art_net::E131DataPacket*) buffer;
+
+    memset(buffer, 0, sizeof(art_net::E131DataPacket));
+    memcpy(buffer, E131_ROOT_LAYER, sizeof(E131_ROOT_LAYER));
+    packet->RootVector[3] = E131_VECTOR_ROOT_DATA;
+    packet->FramingVector[3] = E131_VECTOR_FRAMING_DATA;
+    packet->Priority = 100;
+    packet->UniverseHi = universe >> 8;
+    packet->UniverseLo = universe & 0xFF;
+    packet->DmpVector = 0x02;
+    packet->AddressType = 0xA1;
+    packet->AddressIncrementLo = 1;
+    packet->PropertyCountHi = 513 >> 8;
+    packet->PropertyCountLo = 513 & 0xFF;
+
+    for (uint16_t i = 0; i < 512; i++) {
+        packet->Data[i] = i & 0xFF;
+    }
+}
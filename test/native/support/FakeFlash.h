@@ -0,0 +1,82 @@
+// Flash stand-in for the host tests: erase sets whole sectors to 0xFF and
+// writes can only clear bits, like NOR flash. Writes to bytes that were not
+// erased are counted instead of silently corrupting data.
+#pragma once
+
+#include <Arduino.h>
+#include <ConfigStore.h>
+#include <DmxShow.h>
+#include <vector>
+
+class FakeFlash final : public DmxShowFlash, public ConfigStoreFlash {
+    public:
+        uint32_t erases = 0;
+        uint32_t writes = 0;
+        uint32_t bytesWritten = 0;
+        // Writes over bytes that were not erased.
+        uint32_t dirtyWrites = 0;
+
+        explicit FakeFlash(uint32_t size) : data(size, 0x00) {}
+
+        // Failing writes from then on, as if the power went while writing:
+        // the last one is cut after `bytes` bytes.
+        void cutAfter(uint32_t bytes) {
+            budget = bytes;
+        }
+
+        uint32_t getSize() override {
+            return data.size();
+        }
+
+        bool eraseSector(uint32_t offset) override {
+            if (offset % DMX_SHOW_SECTOR_SIZE || offset >= data.size()) {
+                return false;
+            }
+
+            memset(&data[offset], 0xFF, DMX_SHOW_SECTOR_SIZE);
+            erases++;
+            return true;
+        }
+
+        bool write(uint32_t offset, const uint8_t *buffer, uint32_t size) override {
+            if (offset + size > data.size()) {
+                return false;
+            }
+
+            bool cut = size > budget;
+
+            if (cut) {
+                size = budget;
+            }
+
+            for (uint32_t i = 0; i < size; i++) {
+                if (data[offset + i] != 0xFF) {
+                    dirtyWrites++;
+                }
+
+                data[offset + i] &= buffer[i];
+            }
+
+            budget -= size;
+            writes++;
+            bytesWritten += size;
+            return !cut;
+        }
+
+        bool read(uint32_t offset, uint8_t *buffer, uint32_t size) override {
+            if (offset + size > data.size()) {
+                return false;
+            }
+
+            memcpy(buffer, &data[offset], size);
+            return true;
+        }
+
+        // Flips bits, as a worn or disturbed cell would.
+        void corrupt(uint32_t offset, uint8_t mask) {
+            data[offset] ^= mask;
+        }
+    private:
+        std::vector<uint8_t> data;
+        uint32_t budget = UINT32_MAX;
+};
@@ -0,0 +1,109 @@
+// WiFiUDP stand-in for the host tests: a bounded datagram queue like the
+// lwIP receive mailbox, fed directly or by a periodic source running on the
+// Arduino shim clock.
+#pragma once
+
+#include <Arduino.h>
+#include <deque>
+#include <vector>
+
+class FakeUdp {
+    public:
+        // Datagrams lwIP keeps per socket before dropping (CONFIG_LWIP_UDP_RECVMBOX_SIZE).
+        size_t capacity = 6;
+        // Simulated CPU time of taking one datagram out of the stack.
+        uint32_t parseCostMicros = 0;
+
+        uint32_t delivered = 0;
+        uint32_t dropped = 0;
+
+        bool push(uint32_t ip, uint16_t port, const uint8_t *data, size_t size) {
+            if (queue.size() >= capacity) {
+                dropped++;
+                return false;
+            }
+
+            queue.push_back({ ip, port, std::vector<uint8_t>(data, data + size) });
+            return true;
+        }
+
+        // Sends `data` every `intervalMicros` of shim clock, starting now.
+        void setSource(uint32_t ip, const uint8_t *data, size_t size, uint32_t intervalMicros) {
+            sourceIp = ip;
+            sourceData.assign(data, data + size);
+            sourceInterval = intervalMicros;
+            nextArrival = micros();
+        }
+
+        // Queues everything the source sent up to now.
+        void update() {
+            if (!sourceInterval) {
+                return;
+            }
+
+            while ((long)(micros() - nextArrival) >= 0) {
+                push(sourceIp, 0x1936, sourceData.data(), sourceData.size());
+                nextArrival += sourceInterval;
+            }
+        }
+
+        size_t queued() const {
+            return queue.size();
+        }
+
+        int parsePacket() {
+            delayMicroseconds(parseCostMicros);
+            update();
+
+            if (queue.empty()) {
+                current.data.clear();
+                position = 0;
+                return 0;
+            }
+
+            current = queue.front();
+            queue.pop_front();
+            position = 0;
+            delivered++;
+
+            return current.data.size();
+        }
+
+        int available() {
+            return current.data.size() - position;
+        }
+
+        int read(uint8_t *buffer, size_t length) {
+            size_t count = available() < (int)length ? available() : length;
+            memcpy(buffer, current.data.data() + position, count);
+            position += count;
+            return count;
+        }
+
+        void flush() {
+            position = current.data.size();
+        }
+
+        uint32_t remoteIP() const {
+            return current.ip;
+        }
+
+        uint16_t remotePort() const {
+            return current.port;
+        }
+    private:
+        typedef struct {
+            uint32_t ip;
+            uint16_t port;
+            std::vector<uint8_t> data;
+        } Datagram;
+
+        std::deque<Datagram> queue;
+        Datagram current;
+        size_t position = 0;
+
+        uint32_t sourceIp = 0;
+        std::vector<uint8_t> sourceData;
+        uint32_t sourceInterval = 0;
+        unsigned long nextArrival = 0;
+};
@@ -0,0 +1,76 @@
+// Synthetic DMX show for the show recorder tests and benchmarks: a rig of
+// moving heads, RGB pars and dimmers run from cues, with fades, a chase and
+// an effect on pan/tilt, plus a noisy mode for the worst case.
+#pragma once
+
+#include <Arduino.h>
+#include <DMX.h>
+#include <math.h>
+
+class ShowGenerator {
+    public:
+        // Slots that change on every frame without any pattern.
+        bool noise = false;
+        uint16_t length = DMX_MAX_CHANNELS;
+
+        explicit ShowGenerator(uint8_t seed) : seed(seed) {}
+
+        // Frame `frame` at 44 Hz.
+        void render(uint32_t frame, uint8_t *slots) {
+            if (noise) {
+                for (uint16_t i = 0; i < length; i++) {
+                    slots[i] = hash(frame * 1021 + i);
+                }
+
+                return;
+            }
+
+            memset(slots, 0, length);
+
+            // A new cue every 8 s, crossfaded over 2 s.
+            uint32_t cue = frame / (44 * 8);
+            uint32_t inCue = frame % (44 * 8);
+            float fade = inCue < 88 ? inCue / 88.0f : 1.0f;
+
+            // 12 moving heads, 16 channels each: pan/tilt effect, static
+            // colour and gobo per cue, dimmer fading in.
+            for (uint8_t head = 0; head < 12; head++) {
+                uint8_t *fixture = slots + head * 16;
+                float phase = frame / 44.0f * 0.5f + head * 0.3f;
+
+                fixture[0] = 128 + 60 * sinf(phase);
+                fixture[2] = 128 + 40 * cosf(phase);
+                fixture[4] = hash(cue * 7 + head / 4) % 8 * 16;
+                fixture[5] = hash(cue * 11) % 5 * 10;
+                fixture[7] = 255;
+                fixture[8] = 200 * fade;
+            }
+
+            // 24 RGB pars at 192: chase stepping 4 times per second.
+            for (uint8_t par = 0; par < 24; par++) {
+                uint8_t *fixture = slots + 192 + par * 4;
+                bool lit = (frame / 11 + par) % 6 == 0;
+
+                fixture[0] = lit ? 255 : 0;
+                fixture[1] = hash(cue + 1) % 256 * lit;
+                fixture[2] = hash(cue + 2) % 256 * lit;
+                fixture[3] = 255;
+            }
+
+            // 96 dimmers at 288, levels of the cue faded in.
+            for (uint8_t dimmer = 0; dimmer < 96; dimmer++) {
+                uint8_t previous = hash((cue - 1) * 131 + dimmer / 8) % 4 * 80;
+                uint8_t next = hash(cue * 131 + dimmer / 8) % 4 * 80;
+                slots[288 + dimmer] = previous + (next - previous) * fade;
+            }
+
+            // 384 and up: unused.
+        }
+    private:
+        uint8_t seed;
+
+        uint8_t hash(uint32_t value) const {
+            value = (value + seed) * 2654435761u;
+            return value >> 24;
+        }
+};
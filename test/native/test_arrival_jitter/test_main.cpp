@@ -0,0 +1,108 @@
+#include <Arduino.h>
+#include <ArrivalJitter.h>
+#include <unity.h>
+
+// 44 Hz, what most consoles send.
+#define PERIOD_US 22727
+
+static ArrivalJitter *jitter;
+
+void setUp(void) {
+    jitter = new ArrivalJitter();
+}
+
+void tearDown(void) {
+    delete jitter;
+}
+
+void test_steady_stream_has_no_jitter(void) {
+    uint32_t now = 1000;
+
+    for (uint16_t i = 0; i < 1000; i++) {
+        jitter->record(now);
+        now += PERIOD_US;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(PERIOD_US, jitter->getInterval());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter->getJitter());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter->getDeviations()->getMax());
+    // The first interval only seeds the average.
+    TEST_ASSERT_EQUAL_UINT32(998, jitter->getDeviations()->getCount());
+}
+
+void test_alternating_arrivals(void) {
+    uint32_t sent = 0;
+
+    // Every other frame 2 ms late.
+    for (uint16_t i = 0; i < 2000; i++) {
+        jitter->record(sent + (i % 2 ? 2000 : 0));
+        sent += PERIOD_US;
+    }
+
+    TEST_ASSERT_UINT32_WITHIN(100, PERIOD_US, jitter->getInterval());
+    TEST_ASSERT_UINT32_WITHIN(200, 2000, jitter->getJitter());
+    // Upper bound of a bucket 25% wide.
+    TEST_ASSERT_UINT32_WITHIN(640, 2000, jitter->getDeviations()->getPercentile(50));
+}
+
+void test_pauses_are_not_jitter(void) {
+    uint32_t now = 0;
+
+    for (uint16_t i = 0; i < 100; i++) {
+        jitter->record(now);
+        // The console stops now and then.
+        now += i % 10 == 9 ? 5 * ARRIVAL_JITTER_MAX_INTERVAL_US : PERIOD_US;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(PERIOD_US, jitter->getInterval());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter->getDeviations()->getMax());
+    TEST_ASSERT_EQUAL_UINT32(89, jitter->getDeviations()->getCount());
+}
+
+void test_micros_wrap(void) {
+    uint32_t now = 0xFFFFFFFF - 10 * PERIOD_US;
+
+    for (uint16_t i = 0; i < 100; i++) {
+        jitter->record(now);
+        now += PERIOD_US;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(PERIOD_US, jitter->getInterval());
+    TEST_ASSERT_EQUAL_UINT32(0, jitter->getDeviations()->getMax());
+}
+
+// Occasional late frames, like WiFi giving the radio to Bluetooth: p50 stays
+// low, p99 and max show them.
+void test_spikes_show_in_the_tail(void) {
+    uint32_t sent = 0;
+
+    srand(7);
+
+    for (uint16_t i = 0; i < 5000; i++) {
+        uint32_t delay = random(200);
+
+        if (random(50) == 0) {
+            delay += 5000 + random(10000);
+        }
+
+        jitter->record(sent + delay);
+        sent += PERIOD_US;
+    }
+
+    char text[160];
+    jitter->format(text, sizeof(text), "Spiky stream");
+    printf("[jitter] %s", text);
+
+    TEST_ASSERT_LESS_THAN(300, jitter->getDeviations()->getPercentile(50));
+    TEST_ASSERT_GREATER_THAN(4000, jitter->getDeviations()->getPercentile(99));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_stream_has_no_jitter);
+    RUN_TEST(test_alternating_arrivals);
+    RUN_TEST(test_pauses_are_not_jitter);
+    RUN_TEST(test_micros_wrap);
+    RUN_TEST(test_spikes_show_in_the_tail);
+    return UNITY_END();
+}
@@ -0,0 +1,288 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <DmxFrameBuffer.h>
+#include <unity.h>
+
+using namespace art_net;
+
+#define CONSOLE_IP 0x0A000001
+
+static ArtNet artNet;
+static DmxFrameBuffer *frameBuffers;
+static ArtNetPollReplyPacket lastReply;
+static uint32_t replies;
+static uint32_t replyIP;
+
+static uint8_t dmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t syncPacket[14];
+static ArtNetAddressPacket addressPacket;
+
+static void sendDmx(uint8_t net, uint8_t subUni, uint8_t sequence, uint8_t value) {
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) dmxPacket;
+
+    packet->Net = net;
+    packet->SubUni = subUni;
+    packet->Sequence = sequence;
+    memset(packet->Data, value, sizeof(packet->Data));
+    artNet.onPacketReceived(CONSOLE_IP, 0x1936, dmxPacket, sizeof(dmxPacket));
+}
+
+static void sendSync() {
+    artNet.onPacketReceived(CONSOLE_IP, 0x1936, syncPacket, sizeof(syncPacket));
+}
+
+// All switches "no change".
+static void resetAddressPacket() {
+    memset(&addressPacket, 0, sizeof(addressPacket));
+    memcpy(addressPacket.ID, ART_NET_ID, sizeof(ART_NET_ID));
+    addressPacket.OpCodeLo = ((uint16_t)OpCode::Address & 0xFF);
+    addressPacket.OpCodeHi = ((uint16_t)OpCode::Address >> 8);
+    addressPacket.ProtVerLo = 14;
+    addressPacket.NetSwitch = 0x7F;
+    addressPacket.SubSwitch = 0x7F;
+    memset(addressPacket.SwIn, 0x7F, sizeof(addressPacket.SwIn));
+    memset(addressPacket.SwOut, 0x7F, sizeof(addressPacket.SwOut));
+}
+
+static void sendAddress() {
+    artNet.onPacketReceived(CONSOLE_IP, 0x1936, (const uint8_t*) &addressPacket, sizeof(addressPacket));
+}
+
+// What the output task of `port` would send next, -1 for a repeat.
+static int16_t outputFrame(uint8_t port) {
+    if (!frameBuffers[port].swap()) {
+        return -1;
+    }
+
+    return frameBuffers[port].getReadBuffer()[1];
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    artNet = ArtNet();
+    artNet.pollReplyMaxDelayMs = 0;
+    frameBuffers = new DmxFrameBuffer[ART_NET_OUTPUT_UNIVERSE_COUNT];
+    replies = 0;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t startCode, const uint8_t *data, uint16_t size) {
+        memcpy(frameBuffers[universe].beginWrite(startCode, size), data, size);
+        frameBuffers[universe].stageWrite();
+    });
+
+    artNet.setDmxCommitCallback([]() {
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            frameBuffers[i].publish();
+        }
+    });
+
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        if (size == sizeof(ArtNetPollReplyPacket)) {
+            memcpy(&lastReply, data, size);
+            replyIP = ip;
+            replies++;
+        }
+    });
+
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) dmxPacket;
+    memset(dmxPacket, 0, sizeof(dmxPacket));
+    memcpy(packet->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    packet->OpCodeLo = ((uint16_t)OpCode::Dmx & 0xFF);
+    packet->OpCodeHi = ((uint16_t)OpCode::Dmx >> 8);
+    packet->ProtVerLo = 14;
+    packet->LengthHi = 512 >> 8;
+    packet->LengthLo = 512 & 0xFF;
+
+    memset(syncPacket, 0, sizeof(syncPacket));
+    memcpy(syncPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    syncPacket[8] = ((uint16_t)OpCode::Sync & 0xFF);
+    syncPacket[9] = ((uint16_t)OpCode::Sync >> 8);
+    syncPacket[11] = 14;
+
+    resetAddressPacket();
+}
+
+void tearDown(void) {
+    delete[] frameBuffers;
+    arduino_shim::useHostClock();
+}
+
+void test_programs_net_subnet_and_universes(void) {
+    addressPacket.NetSwitch = ART_NET_ADDRESS_PROGRAM | 3;
+    addressPacket.SubSwitch = ART_NET_ADDRESS_PROGRAM | 2;
+    addressPacket.SwOut[0] = ART_NET_ADDRESS_PROGRAM | 5;
+    // Reset to the switches, which the node doesn't have.
+    addressPacket.SwOut[2] = 0x00;
+    sendAddress();
+
+    TEST_ASSERT_EQUAL_UINT8(3, artNet.net);
+    TEST_ASSERT_EQUAL_UINT8(2, artNet.subnet);
+    TEST_ASSERT_EQUAL_UINT8(5, artNet.portUniverse[0]);
+    TEST_ASSERT_EQUAL_UINT8(1, artNet.portUniverse[1]);
+    TEST_ASSERT_EQUAL_UINT8(2, artNet.portUniverse[2]);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.addressChanges);
+
+    // Answered with the new addressing, outside of the packet path.
+    TEST_ASSERT_EQUAL_UINT32(0, replies);
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(1, replies);
+    TEST_ASSERT_EQUAL_UINT32(CONSOLE_IP, replyIP);
+    TEST_ASSERT_EQUAL_UINT8(3, lastReply.net_sw);
+    TEST_ASSERT_EQUAL_UINT8(2, lastReply.sub_sw);
+    TEST_ASSERT_EQUAL_UINT8(5, lastReply.sw_out[0]);
+
+    sendDmx(3, 0x25, 0, 42);
+    TEST_ASSERT_EQUAL_INT16(42, outputFrame(0));
+    sendDmx(0, 0x00, 0, 43);
+    TEST_ASSERT_EQUAL_INT16(-1, outputFrame(0));
+}
+
+void test_no_change_leaves_everything(void) {
+    sendAddress();
+
+    TEST_ASSERT_EQUAL_UINT8(0, artNet.net);
+    TEST_ASSERT_EQUAL_UINT8(0, artNet.portUniverse[0]);
+    TEST_ASSERT_EQUAL_STRING(ART_NET_SHORT_NAME, artNet.shortName);
+    TEST_ASSERT_EQUAL_UINT32(0, artNet.addressChanges);
+
+    // Still answered, the console uses the reply to check the node.
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(1, replies);
+}
+
+void test_input_ports_take_sw_in(void) {
+    artNet.portMode[2] = PortMode::Input;
+    addressPacket.SwIn[2] = ART_NET_ADDRESS_PROGRAM | 7;
+    addressPacket.SwOut[2] = ART_NET_ADDRESS_PROGRAM | 9;
+    addressPacket.SwIn[1] = ART_NET_ADDRESS_PROGRAM | 9;
+    sendAddress();
+
+    TEST_ASSERT_EQUAL_UINT8(1, artNet.portUniverse[1]);
+    TEST_ASSERT_EQUAL_UINT8(7, artNet.portUniverse[2]);
+}
+
+// A console sends universes 0 and 4, their sequence numbers apart. Port 1
+// moves from 0 to 4 half way: every frame of the new universe goes out from
+// the first one, none held back by the sequence of the old one.
+void test_frames_continue_across_repatch(void) {
+    uint8_t sequence0 = 100;
+    uint8_t sequence4 = 80;
+
+    for (uint8_t frame = 0; frame < 40; frame++) {
+        if (frame == 20) {
+            addressPacket.SwOut[0] = ART_NET_ADDRESS_PROGRAM | 4;
+            sendAddress();
+        }
+
+        sendDmx(0, 0x00, sequence0++, frame);
+        sendDmx(0, 0x04, sequence4++, 100 + frame);
+
+        TEST_ASSERT_EQUAL_INT16(frame < 20 ? frame : 100 + frame, outputFrame(0));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, artNet.getSequenceRejected());
+    TEST_ASSERT_EQUAL_UINT32(0, artNet.getSourceRejected());
+}
+
+// Port 2 moves from universe 1 to 5 in the middle of an ArtSync group: that
+// group still goes out whole on the old addressing, the next one on the new.
+void test_sync_group_is_not_split(void) {
+    sendSync();
+    TEST_ASSERT_TRUE(artNet.isSynchronous());
+
+    sendDmx(0, 0x00, 0, 10);
+    addressPacket.SwOut[1] = ART_NET_ADDRESS_PROGRAM | 5;
+    sendAddress();
+
+    // Not yet: the group started on universe 1.
+    TEST_ASSERT_EQUAL_UINT8(1, artNet.portUniverse[1]);
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(0, replies);
+
+    sendDmx(0, 0x01, 0, 10);
+    sendDmx(0, 0x05, 0, 50);
+    sendSync();
+
+    TEST_ASSERT_EQUAL_INT16(10, outputFrame(0));
+    TEST_ASSERT_EQUAL_INT16(10, outputFrame(1));
+    TEST_ASSERT_EQUAL_UINT8(5, artNet.portUniverse[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.addressChanges);
+
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(1, replies);
+    TEST_ASSERT_EQUAL_UINT8(5, lastReply.sw_out[1]);
+
+    sendDmx(0, 0x00, 0, 11);
+    sendDmx(0, 0x01, 0, 11);
+    sendDmx(0, 0x05, 0, 51);
+    sendSync();
+
+    TEST_ASSERT_EQUAL_INT16(11, outputFrame(0));
+    TEST_ASSERT_EQUAL_INT16(51, outputFrame(1));
+}
+
+void test_pending_addressing_applies_when_sync_stops(void) {
+    sendSync();
+    addressPacket.NetSwitch = ART_NET_ADDRESS_PROGRAM | 1;
+    sendAddress();
+
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT8(0, artNet.net);
+
+    arduino_shim::advanceFakeClock((ART_NET_SYNC_TIMEOUT_MS + 1) * 1000UL);
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT8(1, artNet.net);
+    TEST_ASSERT_EQUAL_UINT32(1, replies);
+}
+
+void test_names(void) {
+    strcpy(addressPacket.ShortName, "Truss L");
+    memset(addressPacket.LongName, 'x', sizeof(addressPacket.LongName));
+    sendAddress();
+
+    TEST_ASSERT_EQUAL_STRING("Truss L", artNet.shortName);
+    TEST_ASSERT_EQUAL_UINT32(ART_NET_LONG_NAME_SIZE - 1, strlen(artNet.longName));
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.addressChanges);
+
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_STRING("Truss L", (const char*) lastReply.short_name);
+
+    // Same names again: nothing to save.
+    sendAddress();
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.addressChanges);
+}
+
+void test_merge_commands(void) {
+    addressPacket.Command = ART_NET_ADDRESS_MERGE_LTP + 1;
+    sendAddress();
+    TEST_ASSERT_TRUE(artNet.mergers[1].mode == MergeMode::Ltp);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.addressChanges);
+
+    addressPacket.Command = ART_NET_ADDRESS_MERGE_HTP + 1;
+    sendAddress();
+    TEST_ASSERT_TRUE(artNet.mergers[1].mode == MergeMode::Htp);
+    TEST_ASSERT_EQUAL_UINT32(2, artNet.addressChanges);
+
+    // Two consoles merging on port 1.
+    sendDmx(0, 0x00, 0, 10);
+    artNet.onPacketReceived(CONSOLE_IP + 1, 0x1936, dmxPacket, sizeof(dmxPacket));
+    TEST_ASSERT_TRUE(artNet.needsMerge(0));
+
+    addressPacket.Command = ART_NET_ADDRESS_CANCEL_MERGE;
+    sendAddress();
+    TEST_ASSERT_FALSE(artNet.needsMerge(0));
+    TEST_ASSERT_EQUAL_UINT32(2, artNet.addressChanges);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_programs_net_subnet_and_universes);
+    RUN_TEST(test_no_change_leaves_everything);
+    RUN_TEST(test_input_ports_take_sw_in);
+    RUN_TEST(test_frames_continue_across_repatch);
+    RUN_TEST(test_sync_group_is_not_split);
+    RUN_TEST(test_pending_addressing_applies_when_sync_stops);
+    RUN_TEST(test_names);
+    RUN_TEST(test_merge_commands);
+    return UNITY_END();
+}
@@ -0,0 +1,132 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <Bench.h>
+#include <DmxPackets.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static constexpr uint32_t BENCH_ITERATIONS = 200000;
+
+static ArtNet artNet;
+static uint32_t dmxFrames;
+static uint32_t sentPackets;
+
+static uint8_t dmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t foreignDmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t pollPacket[14];
+static uint8_t garbagePacket[64];
+
+void setUp(void) {
+    artNet = ArtNet();
+    artNet.net = 0;
+    artNet.subnet = 0;
+    artNet.ip = 0x0A00000A;
+    artNet.pollReplyMaxDelayMs = 0;
+    artNet.pollReplyMergeWindowMs = 0;
+
+    dmxFrames = 0;
+    sentPackets = 0;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        bench::doNotOptimize(data[size - 1]);
+        dmxFrames++;
+    });
+
+    artNet.setDmxCommitCallback([]() {});
+
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        bench::doNotOptimize(data[size - 1]);
+        sentPackets++;
+    });
+
+    buildDmxPacket(dmxPacket, 0, 0x00);
+    buildDmxPacket(foreignDmxPacket, 3, 0x21);
+
+    memset(pollPacket, 0, sizeof(pollPacket));
+    memcpy(pollPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    pollPacket[8] = ((uint16_t)OpCode::Poll & 0xFF);
+    pollPacket[9] = ((uint16_t)OpCode::Poll >> 8);
+    pollPacket[11] = 14;
+
+    for (uint8_t i = 0; i < sizeof(garbagePacket); i++) {
+        garbagePacket[i] = i * 37;
+    }
+}
+
+void tearDown(void) {}
+
+void test_dmx_matched(void) {
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        ((ArtNetDmxDataPacket*) dmxPacket)->Sequence = 0;
+        artNet.onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+    });
+
+    bench::report("ArtDmx matched", ns);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS, dmxFrames);
+}
+
+void test_dmx_foreign_universe(void) {
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        artNet.onPacketReceived(0x0A000001, 0x1936, foreignDmxPacket, sizeof(foreignDmxPacket));
+    });
+
+    bench::report("ArtDmx foreign universe", ns);
+    TEST_ASSERT_EQUAL_UINT32(0, dmxFrames);
+}
+
+void test_poll(void) {
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        artNet.onPacketReceived(0x0A000001, 0x1936, pollPacket, sizeof(pollPacket));
+        artNet.processPendingReplies();
+    });
+
+    bench::report("ArtPoll", ns);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS, sentPackets);
+}
+
+void test_garbage(void) {
+    PacketParseStatus status = PacketParseStatus::Success;
+
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [&status](uint32_t i) {
+        status = artNet.onPacketReceived(0x0A000001, 0x1936, garbagePacket, sizeof(garbagePacket));
+    });
+
+    bench::report("Garbage", ns);
+    TEST_ASSERT_EQUAL_INT8((int8_t)PacketParseStatus::BadId, (int8_t)status);
+    TEST_ASSERT_EQUAL_UINT32(0, dmxFrames + sentPackets);
+}
+
+void test_mixed_broadcast_traffic(void) {
+    // Busy broadcast network: mostly ArtDmx for other universes, a few
+    // frames for us, an occasional poll and some noise.
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        uint32_t slot = i % 100;
+
+        if (slot < 90) {
+            artNet.onPacketReceived(0x0A000001, 0x1936, foreignDmxPacket, sizeof(foreignDmxPacket));
+        } else if (slot < 98) {
+            ((ArtNetDmxDataPacket*) dmxPacket)->Sequence = 0;
+            artNet.onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+        } else if (slot < 99) {
+            artNet.onPacketReceived(0x0A000001, 0x1936, pollPacket, sizeof(pollPacket));
+            artNet.processPendingReplies();
+        } else {
+            artNet.onPacketReceived(0x0A000001, 0x1936, garbagePacket, sizeof(garbagePacket));
+        }
+    });
+
+    bench::report("Mixed broadcast", ns);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS * 8 / 100, dmxFrames);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS / 100, sentPackets);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_dmx_matched);
+    RUN_TEST(test_dmx_foreign_universe);
+    RUN_TEST(test_poll);
+    RUN_TEST(test_garbage);
+    RUN_TEST(test_mixed_broadcast_traffic);
+    return UNITY_END();
+}
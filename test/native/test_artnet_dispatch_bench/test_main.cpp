@@ -0,0 +1,157 @@
+#include <Arduino.h>
+#include <ArtNetImpl.h>
+#include <Bench.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static constexpr uint32_t BENCH_ITERATIONS = 500000;
+
+static uint32_t dmxFrames;
+static uint32_t commits;
+static uint32_t sentPackets;
+
+// What the node binds at compile time: plain calls the compiler can inline.
+class CountingSink {
+    public:
+        void sendPacket(uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+            bench::doNotOptimize(data[size - 1]);
+            sentPackets++;
+        }
+
+        void onDmxData(uint8_t universe, uint8_t startCode, const uint8_t *data, uint16_t size) {
+            bench::doNotOptimize(data[size - 1]);
+            dmxFrames++;
+        }
+
+        void onDmxCommit() {
+            commits++;
+        }
+};
+
+typedef BasicArtNet<CountingSink> StaticArtNet;
+
+static ArtNet *functionArtNet;
+static StaticArtNet *staticArtNet;
+static uint8_t dmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t pollPacket[14];
+
+template <typename Node>
+static void configure(Node *node) {
+    node->net = 0;
+    node->subnet = 0;
+    node->ip = 0x0A00000A;
+    node->pollReplyMaxDelayMs = 0;
+    node->pollReplyMergeWindowMs = 0;
+}
+
+void setUp(void) {
+    functionArtNet = new ArtNet();
+    staticArtNet = new StaticArtNet();
+    configure(functionArtNet);
+    configure(staticArtNet);
+
+    functionArtNet->setDmxDataCallback([](uint8_t universe, uint8_t startCode, const uint8_t *data, uint16_t size) {
+        bench::doNotOptimize(data[size - 1]);
+        dmxFrames++;
+    });
+
+    functionArtNet->setDmxCommitCallback([]() {
+        commits++;
+    });
+
+    functionArtNet->setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        bench::doNotOptimize(data[size - 1]);
+        sentPackets++;
+    });
+
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) dmxPacket;
+    memset(dmxPacket, 0, sizeof(dmxPacket));
+    memcpy(packet->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    packet->OpCodeLo = ((uint16_t)OpCode::Dmx & 0xFF);
+    packet->OpCodeHi = ((uint16_t)OpCode::Dmx >> 8);
+    packet->ProtVerLo = 14;
+    packet->LengthHi = 512 >> 8;
+    packet->LengthLo = 512 & 0xFF;
+
+    memset(pollPacket, 0, sizeof(pollPacket));
+    memcpy(pollPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    pollPacket[8] = ((uint16_t)OpCode::Poll & 0xFF);
+    pollPacket[9] = ((uint16_t)OpCode::Poll >> 8);
+    pollPacket[11] = 14;
+
+    dmxFrames = 0;
+    commits = 0;
+    sentPackets = 0;
+}
+
+void tearDown(void) {
+    delete staticArtNet;
+    delete functionArtNet;
+}
+
+template <typename Node>
+static double benchDmx(Node *node) {
+    return bench::nsPerOp(BENCH_ITERATIONS, [node](uint32_t i) {
+        ((ArtNetDmxDataPacket*) dmxPacket)->Sequence = 0;
+        node->onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+    });
+}
+
+template <typename Node>
+static double benchPoll(Node *node) {
+    return bench::nsPerOp(BENCH_ITERATIONS / 10, [node](uint32_t i) {
+        node->onPacketReceived(0x0A000001, 0x1936, pollPacket, sizeof(pollPacket));
+        node->processPendingReplies();
+    });
+}
+
+void test_same_behaviour(void) {
+    functionArtNet->onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+    staticArtNet->onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+    TEST_ASSERT_EQUAL_UINT32(2, dmxFrames);
+    TEST_ASSERT_EQUAL_UINT32(2, commits);
+    TEST_ASSERT_EQUAL_UINT32(functionArtNet->stats.dmx, staticArtNet->stats.dmx);
+
+    functionArtNet->onPacketReceived(0x0A000001, 0x1936, pollPacket, sizeof(pollPacket));
+    staticArtNet->onPacketReceived(0x0A000001, 0x1936, pollPacket, sizeof(pollPacket));
+    functionArtNet->processPendingReplies();
+    staticArtNet->processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(2, sentPackets);
+}
+
+void test_dmx_dispatch(void) {
+    double functionNs = benchDmx(functionArtNet);
+    double staticNs = benchDmx(staticArtNet);
+
+    bench::report("ArtDmx, std::function sink", functionNs);
+    bench::report("ArtDmx, static sink", staticNs);
+    TEST_ASSERT_EQUAL_UINT32(2 * BENCH_ITERATIONS, dmxFrames);
+    TEST_ASSERT_EQUAL_UINT32(2 * BENCH_ITERATIONS, commits);
+}
+
+void test_poll_reply_dispatch(void) {
+    double functionNs = benchPoll(functionArtNet);
+    double staticNs = benchPoll(staticArtNet);
+
+    bench::report("ArtPoll, std::function sink", functionNs);
+    bench::report("ArtPoll, static sink", staticNs);
+    TEST_ASSERT_EQUAL_UINT32(2 * BENCH_ITERATIONS / 10, sentPackets);
+}
+
+void test_footprint(void) {
+    // Code size: nm -S --size-sort -C on this binary lists both
+    // instantiations of BasicArtNet<...>::onPacketReceived side by side.
+    printf("[footprint] RAM: ArtNet %u bytes, BasicArtNet<CountingSink> %u bytes, std::function sink %u bytes\n",
+        (unsigned) sizeof(ArtNet), (unsigned) sizeof(StaticArtNet), (unsigned) sizeof(ArtNetFunctionSink));
+    TEST_ASSERT_LESS_THAN(sizeof(ArtNet), sizeof(StaticArtNet));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_behaviour);
+    RUN_TEST(test_dmx_dispatch);
+    RUN_TEST(test_poll_reply_dispatch);
+    RUN_TEST(test_footprint);
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <Bench.h>
+#include <DmxPackets.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static constexpr uint32_t BENCH_ITERATIONS = 200000;
+
+static ArtNet artNet;
+static uint32_t dmxFrames;
+
+static uint8_t dmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t pollPacket[14];
+
+// Mirrors the receive path in main.cpp: only the header is "read" first,
+// the payload is copied only for accepted or non ArtDmx packets.
+static uint32_t receive(const uint8_t *datagram, uint32_t size, uint8_t *readBuffer) {
+    memcpy(readBuffer, datagram, ART_NET_DMX_HEADER_SIZE);
+
+    if (artNet.classifyHeader(readBuffer, ART_NET_DMX_HEADER_SIZE) == HeaderClass::DmxRejected) {
+        return ART_NET_DMX_HEADER_SIZE;
+    }
+
+    memcpy(readBuffer + ART_NET_DMX_HEADER_SIZE, datagram + ART_NET_DMX_HEADER_SIZE, size - ART_NET_DMX_HEADER_SIZE);
+    artNet.onPacketReceived(0x0A000001, 0x1936, readBuffer, size);
+
+    return size;
+}
+
+void setUp(void) {
+    artNet = ArtNet();
+    artNet.net = 1;
+    artNet.subnet = 2;
+
+    dmxFrames = 0;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        bench::doNotOptimize(data[size - 1]);
+        dmxFrames++;
+    });
+
+    artNet.setDmxCommitCallback([]() {});
+
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {});
+
+    memset(pollPacket, 0, sizeof(pollPacket));
+    memcpy(pollPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    pollPacket[8] = ((uint16_t)OpCode::Poll & 0xFF);
+    pollPacket[9] = ((uint16_t)OpCode::Poll >> 8);
+}
+
+void tearDown(void) {}
+
+void test_classify_accepts_own_universe(void) {
+    buildDmxPacket(dmxPacket, 1, 0x20);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::DmxAccepted, (uint8_t)artNet.classifyHeader(dmxPacket, ART_NET_DMX_HEADER_SIZE));
+}
+
+void test_classify_rejects_foreign_net_subnet_universe(void) {
+    buildDmxPacket(dmxPacket, 0, 0x20);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::DmxRejected, (uint8_t)artNet.classifyHeader(dmxPacket, ART_NET_DMX_HEADER_SIZE));
+
+    buildDmxPacket(dmxPacket, 1, 0x30);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::DmxRejected, (uint8_t)artNet.classifyHeader(dmxPacket, ART_NET_DMX_HEADER_SIZE));
+
+    buildDmxPacket(dmxPacket, 1, 0x20 | ART_NET_OUTPUT_UNIVERSE_COUNT);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::DmxRejected, (uint8_t)artNet.classifyHeader(dmxPacket, ART_NET_DMX_HEADER_SIZE));
+}
+
+void test_ports_map_to_configured_universes(void) {
+    static uint8_t lastPort;
+
+    artNet.portUniverse[0] = 5;
+    artNet.portUniverse[1] = 9;
+    artNet.portUniverse[2] = 12;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        lastPort = universe;
+    });
+
+    buildDmxPacket(dmxPacket, 1, 0x20);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::DmxRejected, (uint8_t)artNet.classifyHeader(dmxPacket, ART_NET_DMX_HEADER_SIZE));
+
+    buildDmxPacket(dmxPacket, 1, 0x29);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::DmxAccepted, (uint8_t)artNet.classifyHeader(dmxPacket, ART_NET_DMX_HEADER_SIZE));
+    artNet.onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+    TEST_ASSERT_EQUAL_UINT8(1, lastPort);
+
+    buildDmxPacket(dmxPacket, 1, 0x2C);
+    artNet.onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+    TEST_ASSERT_EQUAL_UINT8(2, lastPort);
+}
+
+void test_classify_passes_through_other_packets(void) {
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::Other, (uint8_t)artNet.classifyHeader(pollPacket, sizeof(pollPacket)));
+
+    buildDmxPacket(dmxPacket, 0, 0x00);
+    dmxPacket[3] = 'x';
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::Other, (uint8_t)artNet.classifyHeader(dmxPacket, ART_NET_DMX_HEADER_SIZE));
+
+    buildDmxPacket(dmxPacket, 0, 0x00);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::Other, (uint8_t)artNet.classifyHeader(dmxPacket, ART_NET_DMX_HEADER_SIZE - 1));
+}
+
+void test_bench_matched_vs_rejected(void) {
+    static uint8_t matched[sizeof(ArtNetDmxDataPacket)];
+    static uint8_t rejected[sizeof(ArtNetDmxDataPacket)];
+    static uint8_t readBuffer[sizeof(ArtNetDmxDataPacket)];
+    uint64_t bytesRead = 0;
+
+    buildDmxPacket(matched, 1, 0x20);
+    buildDmxPacket(rejected, 4, 0x71);
+
+    double fullRejectNs = bench::nsPerOp(BENCH_ITERATIONS, [&](uint32_t i) {
+        memcpy(readBuffer, rejected, sizeof(rejected));
+        artNet.onPacketReceived(0x0A000001, 0x1936, readBuffer, sizeof(rejected));
+    });
+
+    double peekRejectNs = bench::nsPerOp(BENCH_ITERATIONS, [&](uint32_t i) {
+        bytesRead += receive(rejected, sizeof(rejected), readBuffer);
+    });
+
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)BENCH_ITERATIONS * ART_NET_DMX_HEADER_SIZE, bytesRead);
+
+    double peekMatchedNs = bench::nsPerOp(BENCH_ITERATIONS, [&](uint32_t i) {
+        ((ArtNetDmxDataPacket*) matched)->Sequence = 0;
+        receive(matched, sizeof(matched), readBuffer);
+    });
+
+    bench::report("Rejected, full read + parse", fullRejectNs);
+    bench::report("Rejected, header peek", peekRejectNs);
+    bench::report("Matched, header peek + parse", peekMatchedNs);
+
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS, dmxFrames);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_classify_accepts_own_universe);
+    RUN_TEST(test_classify_rejects_foreign_net_subnet_universe);
+    RUN_TEST(test_ports_map_to_configured_universes);
+    RUN_TEST(test_classify_passes_through_other_packets);
+    RUN_TEST(test_bench_matched_vs_rejected);
+    return UNITY_END();
+}
@@ -0,0 +1,255 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <Bench.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static constexpr uint32_t SOURCE_IPS[4] = { 0x0A000001, 0x0A000002, 0x0A000003, 0x0A000004 };
+
+static ArtNet artNet;
+static uint8_t output[512];
+static uint16_t outputLength;
+static uint32_t frames;
+
+static uint8_t packetBuffer[sizeof(ArtNetDmxDataPacket)];
+
+static void send(uint32_t ip, uint8_t sequence, const uint8_t *data, uint16_t length) {
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) packetBuffer;
+
+    memcpy(packet->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    packet->OpCodeLo = ((uint16_t)OpCode::Dmx & 0xFF);
+    packet->OpCodeHi = ((uint16_t)OpCode::Dmx >> 8);
+    packet->Sequence = sequence;
+    packet->Net = 0;
+    packet->SubUni = 0;
+    packet->LengthHi = length >> 8;
+    packet->LengthLo = length & 0xFF;
+    memcpy(packet->Data, data, length);
+
+    artNet.onPacketReceived(ip, 0x1936, packetBuffer, ART_NET_DMX_HEADER_SIZE + length);
+}
+
+static void sendValue(uint32_t ip, uint8_t value, uint16_t length = 512) {
+    uint8_t data[512];
+    memset(data, value, sizeof(data));
+    send(ip, 0, data, length);
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    artNet = ArtNet();
+    memset(output, 0, sizeof(output));
+    outputLength = 0;
+    frames = 0;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        memcpy(output, data, size);
+        outputLength = size;
+        frames++;
+    });
+
+    artNet.setDmxCommitCallback([]() {});
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {});
+}
+
+void tearDown(void) {
+    arduino_shim::useHostClock();
+}
+
+void test_single_source_passes_through(void) {
+    sendValue(SOURCE_IPS[0], 10);
+    TEST_ASSERT_FALSE(artNet.needsMerge(0));
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+    TEST_ASSERT_EQUAL_UINT8(10, output[100]);
+}
+
+void test_htp_waits_for_all_sources_then_merges(void) {
+    sendValue(SOURCE_IPS[0], 10);
+    sendValue(SOURCE_IPS[1], 5);
+
+    // The first source was not kept while alone, nothing goes out until it
+    // sends again so its channels never drop to zero.
+    TEST_ASSERT_TRUE(artNet.needsMerge(0));
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+
+    sendValue(SOURCE_IPS[0], 10);
+    TEST_ASSERT_EQUAL_UINT32(2, frames);
+    TEST_ASSERT_EQUAL_UINT8(10, output[0]);
+
+    sendValue(SOURCE_IPS[1], 20);
+    TEST_ASSERT_EQUAL_UINT8(20, output[0]);
+
+    // Highest source going down falls back to the next highest.
+    sendValue(SOURCE_IPS[1], 1);
+    TEST_ASSERT_EQUAL_UINT8(10, output[511]);
+}
+
+void test_htp_matches_reference_with_random_traffic(void) {
+    static uint8_t latest[4][512];
+    static uint16_t latestLength[4];
+    uint8_t data[512];
+
+    srand(42);
+    memset(latest, 0, sizeof(latest));
+
+    for (uint8_t s = 0; s < 4; s++) {
+        latestLength[s] = 512;
+        sendValue(SOURCE_IPS[s], 0);
+    }
+
+    for (uint8_t s = 0; s < 4; s++) {
+        sendValue(SOURCE_IPS[s], 0);
+    }
+
+    for (uint32_t n = 0; n < 2000; n++) {
+        uint8_t s = rand() % 4;
+        uint16_t length = 1 + rand() % 512;
+
+        memcpy(data, latest[s], sizeof(data));
+
+        for (uint8_t c = 0; c < 8; c++) {
+            data[rand() % 512] = rand();
+        }
+
+        send(SOURCE_IPS[s], 0, data, length);
+
+        memset(latest[s], 0, sizeof(latest[s]));
+        memcpy(latest[s], data, length);
+        latestLength[s] = length;
+
+        uint16_t expectedLength = 0;
+
+        for (uint8_t i = 0; i < 4; i++) {
+            if (latestLength[i] > expectedLength) {
+                expectedLength = latestLength[i];
+            }
+        }
+
+        TEST_ASSERT_EQUAL_UINT16(expectedLength, outputLength);
+
+        for (uint16_t ch = 0; ch < expectedLength; ch++) {
+            uint8_t expected = 0;
+
+            for (uint8_t i = 0; i < 4; i++) {
+                if (latest[i][ch] > expected) {
+                    expected = latest[i][ch];
+                }
+            }
+
+            if (output[ch] != expected) {
+                TEST_FAIL_MESSAGE("HTP output differs from reference");
+                return;
+            }
+        }
+    }
+}
+
+void test_ltp_latest_change_wins(void) {
+    artNet.mergers[0].mode = MergeMode::Ltp;
+
+    sendValue(SOURCE_IPS[0], 200);
+    sendValue(SOURCE_IPS[1], 50);
+    sendValue(SOURCE_IPS[0], 200);
+    TEST_ASSERT_EQUAL_UINT8(200, output[0]);
+
+    sendValue(SOURCE_IPS[1], 60);
+    TEST_ASSERT_EQUAL_UINT8(60, output[0]);
+
+    // Repeating an unchanged frame doesn't take the channel back.
+    sendValue(SOURCE_IPS[0], 200);
+    TEST_ASSERT_EQUAL_UINT8(60, output[0]);
+}
+
+void test_sequence_is_tracked_per_source(void) {
+    uint8_t data[512];
+    memset(data, 1, sizeof(data));
+
+    send(SOURCE_IPS[0], 100, data, 512);
+    send(SOURCE_IPS[1], 3, data, 512);
+    send(SOURCE_IPS[0], 101, data, 512);
+    send(SOURCE_IPS[1], 4, data, 512);
+    TEST_ASSERT_EQUAL_UINT32(3, frames);
+
+    // Out of order for source 1 only.
+    send(SOURCE_IPS[1], 2, data, 512);
+    TEST_ASSERT_EQUAL_UINT32(3, frames);
+}
+
+void test_timed_out_source_leaves_merge(void) {
+    sendValue(SOURCE_IPS[0], 10);
+    sendValue(SOURCE_IPS[1], 90);
+    sendValue(SOURCE_IPS[0], 10);
+    TEST_ASSERT_EQUAL_UINT8(90, output[0]);
+
+    for (uint8_t i = 0; i < 20; i++) {
+        arduino_shim::advanceFakeClock(ART_NET_MERGE_SOURCE_TIMEOUT_MS * 1000UL / 10);
+        sendValue(SOURCE_IPS[0], 10);
+    }
+
+    TEST_ASSERT_FALSE(artNet.needsMerge(0));
+    TEST_ASSERT_EQUAL_UINT8(10, output[0]);
+}
+
+void test_extra_sources_are_dropped(void) {
+    for (uint8_t i = 0; i < ART_NET_MERGE_MAX_SOURCES; i++) {
+        sendValue(0x0A000100 + i, 1);
+    }
+
+    uint32_t before = frames;
+    sendValue(0x0A0001FF, 255);
+    TEST_ASSERT_EQUAL_UINT32(before, frames);
+    TEST_ASSERT_EQUAL_UINT8(ART_NET_MERGE_MAX_SOURCES, artNet.mergers[0].getSourceCount());
+}
+
+static void benchSources(uint8_t sourceCount, const char *name) {
+    static uint8_t data[4][512];
+    static const uint32_t PACKETS = 100000;
+
+    for (uint8_t s = 0; s < sourceCount; s++) {
+        memset(data[s], s * 40, sizeof(data[s]));
+        sendValue(SOURCE_IPS[s], s * 40);
+    }
+
+    sendValue(SOURCE_IPS[0], 0);
+
+    // Each source runs a fade on 48 channels, the rest holds still, like a
+    // busking console with a backup tracking it.
+    double ns = bench::nsPerOp(PACKETS, [&](uint32_t n) {
+        uint8_t s = n % sourceCount;
+
+        for (uint16_t ch = 0; ch < 48; ch++) {
+            data[s][ch * 8 + s]++;
+        }
+
+        send(SOURCE_IPS[s], 0, data[s], 512);
+    });
+
+    bench::report(name, ns);
+    printf("[bench] %u sources at 44 Hz: %.3f%% of one core\n", sourceCount, ns * 44 * sourceCount / 1e7);
+}
+
+void test_bench_two_sources(void) {
+    benchSources(2, "HTP merge, 2 sources");
+    TEST_ASSERT_TRUE(artNet.needsMerge(0));
+}
+
+void test_bench_four_sources(void) {
+    benchSources(4, "HTP merge, 4 sources");
+    TEST_ASSERT_EQUAL_UINT8(4, artNet.mergers[0].getSourceCount());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_source_passes_through);
+    RUN_TEST(test_htp_waits_for_all_sources_then_merges);
+    RUN_TEST(test_htp_matches_reference_with_random_traffic);
+    RUN_TEST(test_ltp_latest_change_wins);
+    RUN_TEST(test_sequence_is_tracked_per_source);
+    RUN_TEST(test_timed_out_source_leaves_merge);
+    RUN_TEST(test_extra_sources_are_dropped);
+    RUN_TEST(test_bench_two_sources);
+    RUN_TEST(test_bench_four_sources);
+    return UNITY_END();
+}
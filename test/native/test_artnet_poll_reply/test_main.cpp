@@ -0,0 +1,156 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <Bench.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static constexpr uint32_t BENCH_ITERATIONS = 200000;
+
+static ArtNet artNet;
+static ArtNetPollReplyPacket lastReply;
+static uint32_t replies;
+
+static uint8_t pollPacket[14];
+
+// The reply as it used to be built on the stack for every ArtPoll.
+static void buildReplyFromScratch(ArtNet *node, ArtNetPollReplyPacket *replyPacket) {
+    memset(replyPacket, 0, sizeof(ArtNetPollReplyPacket));
+
+    memcpy(replyPacket->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    replyPacket->OpCodeHi = ((uint16_t)OpCode::PollReply >> 8);
+    replyPacket->OpCodeLo = ((uint16_t)OpCode::PollReply & 0xFF);
+    memcpy(replyPacket->ip, &node->ip, sizeof(replyPacket->ip));
+    replyPacket->port_l = 0x36;
+    replyPacket->port_h = 0x19;
+    replyPacket->ver_l = 14U;
+    replyPacket->net_sw = node->net;
+    replyPacket->sub_sw = node->subnet;
+    replyPacket->oem_l = 0xFF;
+    memcpy(replyPacket->short_name, ART_NET_SHORT_NAME, sizeof(ART_NET_SHORT_NAME));
+    memcpy(replyPacket->long_name, ART_NET_LONG_NAME, sizeof(ART_NET_LONG_NAME));
+    memcpy(replyPacket->node_report, "#0001 [0000] OK", 15);
+
+    for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+        strcat((char*) replyPacket->node_report, i ? "/0" : " 0");
+    }
+
+    strcat((char*) replyPacket->node_report, " Hz dmx 0 seq 0 drop 0");
+    replyPacket->num_ports_l = ART_NET_OUTPUT_UNIVERSE_COUNT;
+
+    for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+        replyPacket->sw_out[i] = node->portUniverse[i];
+        replyPacket->sw_in[i] = node->portUniverse[i];
+        replyPacket->port_types[i] = 0b10100000;
+        replyPacket->good_output[i] = 0b10000000;
+    }
+
+    memcpy(replyPacket->mac, node->mac, sizeof(node->mac));
+    replyPacket->status_2 = 0b00001110;
+}
+
+static void poll() {
+    artNet.onPacketReceived(0x0A000001, 0x1936, pollPacket, sizeof(pollPacket));
+    artNet.processPendingReplies();
+}
+
+void setUp(void) {
+    artNet = ArtNet();
+    artNet.net = 3;
+    artNet.subnet = 7;
+    artNet.ip = 0x6401A8C0;
+    artNet.pollReplyMaxDelayMs = 0;
+    artNet.pollReplyMergeWindowMs = 0;
+
+    for (uint8_t i = 0; i < 6; i++) {
+        artNet.mac[i] = 0x10 + i;
+    }
+
+    replies = 0;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {});
+    artNet.setDmxCommitCallback([]() {});
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        TEST_ASSERT_EQUAL_UINT32(sizeof(ArtNetPollReplyPacket), size);
+        memcpy(&lastReply, data, sizeof(lastReply));
+        replies++;
+    });
+
+    memset(pollPacket, 0, sizeof(pollPacket));
+    memcpy(pollPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    pollPacket[8] = ((uint16_t)OpCode::Poll & 0xFF);
+    pollPacket[9] = ((uint16_t)OpCode::Poll >> 8);
+}
+
+void tearDown(void) {}
+
+void test_cached_reply_matches_full_build(void) {
+    ArtNetPollReplyPacket expected;
+
+    poll();
+    buildReplyFromScratch(&artNet, &expected);
+
+    TEST_ASSERT_EQUAL_MEMORY(&expected, &lastReply, sizeof(expected));
+}
+
+void test_node_report_counts_replies(void) {
+    for (uint8_t i = 0; i < 12; i++) {
+        poll();
+    }
+
+    TEST_ASSERT_EQUAL_MEMORY("#0001 [0011] OK ", lastReply.node_report, 16);
+}
+
+void test_reply_follows_addressing_changes(void) {
+    ArtNetPollReplyPacket expected;
+
+    poll();
+
+    artNet.net = 9;
+    artNet.subnet = 1;
+    artNet.ip = 0x0B01A8C0;
+    artNet.mac[5] = 0xEE;
+    artNet.portUniverse[1] = 12;
+
+    poll();
+    buildReplyFromScratch(&artNet, &expected);
+    memcpy(expected.node_report, "#0001 [0001] OK", 15);
+
+    TEST_ASSERT_EQUAL_MEMORY(&expected, &lastReply, sizeof(expected));
+}
+
+void test_reply_follows_merge_status(void) {
+    artNet.mergers[2].mode = MergeMode::Ltp;
+    poll();
+    TEST_ASSERT_EQUAL_UINT8(0b10000010, lastReply.good_output[2]);
+}
+
+void test_bench_rebuild_vs_cached(void) {
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        bench::doNotOptimize(data[size - 1]);
+    });
+
+    // Both answer a full ArtPoll through the same sink. A new address every
+    // poll makes the reply stale, so it is built again before the send.
+    double rebuildNs = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        artNet.ip ^= 1 << 24;
+        poll();
+    });
+
+    double cachedNs = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        poll();
+    });
+
+    bench::report("PollReply rebuilt per poll", rebuildNs);
+    bench::report("PollReply cached", cachedNs);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cached_reply_matches_full_build);
+    RUN_TEST(test_node_report_counts_replies);
+    RUN_TEST(test_reply_follows_addressing_changes);
+    RUN_TEST(test_reply_follows_merge_status);
+    RUN_TEST(test_bench_rebuild_vs_cached);
+    return UNITY_END();
+}
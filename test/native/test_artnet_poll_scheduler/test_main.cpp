@@ -0,0 +1,160 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <unity.h>
+#include <chrono>
+#include <thread>
+
+using namespace art_net;
+
+static ArtNet artNet;
+static uint32_t replies;
+static uint32_t repliesInPacketPath;
+static bool inPacketPath;
+static uint32_t simulatedSendMicros;
+
+static uint8_t pollPacket[14];
+static uint8_t addressPacket[107];
+
+static void receive(const uint8_t *packet, uint32_t size, uint32_t ip) {
+    inPacketPath = true;
+    artNet.onPacketReceived(ip, 0x1936, packet, size);
+    inPacketPath = false;
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(5000000);
+    srand(7);
+
+    artNet = ArtNet();
+    replies = 0;
+    repliesInPacketPath = 0;
+    inPacketPath = false;
+    simulatedSendMicros = 0;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {});
+    artNet.setDmxCommitCallback([]() {});
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        replies++;
+
+        if (inPacketPath) {
+            repliesInPacketPath++;
+        }
+
+        if (simulatedSendMicros) {
+            std::this_thread::sleep_for(std::chrono::microseconds(simulatedSendMicros));
+        }
+    });
+
+    memset(pollPacket, 0, sizeof(pollPacket));
+    memcpy(pollPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    pollPacket[8] = ((uint16_t)OpCode::Poll & 0xFF);
+    pollPacket[9] = ((uint16_t)OpCode::Poll >> 8);
+
+    memset(addressPacket, 0, sizeof(addressPacket));
+    memcpy(addressPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    addressPacket[8] = ((uint16_t)OpCode::Address & 0xFF);
+    addressPacket[9] = ((uint16_t)OpCode::Address >> 8);
+}
+
+void tearDown(void) {
+    arduino_shim::useHostClock();
+}
+
+void test_reply_is_deferred_within_max_delay(void) {
+    receive(pollPacket, sizeof(pollPacket), 0x0A000001);
+    TEST_ASSERT_EQUAL_UINT32(0, replies);
+
+    for (uint16_t ms = 0; ms <= ART_NET_POLL_REPLY_MAX_DELAY_MS; ms++) {
+        artNet.processPendingReplies();
+        arduino_shim::advanceFakeClock(1000);
+    }
+
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(1, replies);
+}
+
+void test_poll_storm_is_deduplicated(void) {
+    static const uint8_t CONTROLLERS = 5;
+
+    // 5 consoles polling every ~10 ms for 300 ms, while the loop keeps running.
+    for (uint16_t step = 0; step < 30; step++) {
+        for (uint8_t c = 0; c < CONTROLLERS; c++) {
+            receive(pollPacket, sizeof(pollPacket), 0x0A000010 + c);
+        }
+
+        arduino_shim::advanceFakeClock(10000);
+        artNet.processPendingReplies();
+    }
+
+    for (uint16_t ms = 0; ms <= ART_NET_POLL_REPLY_MAX_DELAY_MS; ms++) {
+        arduino_shim::advanceFakeClock(1000);
+        artNet.processPendingReplies();
+    }
+
+    printf("[storm] %u polls -> %u replies\n", 30 * CONTROLLERS, replies);
+
+    TEST_ASSERT_EQUAL_UINT32(0, repliesInPacketPath);
+    // One reply per controller: the storm fits in the merge window.
+    TEST_ASSERT_EQUAL_UINT32(CONTROLLERS, replies);
+}
+
+void test_address_is_answered_without_delay(void) {
+    receive(addressPacket, sizeof(addressPacket), 0x0A000001);
+    TEST_ASSERT_EQUAL_UINT32(0, replies);
+
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(1, replies);
+}
+
+void test_queue_overflow_drops_extra_controllers(void) {
+    artNet.pollReplyMaxDelayMs = 0;
+    artNet.pollReplyMergeWindowMs = 0;
+
+    for (uint8_t c = 0; c < ART_NET_POLL_REPLY_QUEUE_SIZE + 4; c++) {
+        receive(pollPacket, sizeof(pollPacket), 0x0A000100 + c);
+    }
+
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(ART_NET_POLL_REPLY_QUEUE_SIZE, replies);
+}
+
+void test_packet_path_never_blocks_on_send(void) {
+    // Each UDP send takes 300 us, as it can on a busy WiFi link.
+    simulatedSendMicros = 300;
+    arduino_shim::useHostClock();
+    artNet.pollReplyMaxDelayMs = 0;
+    artNet.pollReplyMergeWindowMs = 0;
+
+    double maxPacketPathUs = 0;
+
+    for (uint16_t i = 0; i < 200; i++) {
+        auto start = std::chrono::steady_clock::now();
+        receive(pollPacket, sizeof(pollPacket), 0x0A000200 + (i % 16));
+        auto end = std::chrono::steady_clock::now();
+
+        double us = std::chrono::duration<double, std::micro>(end - start).count();
+
+        if (us > maxPacketPathUs) {
+            maxPacketPathUs = us;
+        }
+
+        if (i % 8 == 7) {
+            artNet.processPendingReplies();
+        }
+    }
+
+    printf("[storm] max packet path time %.2f us, send costs %u us\n", maxPacketPathUs, simulatedSendMicros);
+
+    TEST_ASSERT_EQUAL_UINT32(0, repliesInPacketPath);
+    TEST_ASSERT_LESS_THAN(simulatedSendMicros, maxPacketPathUs);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reply_is_deferred_within_max_delay);
+    RUN_TEST(test_poll_storm_is_deduplicated);
+    RUN_TEST(test_address_is_answered_without_delay);
+    RUN_TEST(test_queue_overflow_drops_extra_controllers);
+    RUN_TEST(test_packet_path_never_blocks_on_send);
+    return UNITY_END();
+}
@@ -0,0 +1,268 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <ArtNetReceiver.h>
+#include <DmxFrameBuffer.h>
+#include <DmxPackets.h>
+#include <DmxProcessor.h>
+#include <FakeUdp.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static ArtNet artNet;
+static FakeUdp *udp;
+static DmxFrameBuffer *frameBuffers;
+static DmxProcessor *processors;
+static Receiver<FakeUdp> *receiver;
+static uint32_t replies;
+
+static uint8_t dmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t foreignDmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t pollPacket[14];
+
+static void pushDmx(uint32_t ip = 0x0A000001) {
+    udp->push(ip, 0x1936, dmxPacket, sizeof(dmxPacket));
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    artNet = ArtNet();
+    artNet.pollReplyMaxDelayMs = 0;
+    replies = 0;
+
+    udp = new FakeUdp();
+    frameBuffers = new DmxFrameBuffer[ART_NET_OUTPUT_UNIVERSE_COUNT];
+    processors = new DmxProcessor[ART_NET_OUTPUT_UNIVERSE_COUNT];
+    receiver = new Receiver<FakeUdp>(&artNet, udp, frameBuffers, processors);
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        DmxProcessor *processor = &processors[universe];
+        processor->process(data, size, frameBuffers[universe].beginWrite(ctrlByte, processor->getOutputLength(size)));
+        frameBuffers[universe].stageWrite();
+    });
+
+    artNet.setDmxCommitCallback([]() {
+        for (uint8_t i = 0; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+            frameBuffers[i].publish();
+        }
+    });
+
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        replies++;
+    });
+
+    buildDmxPacket(dmxPacket, 0, 0x00, 77);
+    buildDmxPacket(foreignDmxPacket, 3, 0x21, 1);
+
+    memset(pollPacket, 0, sizeof(pollPacket));
+    memcpy(pollPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    pollPacket[8] = ((uint16_t)OpCode::Poll & 0xFF);
+    pollPacket[9] = ((uint16_t)OpCode::Poll >> 8);
+}
+
+void tearDown(void) {
+    delete receiver;
+    delete[] processors;
+    delete[] frameBuffers;
+    delete udp;
+    arduino_shim::useHostClock();
+}
+
+void test_drains_whole_queue(void) {
+    pushDmx();
+    udp->push(0x0A000001, 0x1936, pollPacket, sizeof(pollPacket));
+    udp->push(0x0A000001, 0x1936, foreignDmxPacket, sizeof(foreignDmxPacket));
+
+    TEST_ASSERT_EQUAL_UINT16(3, receiver->drain());
+    TEST_ASSERT_EQUAL_UINT32(0, udp->queued());
+    TEST_ASSERT_EQUAL_UINT32(0, receiver->stats.budgetStops);
+
+    TEST_ASSERT_TRUE(frameBuffers[0].swap());
+    TEST_ASSERT_EQUAL_UINT8(77, frameBuffers[0].getReadBuffer()[512]);
+
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_UINT32(1, replies);
+
+    TEST_ASSERT_EQUAL_UINT32(3, receiver->stats.packets);
+    TEST_ASSERT_EQUAL_UINT32(1, receiver->stats.dmxFrames);
+    TEST_ASSERT_EQUAL_UINT32(2, artNet.stats.dmx);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxForeign);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.poll);
+}
+
+void test_stops_at_packet_budget(void) {
+    receiver->maxPackets = 4;
+
+    for (uint8_t i = 0; i < 6; i++) {
+        pushDmx();
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(4, receiver->drain());
+    TEST_ASSERT_EQUAL_UINT32(2, udp->queued());
+    TEST_ASSERT_EQUAL_UINT32(1, receiver->stats.budgetStops);
+
+    TEST_ASSERT_EQUAL_UINT16(2, receiver->drain());
+    TEST_ASSERT_EQUAL_UINT32(1, receiver->stats.budgetStops);
+}
+
+void test_stops_at_time_budget(void) {
+    udp->parseCostMicros = 300;
+    receiver->budgetMicros = 1000;
+
+    for (uint8_t i = 0; i < 6; i++) {
+        pushDmx();
+    }
+
+    // 300, 600, 900 then 1200 us: the fourth datagram is the last one taken.
+    TEST_ASSERT_EQUAL_UINT16(4, receiver->drain());
+    TEST_ASSERT_EQUAL_UINT32(2, udp->queued());
+    TEST_ASSERT_EQUAL_UINT32(1, receiver->stats.budgetStops);
+}
+
+void test_counts_dropped_dmx(void) {
+    // Announces 512 slots, carries 100.
+    udp->push(0x0A000010, 0x1936, dmxPacket, ART_NET_DMX_HEADER_SIZE + 100);
+
+    // Fifth source on a universe that merges four.
+    for (uint8_t i = 0; i <= ART_NET_MERGE_MAX_SOURCES; i++) {
+        pushDmx(0x0A000010 + i);
+    }
+
+    receiver->drain();
+
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxTruncated);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.getSourceRejected());
+    TEST_ASSERT_EQUAL_UINT32(ART_NET_MERGE_MAX_SOURCES, receiver->stats.dmxFrames);
+    TEST_ASSERT_TRUE(artNet.needsMerge(0));
+}
+
+void test_truncated_dmx_does_not_add_a_source(void) {
+    pushDmx(0x0A000001);
+    udp->push(0x0A000002, 0x1936, dmxPacket, ART_NET_DMX_HEADER_SIZE + 100);
+    buildDmxPacket(dmxPacket, 0, 0x00, 30);
+    pushDmx(0x0A000001);
+
+    receiver->drain();
+
+    // A merge with the sender that never got through would hold 77.
+    TEST_ASSERT_FALSE(artNet.needsMerge(0));
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxTruncated);
+    TEST_ASSERT_TRUE(frameBuffers[0].swap());
+    TEST_ASSERT_EQUAL_UINT8(30, frameBuffers[0].getReadBuffer()[1]);
+}
+
+void test_short_dmx_does_not_reuse_the_last_datagram(void) {
+    pushDmx();
+    receiver->drain();
+    TEST_ASSERT_TRUE(frameBuffers[0].swap());
+
+    // Classified as Other, the buffer still holds the frame before.
+    udp->push(0x0A000001, 0x1936, dmxPacket, 12);
+    receiver->drain();
+
+    TEST_ASSERT_FALSE(frameBuffers[0].swap());
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.badSize);
+    TEST_ASSERT_EQUAL_UINT32(1, receiver->stats.dmxFrames);
+}
+
+void test_exact_size_buffer_is_not_read_past(void) {
+    uint8_t header[ART_NET_DMX_HEADER_SIZE + 10];
+    uint32_t frames = 0;
+
+    artNet.setDmxDataCallback([&frames](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        frames++;
+    });
+
+    // Announces 512 slots, carries 10.
+    memcpy(header, dmxPacket, sizeof(header));
+    artNet.onPacketReceived(0x0A000001, 0x1936, header, sizeof(header));
+    artNet.onPacketReceived(0x0A000001, 0x1936, header, 14);
+
+    TEST_ASSERT_EQUAL_UINT32(0, frames);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxTruncated);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.badSize);
+}
+
+void test_merged_payload_goes_through_artnet(void) {
+    buildDmxPacket(dmxPacket, 0, 0x00, 10);
+    pushDmx(0x0A000001);
+    buildDmxPacket(dmxPacket, 0, 0x00, 90);
+    pushDmx(0x0A000002);
+    buildDmxPacket(dmxPacket, 0, 0x00, 10);
+    pushDmx(0x0A000001);
+
+    receiver->drain();
+
+    TEST_ASSERT_TRUE(frameBuffers[0].swap());
+    TEST_ASSERT_EQUAL_UINT8(90, frameBuffers[0].getReadBuffer()[1]);
+}
+
+void test_processed_payload_goes_through_artnet(void) {
+    processors[0].setCurve(0, DmxCurve::Inverse, false);
+    pushDmx();
+
+    receiver->drain();
+
+    TEST_ASSERT_TRUE(frameBuffers[0].swap());
+    TEST_ASSERT_EQUAL_UINT8(255 - 77, frameBuffers[0].getReadBuffer()[1]);
+    TEST_ASSERT_EQUAL_UINT8(77, frameBuffers[0].getReadBuffer()[2]);
+}
+
+typedef struct {
+    uint32_t handled;
+    uint32_t dropped;
+} SimulationResult;
+
+// One second of a loop that spends `otherWorkMicros` per iteration on
+// Bluetooth and WiFi, with ArtDmx arriving at `packetsPerSecond`.
+static SimulationResult simulateLoop(uint32_t packetsPerSecond, uint32_t otherWorkMicros) {
+    udp->parseCostMicros = 40;
+    udp->setSource(0x0A000001, dmxPacket, sizeof(dmxPacket), 1000000 / packetsPerSecond);
+
+    unsigned long start = micros();
+
+    while (micros() - start < 1000000) {
+        delayMicroseconds(otherWorkMicros);
+        receiver->drain();
+    }
+
+    SimulationResult result = { receiver->stats.dmxFrames, udp->dropped };
+    return result;
+}
+
+void test_sustained_rate_before_and_after(void) {
+    static const uint32_t PACKETS_PER_SECOND = 1500;
+    static const uint32_t OTHER_WORK_MICROS = 3000;
+
+    // One datagram per iteration, as loop() used to do.
+    receiver->maxPackets = 1;
+    SimulationResult before = simulateLoop(PACKETS_PER_SECOND, OTHER_WORK_MICROS);
+
+    tearDown();
+    setUp();
+
+    SimulationResult after = simulateLoop(PACKETS_PER_SECOND, OTHER_WORK_MICROS);
+
+    printf("[receive] %u pps offered, one per loop: %u pps handled, %u dropped\n", PACKETS_PER_SECOND, before.handled, before.dropped);
+    printf("[receive] %u pps offered, batched:      %u pps handled, %u dropped\n", PACKETS_PER_SECOND, after.handled, after.dropped);
+
+    TEST_ASSERT_EQUAL_UINT32(0, after.dropped);
+    TEST_ASSERT_GREATER_OR_EQUAL(PACKETS_PER_SECOND - 10, after.handled);
+    TEST_ASSERT_GREATER_THAN(after.handled / 2, before.dropped);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_drains_whole_queue);
+    RUN_TEST(test_stops_at_packet_budget);
+    RUN_TEST(test_stops_at_time_budget);
+    RUN_TEST(test_counts_dropped_dmx);
+    RUN_TEST(test_truncated_dmx_does_not_add_a_source);
+    RUN_TEST(test_short_dmx_does_not_reuse_the_last_datagram);
+    RUN_TEST(test_exact_size_buffer_is_not_read_past);
+    RUN_TEST(test_merged_payload_goes_through_artnet);
+    RUN_TEST(test_processed_payload_goes_through_artnet);
+    RUN_TEST(test_sustained_rate_before_and_after);
+    return UNITY_END();
+}
@@ -0,0 +1,248 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <stddef.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static ArtNet artNet;
+
+static uint32_t replies;
+static uint32_t diagPackets;
+static uint32_t lastDiagIP;
+static ArtNetDiagDataPacket lastDiag;
+// Texts of the last two ArtDiagData, by order of sending.
+static char diagTexts[2][sizeof(lastDiag.Data)];
+static ArtNetPollReplyPacket lastReply;
+
+static uint8_t dmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t pollPacket[sizeof(ArtNetPollPacket)];
+
+static void sendDmx(uint8_t sequence, uint8_t subUni = 0) {
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) dmxPacket;
+    packet->Sequence = sequence;
+    packet->SubUni = subUni;
+    artNet.onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+}
+
+static void sendPoll(uint8_t flags, uint8_t diagPriority = 0) {
+    ArtNetPollPacket *packet = (ArtNetPollPacket*) pollPacket;
+    packet->Flags = flags;
+    packet->DiagPriority = diagPriority;
+    artNet.onPacketReceived(0x0A000002, 0x1936, pollPacket, sizeof(pollPacket));
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    artNet = ArtNet();
+    artNet.pollReplyMaxDelayMs = 0;
+    artNet.pollReplyMergeWindowMs = 0;
+
+    replies = 0;
+    diagPackets = 0;
+    lastDiagIP = 0;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {});
+    artNet.setDmxCommitCallback([]() {});
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        const ArtNetBasePacket *packet = (const ArtNetBasePacket*) data;
+
+        if (packet->OpCodeLo == ((uint16_t)OpCode::DiagData & 0xFF) && packet->OpCodeHi == ((uint16_t)OpCode::DiagData >> 8)) {
+            TEST_ASSERT_LESS_OR_EQUAL(sizeof(lastDiag), size);
+            memset(&lastDiag, 0, sizeof(lastDiag));
+            memcpy(&lastDiag, data, size);
+            lastDiagIP = ip;
+            memcpy(diagTexts[diagPackets % 2], lastDiag.Data, sizeof(lastDiag.Data));
+            diagPackets++;
+        } else {
+            memcpy(&lastReply, data, sizeof(lastReply));
+            replies++;
+        }
+    });
+
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) dmxPacket;
+    memset(dmxPacket, 0, sizeof(dmxPacket));
+    memcpy(packet->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    packet->OpCodeLo = ((uint16_t)OpCode::Dmx & 0xFF);
+    packet->OpCodeHi = ((uint16_t)OpCode::Dmx >> 8);
+    packet->LengthHi = 512 >> 8;
+    packet->LengthLo = 512 & 0xFF;
+
+    memset(pollPacket, 0, sizeof(pollPacket));
+    memcpy(pollPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    pollPacket[8] = ((uint16_t)OpCode::Poll & 0xFF);
+    pollPacket[9] = ((uint16_t)OpCode::Poll >> 8);
+}
+
+void tearDown(void) {
+    arduino_shim::useHostClock();
+}
+
+void test_counts_packets_by_opcode_and_error(void) {
+    uint8_t garbage[20];
+    memset(garbage, 0x55, sizeof(garbage));
+
+    uint8_t timeCode[19];
+    memset(timeCode, 0, sizeof(timeCode));
+    memcpy(timeCode, ART_NET_ID, sizeof(ART_NET_ID));
+    timeCode[8] = ((uint16_t)OpCode::TimeCode & 0xFF);
+    timeCode[9] = ((uint16_t)OpCode::TimeCode >> 8);
+
+    sendDmx(0);
+    sendDmx(0, 0x0F);
+    sendPoll(0);
+    artNet.onPacketReceived(0x0A000001, 0x1936, garbage, 4);
+    artNet.onPacketReceived(0x0A000001, 0x1936, garbage, sizeof(garbage));
+    artNet.onPacketReceived(0x0A000001, 0x1936, timeCode, sizeof(timeCode));
+
+    TEST_ASSERT_EQUAL_UINT32(2, artNet.stats.dmx);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxForeign);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.poll);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.badSize);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.badId);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.otherOpCode);
+}
+
+void test_counts_sequence_rejections(void) {
+    sendDmx(10);
+    sendDmx(11);
+    sendDmx(9);
+    sendDmx(12);
+    sendDmx(3);
+
+    TEST_ASSERT_EQUAL_UINT32(2, artNet.getSequenceRejected());
+    TEST_ASSERT_EQUAL_UINT32(0, artNet.getSourceRejected());
+}
+
+void test_node_report_carries_rates_and_counters(void) {
+    artNet.outputStats[0].refreshRate = 44;
+    artNet.outputStats[1].refreshRate = 30;
+
+    sendDmx(10);
+    sendDmx(9);
+    arduino_shim::advanceFakeClock(ART_NET_NODE_REPORT_INTERVAL_MS * 1000UL);
+    artNet.processDiagnostics();
+    sendPoll(0);
+    artNet.processPendingReplies();
+
+    char expected[64] = "#0001 [0000] OK 44/30";
+
+    for (uint8_t i = 2; i < ART_NET_OUTPUT_UNIVERSE_COUNT; i++) {
+        strcat(expected, "/0");
+    }
+
+    strcat(expected, " Hz dmx 2 seq 1 drop 0");
+
+    TEST_ASSERT_EQUAL_STRING(expected, (char*) lastReply.node_report);
+
+    // Until the next refresh, replies only count up.
+    sendDmx(11);
+    artNet.processDiagnostics();
+    arduino_shim::advanceFakeClock(1000000);
+    sendPoll(0);
+    artNet.processPendingReplies();
+
+    expected[10] = '1';
+    TEST_ASSERT_EQUAL_STRING(expected, (char*) lastReply.node_report);
+
+    artNet.processDiagnostics();
+    sendPoll(0);
+    artNet.processPendingReplies();
+    TEST_ASSERT_EQUAL_MEMORY("#0001 [0002] OK", lastReply.node_report, 15);
+    TEST_ASSERT_NOT_NULL(strstr((char*) lastReply.node_report, " dmx 3 "));
+}
+
+void test_diag_data_only_when_requested(void) {
+    sendPoll(0);
+    artNet.processDiagnostics();
+    TEST_ASSERT_EQUAL_UINT32(0, diagPackets);
+
+    // The counters, then the ports.
+    sendPoll(ART_NET_POLL_FLAG_DIAGNOSTICS | ART_NET_POLL_FLAG_DIAG_UNICAST);
+    artNet.processDiagnostics();
+    TEST_ASSERT_EQUAL_UINT32(2, diagPackets);
+    TEST_ASSERT_EQUAL_UINT32(0x0A000002, lastDiagIP);
+
+    // Not again before the interval.
+    arduino_shim::advanceFakeClock((ART_NET_DIAG_INTERVAL_MS - 1) * 1000UL);
+    artNet.processDiagnostics();
+    TEST_ASSERT_EQUAL_UINT32(2, diagPackets);
+
+    arduino_shim::advanceFakeClock(1000);
+    artNet.processDiagnostics();
+    TEST_ASSERT_EQUAL_UINT32(4, diagPackets);
+
+    // A poll without the flag turns it off.
+    sendPoll(0);
+    arduino_shim::advanceFakeClock(ART_NET_DIAG_INTERVAL_MS * 1000UL);
+    artNet.processDiagnostics();
+    TEST_ASSERT_EQUAL_UINT32(4, diagPackets);
+}
+
+void test_diag_data_broadcast_and_priority(void) {
+    sendPoll(ART_NET_POLL_FLAG_DIAGNOSTICS, 0x80);
+    artNet.processDiagnostics();
+    TEST_ASSERT_EQUAL_UINT32(0, diagPackets);
+
+    sendPoll(ART_NET_POLL_FLAG_DIAGNOSTICS, ART_NET_DIAG_PRIORITY_LOW);
+    artNet.processDiagnostics();
+    TEST_ASSERT_EQUAL_UINT32(2, diagPackets);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFF, lastDiagIP);
+}
+
+void test_diag_data_carries_stats_text(void) {
+    artNet.outputStats[0].refreshRate = 44;
+    artNet.outputStats[0].framesSwapped = 1234;
+    artNet.outputStats[0].keepAlives = 5;
+
+    sendDmx(0);
+    sendPoll(ART_NET_POLL_FLAG_DIAGNOSTICS | ART_NET_POLL_FLAG_DIAG_UNICAST);
+    artNet.processDiagnostics();
+
+    uint16_t length = ((uint16_t)lastDiag.LengthHi << 8) | lastDiag.LengthLo;
+
+    TEST_ASSERT_EQUAL_UINT8(ART_NET_DIAG_PRIORITY_LOW, lastDiag.Priority);
+    TEST_ASSERT_EQUAL_UINT16(strlen(lastDiag.Data) + 1, length);
+    TEST_ASSERT_NOT_NULL(strstr(diagTexts[0], "ArtDmx: 1\r\n"));
+    TEST_ASSERT_NOT_NULL(strstr(diagTexts[0], "ArtPoll: 1\r\n"));
+    TEST_ASSERT_NOT_NULL(strstr(diagTexts[1], "Port 1: 44 Hz, 1234 frames, 5 keep alive, 0 NZS, 0 interpolated\r\n"));
+    TEST_ASSERT_NOT_NULL(strstr(diagTexts[1], "Port 3: "));
+}
+
+void test_diag_data_fits_with_the_largest_counters(void) {
+    char buffer[1024];
+
+    memset(&artNet.stats, 0xFF, sizeof(artNet.stats));
+    memset(artNet.outputStats, 0xFF, sizeof(artNet.outputStats));
+
+    TEST_ASSERT_LESS_THAN((int) sizeof(lastDiag.Data), artNet.formatCounters(buffer, sizeof(buffer)));
+    TEST_ASSERT_LESS_THAN((int) sizeof(lastDiag.Data), artNet.formatOutputStats(buffer, sizeof(buffer)));
+
+    // All of it would not.
+    artNet.formatStats(buffer, sizeof(buffer));
+    TEST_ASSERT_GREATER_THAN(sizeof(lastDiag.Data), strlen(buffer));
+}
+
+void test_format_stats_truncates_safely(void) {
+    char buffer[40];
+    memset(buffer, 'x', sizeof(buffer));
+
+    artNet.formatStats(buffer, 32);
+
+    TEST_ASSERT_EQUAL_UINT32(31, strlen(buffer));
+    TEST_ASSERT_EQUAL_UINT8('x', buffer[32]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_counts_packets_by_opcode_and_error);
+    RUN_TEST(test_counts_sequence_rejections);
+    RUN_TEST(test_node_report_carries_rates_and_counters);
+    RUN_TEST(test_diag_data_only_when_requested);
+    RUN_TEST(test_diag_data_broadcast_and_priority);
+    RUN_TEST(test_diag_data_carries_stats_text);
+    RUN_TEST(test_diag_data_fits_with_the_largest_counters);
+    RUN_TEST(test_format_stats_truncates_safely);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <DmxFrameBuffer.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static ArtNet artNet;
+static DmxFrameBuffer *frameBuffer;
+
+static uint8_t dmxPacket[sizeof(ArtNetDmxDataPacket)];
+static uint8_t syncPacket[14];
+
+static void sendDmx(uint8_t value) {
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) dmxPacket;
+    memset(packet->Data, value, sizeof(packet->Data));
+    artNet.onPacketReceived(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+}
+
+static void sendSync() {
+    TEST_ASSERT_EQUAL_INT8((int8_t)PacketParseStatus::Success, (int8_t)artNet.onPacketReceived(0x0A000001, 0x1936, syncPacket, sizeof(syncPacket)));
+}
+
+// What the output task would do once per frame.
+static int16_t outputFrame() {
+    if (!frameBuffer->swap()) {
+        return -1;
+    }
+
+    return frameBuffer->getReadBuffer()[1];
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    artNet = ArtNet();
+    frameBuffer = new DmxFrameBuffer();
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        memcpy(frameBuffer->beginWrite(ctrlByte, size), data, size);
+        frameBuffer->stageWrite();
+    });
+
+    artNet.setDmxCommitCallback([]() {
+        frameBuffer->publish();
+    });
+
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {});
+
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) dmxPacket;
+    memset(dmxPacket, 0, sizeof(dmxPacket));
+    memcpy(packet->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    packet->OpCodeLo = ((uint16_t)OpCode::Dmx & 0xFF);
+    packet->OpCodeHi = ((uint16_t)OpCode::Dmx >> 8);
+    packet->LengthHi = 512 >> 8;
+    packet->LengthLo = 512 & 0xFF;
+
+    memset(syncPacket, 0, sizeof(syncPacket));
+    memcpy(syncPacket, ART_NET_ID, sizeof(ART_NET_ID));
+    syncPacket[8] = ((uint16_t)OpCode::Sync & 0xFF);
+    syncPacket[9] = ((uint16_t)OpCode::Sync >> 8);
+    syncPacket[11] = 14;
+}
+
+void tearDown(void) {
+    delete frameBuffer;
+    arduino_shim::useHostClock();
+}
+
+void test_without_sync_frames_go_out_immediately(void) {
+    sendDmx(1);
+    TEST_ASSERT_FALSE(artNet.isSynchronous());
+    TEST_ASSERT_EQUAL_INT16(1, outputFrame());
+
+    sendDmx(2);
+    TEST_ASSERT_EQUAL_INT16(2, outputFrame());
+}
+
+void test_frames_are_held_until_sync(void) {
+    sendSync();
+    TEST_ASSERT_TRUE(artNet.isSynchronous());
+    TEST_ASSERT_EQUAL_INT16(-1, outputFrame());
+
+    // Interleaved stream at ~40 Hz: every frame must wait for its ArtSync.
+    for (uint8_t i = 1; i <= 40; i++) {
+        arduino_shim::advanceFakeClock(12000);
+        sendDmx(i);
+        TEST_ASSERT_EQUAL_INT16(-1, outputFrame());
+
+        arduino_shim::advanceFakeClock(13000);
+        sendSync();
+        TEST_ASSERT_EQUAL_INT16(i, outputFrame());
+        TEST_ASSERT_EQUAL_INT16(-1, outputFrame());
+    }
+}
+
+void test_only_latest_staged_frame_is_swapped_on_sync(void) {
+    sendSync();
+
+    sendDmx(10);
+    sendDmx(11);
+    sendDmx(12);
+    TEST_ASSERT_EQUAL_INT16(-1, outputFrame());
+
+    sendSync();
+    TEST_ASSERT_EQUAL_INT16(12, outputFrame());
+    TEST_ASSERT_EQUAL_INT16(-1, outputFrame());
+}
+
+void test_sync_without_new_data_does_not_swap(void) {
+    sendSync();
+    sendSync();
+    TEST_ASSERT_EQUAL_INT16(-1, outputFrame());
+}
+
+void test_falls_back_to_immediate_after_timeout(void) {
+    sendSync();
+
+    arduino_shim::advanceFakeClock((ART_NET_SYNC_TIMEOUT_MS - 100) * 1000UL);
+    sendDmx(5);
+    TEST_ASSERT_TRUE(artNet.isSynchronous());
+    TEST_ASSERT_EQUAL_INT16(-1, outputFrame());
+
+    arduino_shim::advanceFakeClock(200 * 1000UL);
+    sendDmx(6);
+    TEST_ASSERT_FALSE(artNet.isSynchronous());
+    TEST_ASSERT_EQUAL_INT16(6, outputFrame());
+
+    sendDmx(7);
+    TEST_ASSERT_EQUAL_INT16(7, outputFrame());
+
+    // Syncs resuming put the node back in synchronous mode.
+    sendSync();
+    sendDmx(8);
+    TEST_ASSERT_EQUAL_INT16(-1, outputFrame());
+    sendSync();
+    TEST_ASSERT_EQUAL_INT16(8, outputFrame());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_without_sync_frames_go_out_immediately);
+    RUN_TEST(test_frames_are_held_until_sync);
+    RUN_TEST(test_only_latest_staged_frame_is_swapped_on_sync);
+    RUN_TEST(test_sync_without_new_data_does_not_swap);
+    RUN_TEST(test_falls_back_to_immediate_after_timeout);
+    return UNITY_END();
+}
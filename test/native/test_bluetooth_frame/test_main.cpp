@@ -0,0 +1,281 @@
+#include <Arduino.h>
+#include <Bench.h>
+#include <BluetoothFrameParser.h>
+#include <unity.h>
+
+#define MAX_FRAME_SIZE (BLUETOOTH_FRAME_HEADER_SIZE + BLUETOOTH_FRAME_MAX_PAYLOAD + BLUETOOTH_FRAME_CRC_SIZE)
+
+static BluetoothFrameParser *parser;
+static uint8_t payload[BLUETOOTH_FRAME_MAX_PAYLOAD];
+static uint8_t frame[MAX_FRAME_SIZE];
+static unsigned long now;
+
+typedef struct {
+    uint32_t complete;
+    uint32_t errors;
+} PushResults;
+
+static PushResults pushAll(const uint8_t *data, uint32_t size) {
+    PushResults results = { 0, 0 };
+
+    for (uint32_t i = 0; i < size; i++) {
+        BluetoothFrameResult result = parser->push(data[i], now);
+
+        if (result == BLUETOOTH_FRAME_COMPLETE) {
+            results.complete++;
+        } else if (result == BLUETOOTH_FRAME_ERROR) {
+            results.errors++;
+        }
+    }
+
+    return results;
+}
+
+static uint32_t encode(uint8_t type, uint16_t size, uint8_t seed) {
+    for (uint16_t i = 0; i < size; i++) {
+        payload[i] = seed + i * 7;
+    }
+
+    return BluetoothFrameEncode(type, payload, size, frame);
+}
+
+static void assertFrame(uint8_t type, uint16_t size) {
+    TEST_ASSERT_EQUAL_UINT8(type, parser->getType());
+    TEST_ASSERT_EQUAL_UINT16(size, parser->getLength());
+
+    if (size) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, parser->getPayload(), size);
+    }
+}
+
+void setUp(void) {
+    parser = new BluetoothFrameParser();
+    now = 1000;
+}
+
+void tearDown(void) {
+    delete parser;
+}
+
+void test_round_trip(void) {
+    const uint16_t sizes[] = { 0, 1, 26, 433, BLUETOOTH_FRAME_MAX_PAYLOAD };
+
+    for (uint8_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t size = encode(i + 1, sizes[i], i);
+
+        TEST_ASSERT_EQUAL_UINT32(BLUETOOTH_FRAME_HEADER_SIZE + sizes[i] + BLUETOOTH_FRAME_CRC_SIZE, size);
+
+        for (uint32_t j = 0; j < size - 1; j++) {
+            TEST_ASSERT_EQUAL(BLUETOOTH_FRAME_PENDING, parser->push(frame[j], now));
+        }
+
+        TEST_ASSERT_EQUAL(BLUETOOTH_FRAME_COMPLETE, parser->push(frame[size - 1], now));
+        assertFrame(i + 1, sizes[i]);
+        TEST_ASSERT_TRUE(parser->isIdle());
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(5, parser->stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(0, parser->stats.skippedBytes);
+}
+
+void test_pieces_across_loops(void) {
+    uint32_t size = encode(1, 433, 3);
+    uint32_t offset = 0;
+
+    // RFCOMM pieces of whatever size, a few ms apart.
+    while (offset < size) {
+        uint32_t piece = 1 + random(40);
+
+        if (offset + piece > size) {
+            piece = size - offset;
+        }
+
+        PushResults results = pushAll(frame + offset, piece);
+        offset += piece;
+        now += 5;
+
+        TEST_ASSERT_EQUAL_UINT32(offset == size ? 1 : 0, results.complete);
+        TEST_ASSERT_FALSE(parser->expire(now));
+    }
+
+    assertFrame(1, 433);
+}
+
+void test_coalesced_frames(void) {
+    uint8_t stream[3 * 64];
+    uint32_t frameSize = encode(5, 13, 0);
+    uint32_t size = 3 * frameSize;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        memcpy(stream + i * frameSize, frame, frameSize);
+    }
+
+    uint32_t complete = 0;
+
+    for (uint32_t i = 0; i < size; i++) {
+        if (parser->push(stream[i], now) == BLUETOOTH_FRAME_COMPLETE) {
+            // Handled before the next byte is pushed.
+            assertFrame(5, 13);
+            complete++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(3, complete);
+}
+
+void test_noise_before_frame(void) {
+    const uint8_t noise[] = { 0x00, 0x03, BLUETOOTH_FRAME_SYNC_0, 0x11, BLUETOOTH_FRAME_SYNC_0, BLUETOOTH_FRAME_SYNC_0 };
+    uint32_t size = encode(2, 26, 9);
+
+    TEST_ASSERT_EQUAL_UINT32(0, pushAll(noise, sizeof(noise)).complete);
+    TEST_ASSERT_EQUAL_UINT32(1, pushAll(frame, size).complete);
+    assertFrame(2, 26);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(noise), parser->stats.skippedBytes);
+}
+
+void test_bad_crc_then_next_frame(void) {
+    uint32_t size = encode(1, 100, 1);
+
+    frame[BLUETOOTH_FRAME_HEADER_SIZE + 40] ^= 0x04;
+    PushResults results = pushAll(frame, size);
+    TEST_ASSERT_EQUAL_UINT32(0, results.complete);
+    TEST_ASSERT_EQUAL_UINT32(1, results.errors);
+    TEST_ASSERT_EQUAL_UINT32(1, parser->stats.crcErrors);
+    TEST_ASSERT_TRUE(parser->isIdle());
+
+    size = encode(1, 100, 1);
+    TEST_ASSERT_EQUAL_UINT32(1, pushAll(frame, size).complete);
+    assertFrame(1, 100);
+}
+
+void test_too_long_is_dropped_at_the_header(void) {
+    const uint8_t header[] = { BLUETOOTH_FRAME_SYNC_0, BLUETOOTH_FRAME_SYNC_1, 1, 0xFF, 0xFF };
+
+    PushResults results = pushAll(header, sizeof(header));
+    TEST_ASSERT_EQUAL_UINT32(1, results.errors);
+    TEST_ASSERT_EQUAL_UINT32(1, parser->stats.lengthErrors);
+    TEST_ASSERT_TRUE(parser->isIdle());
+
+    uint32_t size = encode(3, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, pushAll(frame, size).complete);
+    assertFrame(3, 0);
+}
+
+void test_partial_frame_times_out(void) {
+    uint32_t size = encode(1, 433, 2);
+
+    pushAll(frame, size / 2);
+    now += BLUETOOTH_FRAME_TIMEOUT_MS;
+    TEST_ASSERT_FALSE(parser->expire(now));
+    now += 1;
+    TEST_ASSERT_TRUE(parser->expire(now));
+    TEST_ASSERT_TRUE(parser->isIdle());
+    TEST_ASSERT_EQUAL_UINT32(1, parser->stats.timeouts);
+
+    // The app sends it again in full.
+    TEST_ASSERT_EQUAL_UINT32(1, pushAll(frame, size).complete);
+
+    // Also dropped by the next byte if expire isn't called.
+    pushAll(frame, 10);
+    now += 2 * BLUETOOTH_FRAME_TIMEOUT_MS;
+    TEST_ASSERT_EQUAL_UINT32(1, pushAll(frame, size).complete);
+    TEST_ASSERT_EQUAL_UINT32(2, parser->stats.timeouts);
+    assertFrame(1, 433);
+}
+
+// Random streams and damaged frames: the parser never reports a frame that
+// wasn't sent, and a whole frame after a pause always gets through.
+void test_fuzz(void) {
+    uint8_t stream[2 * MAX_FRAME_SIZE];
+    uint32_t delivered = 0;
+
+    srand(2024);
+
+    for (uint32_t round = 0; round < 20000; round++) {
+        uint16_t length = random(BLUETOOTH_FRAME_MAX_PAYLOAD + 1);
+        uint8_t type = random(256);
+        uint32_t size = encode(type, length, random(256));
+        uint32_t streamSize = 0;
+
+        switch (round % 4) {
+            case 0:
+                // Pure noise, now and then a sync pair.
+                streamSize = random(sizeof(stream));
+                for (uint32_t i = 0; i < streamSize; i++) {
+                    stream[i] = random(8) ? random(256) : (random(2) ? BLUETOOTH_FRAME_SYNC_0 : BLUETOOTH_FRAME_SYNC_1);
+                }
+                break;
+            case 1:
+                // Flipped bits.
+                memcpy(stream, frame, size);
+                for (uint8_t flips = 1 + random(3); flips > 0; flips--) {
+                    stream[random(size)] ^= 1 << random(8);
+                }
+                streamSize = size;
+                break;
+            case 2:
+                // Cut short.
+                memcpy(stream, frame, size);
+                streamSize = random(size);
+                break;
+            case 3:
+                // Bytes lost in the middle.
+                memcpy(stream, frame, size);
+                streamSize = random(size);
+                memcpy(stream + streamSize, frame + streamSize + 1, size - streamSize - 1);
+                streamSize = size - 1;
+                break;
+        }
+
+        for (uint32_t i = 0; i < streamSize; i++) {
+            if (parser->push(stream[i], now) == BLUETOOTH_FRAME_COMPLETE) {
+                // Only a flip that cancelled itself out gives the sent frame.
+                TEST_ASSERT_EQUAL_UINT32(1, round % 4);
+                assertFrame(type, length);
+            }
+        }
+
+        now += BLUETOOTH_FRAME_TIMEOUT_MS + 1;
+        size = encode(type, length, round);
+
+        if (pushAll(frame, size).complete == 1) {
+            delivered++;
+        }
+
+        assertFrame(type, length);
+        now += 1;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(20000, delivered);
+    printf("[fuzz] %u frames, %u CRC errors, %u length errors, %u timeouts, %u bytes skipped\n",
+        parser->stats.frames, parser->stats.crcErrors, parser->stats.lengthErrors,
+        parser->stats.timeouts, parser->stats.skippedBytes);
+}
+
+void test_cost_per_byte(void) {
+    uint32_t size = encode(1, 433, 0);
+    uint32_t complete = 0;
+
+    double ns = bench::nsPerOp(size * 2000, [size, &complete](uint32_t i) {
+        if (parser->push(frame[i % size], now) == BLUETOOTH_FRAME_COMPLETE) {
+            complete++;
+        }
+    });
+
+    bench::report("Bluetooth frame push, per byte", ns);
+    TEST_ASSERT_EQUAL_UINT32(2000, complete);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_pieces_across_loops);
+    RUN_TEST(test_coalesced_frames);
+    RUN_TEST(test_noise_before_frame);
+    RUN_TEST(test_bad_crc_then_next_frame);
+    RUN_TEST(test_too_long_is_dropped_at_the_header);
+    RUN_TEST(test_partial_frame_times_out);
+    RUN_TEST(test_fuzz);
+    RUN_TEST(test_cost_per_byte);
+    return UNITY_END();
+}
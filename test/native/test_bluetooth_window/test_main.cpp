@@ -0,0 +1,105 @@
+#include <Arduino.h>
+#include <BluetoothWindow.h>
+#include <unity.h>
+
+#define WINDOW_MS 60000
+
+static BluetoothWindow *window;
+
+// Loop iterations every ms from `from` to `to`, returns the first action.
+static BluetoothWindowAction run(unsigned long from, unsigned long to, bool busy = false, bool pressed = false) {
+    for (unsigned long now = from; now <= to; now++) {
+        window->setButton(pressed, now);
+        BluetoothWindowAction action = window->update(now, busy);
+
+        if (action != BLUETOOTH_WINDOW_NONE) {
+            return action;
+        }
+    }
+
+    return BLUETOOTH_WINDOW_NONE;
+}
+
+void setUp(void) {
+    window = new BluetoothWindow();
+    window->begin(WINDOW_MS, 0);
+}
+
+void tearDown(void) {
+    delete window;
+}
+
+void test_on_at_boot_then_stopped(void) {
+    TEST_ASSERT_TRUE(window->isOn());
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(0, WINDOW_MS - 1));
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_STOP, window->update(WINDOW_MS, false));
+    TEST_ASSERT_FALSE(window->isOn());
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(WINDOW_MS, 10 * WINDOW_MS));
+    TEST_ASSERT_EQUAL_UINT32(1, window->stops);
+}
+
+void test_always_on_without_window(void) {
+    window->begin(0, 0);
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(0, 10 * WINDOW_MS));
+    TEST_ASSERT_TRUE(window->isOn());
+}
+
+void test_requests_and_clients_keep_it_on(void) {
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(0, WINDOW_MS / 2));
+    window->touch(WINDOW_MS / 2);
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(WINDOW_MS / 2 + 1, WINDOW_MS + WINDOW_MS / 2 - 1));
+
+    // A connected app, however long.
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(WINDOW_MS, 5 * WINDOW_MS, true));
+    // The window starts over once it disconnects.
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(5 * WINDOW_MS + 1, 6 * WINDOW_MS - 1));
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_STOP, window->update(6 * WINDOW_MS, false));
+}
+
+void test_button_starts_it_again(void) {
+    run(0, WINDOW_MS);
+    TEST_ASSERT_FALSE(window->isOn());
+
+    // Bounces shorter than the debounce do nothing.
+    for (unsigned long now = 2 * WINDOW_MS; now < 2 * WINDOW_MS + 1000; now += 100) {
+        TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(now, now + BLUETOOTH_BUTTON_DEBOUNCE_MS / 2, false, true));
+        TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(now + BLUETOOTH_BUTTON_DEBOUNCE_MS / 2 + 1, now + 99));
+    }
+
+    unsigned long pressed = 3 * WINDOW_MS;
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_START, run(pressed, pressed + 1000, false, true));
+    TEST_ASSERT_TRUE(window->isOn());
+    TEST_ASSERT_EQUAL_UINT32(1, window->starts);
+
+    // Held down, it doesn't count again; the window runs from the press.
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(pressed + BLUETOOTH_BUTTON_DEBOUNCE_MS + 1, pressed + 5000, false, true));
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(pressed + 5001, pressed + BLUETOOTH_BUTTON_DEBOUNCE_MS + WINDOW_MS - 1));
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_STOP, window->update(pressed + BLUETOOTH_BUTTON_DEBOUNCE_MS + WINDOW_MS, false));
+}
+
+void test_press_while_on_extends(void) {
+    run(0, WINDOW_MS - 100);
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(WINDOW_MS - 99, WINDOW_MS, false, true));
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, run(WINDOW_MS + 1, 2 * WINDOW_MS - 100));
+    TEST_ASSERT_TRUE(window->isOn());
+    TEST_ASSERT_EQUAL_UINT32(0, window->starts);
+}
+
+void test_survives_millis_wrap(void) {
+    unsigned long start = 0xFFFFFFFF - WINDOW_MS / 2;
+
+    window->begin(WINDOW_MS, start);
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_NONE, window->update(start + WINDOW_MS - 1, false));
+    TEST_ASSERT_EQUAL(BLUETOOTH_WINDOW_STOP, window->update((uint32_t)(start + WINDOW_MS), false));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_on_at_boot_then_stopped);
+    RUN_TEST(test_always_on_without_window);
+    RUN_TEST(test_requests_and_clients_keep_it_on);
+    RUN_TEST(test_button_starts_it_again);
+    RUN_TEST(test_press_while_on_extends);
+    RUN_TEST(test_survives_millis_wrap);
+    return UNITY_END();
+}
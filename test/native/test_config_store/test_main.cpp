@@ -0,0 +1,311 @@
+#include <Arduino.h>
+#include <Bench.h>
+#include <ConfigStore.h>
+#include <EEPROM_Data.h>
+#include <FakeFlash.h>
+#include <unity.h>
+
+#define CONFIG_VERSION 1
+
+static FakeFlash *flash;
+static ConfigStore *store;
+static EEPROM_Data config;
+
+static void defaults(EEPROM_Data *data) {
+    memset(data, 0, sizeof(EEPROM_Data));
+    strcpy(data->systemPassword, "secret");
+    data->channelCount = DMX_MAX_CHANNELS;
+    data->wirelessMode = WIRELESS_MODE_CLIENT_DHCP;
+    strcpy(data->wirelessSSID, "Stage WiFi");
+    strcpy(data->wirelessPassword, "password");
+
+    for (uint8_t i = 0; i < EEPROM_DATA_OUTPUT_PORTS; i++) {
+        data->portUniverse[i] = i;
+    }
+}
+
+// What a node booting on `flash` would read.
+static bool reload(EEPROM_Data *data, uint16_t version = CONFIG_VERSION) {
+    ConfigStore other;
+
+    other.begin(flash, version, sizeof(EEPROM_Data));
+    return other.load((uint8_t*) data);
+}
+
+static void assertStored(const EEPROM_Data *expected) {
+    EEPROM_Data loaded;
+
+    TEST_ASSERT_TRUE(reload(&loaded));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY((const uint8_t*) expected, (const uint8_t*) &loaded, sizeof(EEPROM_Data));
+}
+
+void setUp(void) {
+    flash = new FakeFlash(2 * CONFIG_STORE_SECTOR_SIZE);
+    store = new ConfigStore();
+    store->begin(flash, CONFIG_VERSION, sizeof(EEPROM_Data));
+    defaults(&config);
+}
+
+void tearDown(void) {
+    delete store;
+    delete flash;
+}
+
+void test_blank_flash_has_no_config(void) {
+    EEPROM_Data loaded;
+
+    TEST_ASSERT_FALSE(store->load((uint8_t*) &loaded));
+    TEST_ASSERT_TRUE(store->store((const uint8_t*) &config));
+    TEST_ASSERT_EQUAL_UINT32(1, flash->erases);
+    TEST_ASSERT_EQUAL_UINT32(0, flash->dirtyWrites);
+    assertStored(&config);
+}
+
+void test_field_change_writes_only_the_field(void) {
+    store->load((uint8_t*) &config);
+    store->store((const uint8_t*) &config);
+
+    uint32_t before = flash->bytesWritten;
+
+    config.net = 3;
+    config.subuni = 7;
+    TEST_ASSERT_TRUE(store->store((const uint8_t*) &config));
+
+    // Record, one range of 2 bytes, CRC.
+    TEST_ASSERT_EQUAL_UINT32(14, flash->bytesWritten - before);
+    TEST_ASSERT_EQUAL_UINT32(1, flash->erases);
+    TEST_ASSERT_EQUAL_UINT32(0, flash->dirtyWrites);
+    assertStored(&config);
+
+    // Nothing changed, nothing written.
+    before = flash->bytesWritten;
+    TEST_ASSERT_TRUE(store->store((const uint8_t*) &config));
+    TEST_ASSERT_EQUAL_UINT32(before, flash->bytesWritten);
+}
+
+void test_far_apart_changes_are_one_record(void) {
+    store->load((uint8_t*) &config);
+    store->store((const uint8_t*) &config);
+
+    config.systemPassword[0] = 'S';
+    config.portMode[EEPROM_DATA_OUTPUT_PORTS - 1] = PORT_MODE_INPUT;
+
+    uint32_t records = store->records;
+    uint32_t before = flash->bytesWritten;
+
+    TEST_ASSERT_TRUE(store->store((const uint8_t*) &config));
+    TEST_ASSERT_EQUAL_UINT32(records + 1, store->records);
+    // Two ranges of a byte, not the bytes between them.
+    TEST_ASSERT_EQUAL_UINT32(4 + 2 * (4 + 1) + 4, flash->bytesWritten - before);
+    assertStored(&config);
+}
+
+void test_full_sector_moves_to_the_other(void) {
+    store->load((uint8_t*) &config);
+    store->store((const uint8_t*) &config);
+
+    uint32_t sequence = store->getSequence();
+
+    for (uint16_t i = 0; i < 1000; i++) {
+        config.subuni = i;
+        config.net = i % 8;
+        TEST_ASSERT_TRUE(store->store((const uint8_t*) &config));
+        TEST_ASSERT_LESS_OR_EQUAL(CONFIG_STORE_SECTOR_SIZE, store->getUsed());
+
+        if (i % 97 == 0) {
+            assertStored(&config);
+        }
+    }
+
+    assertStored(&config);
+    TEST_ASSERT_EQUAL_UINT32(0, flash->dirtyWrites);
+    TEST_ASSERT_EQUAL_UINT32(flash->erases, store->erases);
+    TEST_ASSERT_EQUAL_UINT32(sequence + flash->erases - 1, store->getSequence());
+
+    printf("[config] 1000 net/subuni changes: %u erases, %u bytes written (whole struct: 1000 erases, %u bytes)\n",
+        flash->erases, flash->bytesWritten, (unsigned)(1000 * sizeof(EEPROM_Data)));
+    TEST_ASSERT_LESS_THAN(10, flash->erases);
+}
+
+// Power cut at every byte of a store: the config is the old or the new one,
+// never a mix, and the node keeps storing afterwards.
+static void cutEverywhere(void (*change)(EEPROM_Data*), uint16_t changesBefore, uint32_t erases) {
+    FakeFlash base(2 * CONFIG_STORE_SECTOR_SIZE);
+    EEPROM_Data before = config;
+
+    store->begin(&base, CONFIG_VERSION, sizeof(EEPROM_Data));
+    store->load((uint8_t*) &before);
+    store->store((const uint8_t*) &before);
+
+    for (uint16_t i = 0; i < changesBefore; i++) {
+        before.channelCount = 1 + i % DMX_MAX_CHANNELS;
+        store->store((const uint8_t*) &before);
+    }
+
+    EEPROM_Data after = before;
+    change(&after);
+
+    bool sawOld = false;
+    bool sawNew = false;
+
+    for (uint32_t cut = 0; ; cut++) {
+        FakeFlash *copy = new FakeFlash(base);
+        ConfigStore writer;
+        EEPROM_Data loaded;
+
+        writer.begin(copy, CONFIG_VERSION, sizeof(EEPROM_Data));
+        writer.load((uint8_t*) &loaded);
+        copy->cutAfter(cut);
+
+        bool completed = writer.store((const uint8_t*) &after);
+
+        delete flash;
+        flash = copy;
+        copy->cutAfter(UINT32_MAX);
+        TEST_ASSERT_TRUE(reload(&loaded));
+
+        if (memcmp(&loaded, &after, sizeof(EEPROM_Data)) == 0) {
+            sawNew = true;
+        } else {
+            TEST_ASSERT_FALSE(completed);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY((const uint8_t*) &before, (const uint8_t*) &loaded, sizeof(EEPROM_Data));
+            sawOld = true;
+        }
+
+        // After the reset.
+        ConfigStore rebooted;
+        EEPROM_Data next = loaded;
+
+        rebooted.begin(flash, CONFIG_VERSION, sizeof(EEPROM_Data));
+        rebooted.load((uint8_t*) &loaded);
+        next.net = 5;
+        TEST_ASSERT_TRUE(rebooted.store((const uint8_t*) &next));
+        assertStored(&next);
+        TEST_ASSERT_EQUAL_UINT32(0, flash->dirtyWrites);
+
+        if (completed) {
+            TEST_ASSERT_EQUAL_UINT32(erases, writer.erases);
+            break;
+        }
+    }
+
+    TEST_ASSERT_TRUE(sawOld);
+    TEST_ASSERT_TRUE(sawNew);
+}
+
+static void changeSubuni(EEPROM_Data *data) {
+    data->subuni = 9;
+}
+
+static void changeWiFi(EEPROM_Data *data) {
+    strcpy(data->wirelessSSID, "Other WiFi");
+    strcpy(data->wirelessPassword, "other password");
+}
+
+void test_power_cut_while_appending(void) {
+    cutEverywhere(changeSubuni, 0, 0);
+    cutEverywhere(changeWiFi, 10, 0);
+}
+
+void test_power_cut_while_switching_sector(void) {
+    // Fills the first sector up to where the next change no longer fits.
+    store->load((uint8_t*) &config);
+    store->store((const uint8_t*) &config);
+
+    uint16_t changes = 0;
+
+    while (store->getUsed() + 16 <= CONFIG_STORE_SECTOR_SIZE) {
+        config.channelCount = 1 + changes % DMX_MAX_CHANNELS;
+        store->store((const uint8_t*) &config);
+        changes++;
+    }
+
+    cutEverywhere(changeWiFi, changes, 1);
+}
+
+void test_bad_record_stops_the_replay(void) {
+    store->load((uint8_t*) &config);
+    store->store((const uint8_t*) &config);
+
+    EEPROM_Data good = config;
+    uint16_t used = store->getUsed();
+
+    config.net = 4;
+    store->store((const uint8_t*) &config);
+
+    // A bit of the last record flips.
+    flash->corrupt(used + 6, 0x10);
+    assertStored(&good);
+
+    // The store that follows goes to the other sector.
+    ConfigStore rebooted;
+    EEPROM_Data loaded;
+
+    rebooted.begin(flash, CONFIG_VERSION, sizeof(EEPROM_Data));
+    TEST_ASSERT_TRUE(rebooted.load((uint8_t*) &loaded));
+    loaded.subuni = 2;
+    TEST_ASSERT_TRUE(rebooted.store((const uint8_t*) &loaded));
+    TEST_ASSERT_EQUAL_UINT32(1, rebooted.erases);
+    TEST_ASSERT_EQUAL_UINT32(0, flash->dirtyWrites);
+    assertStored(&loaded);
+}
+
+void test_other_layout_is_not_loaded(void) {
+    EEPROM_Data loaded;
+
+    store->load((uint8_t*) &config);
+    store->store((const uint8_t*) &config);
+    TEST_ASSERT_FALSE(reload(&loaded, CONFIG_VERSION + 1));
+
+    ConfigStore smaller;
+
+    smaller.begin(flash, CONFIG_VERSION, sizeof(EEPROM_Data) - 1);
+    TEST_ASSERT_FALSE(smaller.load((uint8_t*) &loaded));
+
+    // Its first store doesn't go over the sector of the old layout, which
+    // can still be migrated from if it is cut.
+    TEST_ASSERT_TRUE(smaller.store((const uint8_t*) &config));
+    TEST_ASSERT_GREATER_THAN((int32_t) 0, (int32_t)(smaller.getSequence() - store->getSequence()));
+    assertStored(&config);
+}
+
+void test_crc_matches_zlib(void) {
+    const char *text = "123456789";
+
+    TEST_ASSERT_EQUAL_UINT32(0xCBF43926, ConfigStoreCrc(0, (const uint8_t*) text, 9));
+    TEST_ASSERT_EQUAL_UINT32(0xCBF43926, ConfigStoreCrc(ConfigStoreCrc(0, (const uint8_t*) text, 4), (const uint8_t*) text + 4, 5));
+}
+
+void test_boot_load_cost(void) {
+    store->load((uint8_t*) &config);
+    store->store((const uint8_t*) &config);
+
+    while (store->getUsed() + 64 <= CONFIG_STORE_SECTOR_SIZE) {
+        config.subuni++;
+        store->store((const uint8_t*) &config);
+    }
+
+    EEPROM_Data loaded;
+    double ns = bench::nsPerOp(2000, [&loaded](uint32_t i) {
+        reload(&loaded);
+        bench::doNotOptimize(loaded.subuni);
+    });
+
+    bench::report("Load config, full journal", ns);
+    TEST_ASSERT_EQUAL_UINT8(config.subuni, loaded.subuni);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_blank_flash_has_no_config);
+    RUN_TEST(test_field_change_writes_only_the_field);
+    RUN_TEST(test_far_apart_changes_are_one_record);
+    RUN_TEST(test_full_sector_moves_to_the_other);
+    RUN_TEST(test_power_cut_while_appending);
+    RUN_TEST(test_power_cut_while_switching_sector);
+    RUN_TEST(test_bad_record_stops_the_replay);
+    RUN_TEST(test_other_layout_is_not_loaded);
+    RUN_TEST(test_crc_matches_zlib);
+    RUN_TEST(test_boot_load_cost);
+    return UNITY_END();
+}
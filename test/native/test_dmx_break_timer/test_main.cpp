@@ -0,0 +1,155 @@
+#include <Arduino.h>
+#include <DmxBreakTimer.h>
+#include <unity.h>
+
+// 250 kbaud, 8N2: 44 us per slot.
+#define SLOT_MICROS 44
+
+// Line and timer on the shim clock. The timer fires late by up to
+// `timerLatencyMicros` and the woken task starts sending up to
+// `wakeLatencyMicros` after signalDone, like under a busy scheduler.
+class SimulatedLineHal : public DmxLineHal {
+    public:
+        DmxBreakTimer *breakTimer;
+        uint32_t timerLatencyMicros = 0;
+        uint32_t wakeLatencyMicros = 0;
+
+        bool lineLow = false;
+        bool timerArmed = false;
+        bool done = false;
+        unsigned long timerDue = 0;
+        unsigned long breakStart = 0;
+        unsigned long breakEnd = 0;
+        unsigned long doneAt = 0;
+        uint32_t transitions = 0;
+
+        void setBreak(bool active) override {
+            TEST_ASSERT_NOT_EQUAL(active, lineLow);
+            lineLow = active;
+            transitions++;
+
+            if (active) {
+                breakStart = micros();
+            } else {
+                breakEnd = micros();
+            }
+        }
+
+        void startTimer(uint32_t us) override {
+            TEST_ASSERT_FALSE(timerArmed);
+            timerArmed = true;
+            timerDue = micros() + us + (timerLatencyMicros ? random((long)timerLatencyMicros + 1) : 0);
+        }
+
+        void signalDone() override {
+            done = true;
+            doneAt = micros();
+        }
+
+        // Runs the clock until the task would start sending the slots.
+        // Returns the time the first slot starts.
+        unsigned long runUntilSlots() {
+            while (!done) {
+                TEST_ASSERT_TRUE(timerArmed);
+                arduino_shim::advanceFakeClock(timerDue - micros());
+                timerArmed = false;
+                breakTimer->onTimer();
+            }
+
+            done = false;
+            arduino_shim::advanceFakeClock(wakeLatencyMicros ? random((long)wakeLatencyMicros + 1) : 0);
+
+            return micros();
+        }
+};
+
+static SimulatedLineHal *hal;
+static DmxBreakTimer *breakTimer;
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+    srand(11);
+
+    hal = new SimulatedLineHal();
+    breakTimer = new DmxBreakTimer();
+    hal->breakTimer = breakTimer;
+    breakTimer->begin(hal);
+}
+
+void tearDown(void) {
+    delete breakTimer;
+    delete hal;
+    arduino_shim::useHostClock();
+}
+
+void test_exact_timing_without_load(void) {
+    TEST_ASSERT_TRUE(breakTimer->start());
+    TEST_ASSERT_TRUE(hal->lineLow);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxBreakState::Break, (uint8_t)breakTimer->getState());
+
+    unsigned long slotsStart = hal->runUntilSlots();
+
+    TEST_ASSERT_FALSE(hal->lineLow);
+    TEST_ASSERT_EQUAL_UINT32(DMX_BREAK_LOW_INTERVAL_MICROS, hal->breakEnd - hal->breakStart);
+    TEST_ASSERT_EQUAL_UINT32(DMX_BREAK_HIGH_INTERVAL_MICROS, slotsStart - hal->breakEnd);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxBreakState::Idle, (uint8_t)breakTimer->getState());
+}
+
+void test_start_is_refused_while_running(void) {
+    TEST_ASSERT_TRUE(breakTimer->start());
+    TEST_ASSERT_FALSE(breakTimer->start());
+    TEST_ASSERT_EQUAL_UINT32(1, hal->transitions);
+
+    hal->runUntilSlots();
+    TEST_ASSERT_TRUE(breakTimer->start());
+}
+
+void test_spurious_timer_is_ignored(void) {
+    breakTimer->onTimer();
+    TEST_ASSERT_EQUAL_UINT32(0, hal->transitions);
+    TEST_ASSERT_FALSE(hal->done);
+}
+
+void test_minimums_hold_under_load(void) {
+    static const uint32_t FRAMES = 20000;
+
+    hal->timerLatencyMicros = 400;
+    hal->wakeLatencyMicros = 200;
+
+    uint32_t minBreak = 0xFFFFFFFF;
+    uint32_t maxBreak = 0;
+    uint32_t minMab = 0xFFFFFFFF;
+    uint32_t maxMab = 0;
+
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        TEST_ASSERT_TRUE(breakTimer->start());
+        unsigned long slotsStart = hal->runUntilSlots();
+
+        uint32_t breakMicros = hal->breakEnd - hal->breakStart;
+        uint32_t mabMicros = slotsStart - hal->breakEnd;
+
+        minBreak = breakMicros < minBreak ? breakMicros : minBreak;
+        maxBreak = breakMicros > maxBreak ? breakMicros : maxBreak;
+        minMab = mabMicros < minMab ? mabMicros : minMab;
+        maxMab = mabMicros > maxMab ? mabMicros : maxMab;
+
+        // Slots, then the line idles at mark for a random while.
+        arduino_shim::advanceFakeClock(513 * SLOT_MICROS + random(300L));
+    }
+
+    printf("[break] %u frames under load: break %u..%u us, MAB %u..%u us\n", FRAMES, minBreak, maxBreak, minMab, maxMab);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(92, minBreak);
+    TEST_ASSERT_GREATER_OR_EQUAL(12, minMab);
+    // Spec maximum for MAB is 1 s.
+    TEST_ASSERT_LESS_THAN(1000000, maxMab);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_exact_timing_without_load);
+    RUN_TEST(test_start_is_refused_while_running);
+    RUN_TEST(test_spurious_timer_is_ignored);
+    RUN_TEST(test_minimums_hold_under_load);
+    return UNITY_END();
+}
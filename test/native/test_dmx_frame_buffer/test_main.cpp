@@ -0,0 +1,154 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <DmxFrameBuffer.h>
+#include <unity.h>
+#include <stdio.h>
+
+static DmxFrameBuffer *frameBuffer;
+
+// What the output should see: every packet overwrites its slots, the rest
+// keeps the previous value.
+static uint8_t expectedFrame[DMX_FRAME_SIZE];
+
+static void writePacket(uint16_t size, uint8_t seed) {
+    uint8_t *slots = frameBuffer->beginWrite(0, size);
+
+    for (uint16_t i = 0; i < size; i++) {
+        slots[i] = seed + i;
+        expectedFrame[1 + i] = seed + i;
+    }
+
+    frameBuffer->commitWrite();
+}
+
+void setUp(void) {
+    frameBuffer = new DmxFrameBuffer();
+    memset(expectedFrame, 0, sizeof(expectedFrame));
+}
+
+void tearDown(void) {
+    delete frameBuffer;
+}
+
+void test_full_frames_copy_nothing(void) {
+    for (uint8_t i = 0; i < 50; i++) {
+        writePacket(DMX_MAX_CHANNELS, i);
+        TEST_ASSERT_TRUE(frameBuffer->swap());
+        TEST_ASSERT_EQUAL_MEMORY(expectedFrame, frameBuffer->getReadBuffer(), DMX_FRAME_SIZE);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, frameBuffer->getCarriedBytes());
+}
+
+void test_short_packets_carry_forward_tail(void) {
+    writePacket(DMX_MAX_CHANNELS, 10);
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+
+    writePacket(100, 50);
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+    TEST_ASSERT_EQUAL_MEMORY(expectedFrame, frameBuffer->getReadBuffer(), DMX_FRAME_SIZE);
+
+    writePacket(40, 90);
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+    TEST_ASSERT_EQUAL_MEMORY(expectedFrame, frameBuffer->getReadBuffer(), DMX_FRAME_SIZE);
+}
+
+void test_multiple_writes_before_swap(void) {
+    writePacket(300, 1);
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+
+    writePacket(20, 2);
+    writePacket(200, 3);
+    writePacket(10, 4);
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+    TEST_ASSERT_EQUAL_MEMORY(expectedFrame, frameBuffer->getReadBuffer(), DMX_FRAME_SIZE);
+
+    TEST_ASSERT_FALSE(frameBuffer->swap());
+}
+
+void test_random_lengths_match_reference(void) {
+    srand(1234);
+
+    for (uint32_t i = 0; i < 5000; i++) {
+        writePacket(rand() % (DMX_MAX_CHANNELS + 1), rand());
+
+        if (rand() % 3) {
+            frameBuffer->swap();
+            TEST_ASSERT_EQUAL_MEMORY(expectedFrame, frameBuffer->getReadBuffer(), DMX_FRAME_SIZE);
+        }
+    }
+}
+
+void test_abort_keeps_output_consistent(void) {
+    writePacket(DMX_MAX_CHANNELS, 7);
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+
+    uint8_t *slots = frameBuffer->beginWrite(0, 64);
+    memset(slots, 0xAA, 10);
+    frameBuffer->abortWrite();
+
+    writePacket(32, 100);
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+    TEST_ASSERT_EQUAL_MEMORY(expectedFrame, frameBuffer->getReadBuffer(), DMX_FRAME_SIZE);
+}
+
+void test_latest_frame_is_visible_to_the_writer(void) {
+    TEST_ASSERT_FALSE(frameBuffer->publish());
+
+    writePacket(DMX_MAX_CHANNELS, 3);
+    writePacket(16, 60);
+    TEST_ASSERT_EQUAL_UINT16(DMX_MAX_CHANNELS, frameBuffer->getLatestSize());
+    TEST_ASSERT_EQUAL_MEMORY(expectedFrame + 1, frameBuffer->getLatestFrame(), DMX_MAX_CHANNELS);
+
+    // Staged only, then published.
+    uint8_t *slots = frameBuffer->beginWrite(0, 8);
+    memset(slots, 0x55, 8);
+    memset(expectedFrame + 1, 0x55, 8);
+    frameBuffer->stageWrite();
+    TEST_ASSERT_EQUAL_MEMORY(expectedFrame + 1, frameBuffer->getLatestFrame(), DMX_MAX_CHANNELS);
+    TEST_ASSERT_TRUE(frameBuffer->publish());
+    TEST_ASSERT_FALSE(frameBuffer->publish());
+    TEST_ASSERT_EQUAL_MEMORY(expectedFrame + 1, frameBuffer->getLatestFrame(), DMX_MAX_CHANNELS);
+}
+
+void test_bytes_copied_per_frame(void) {
+    static const uint16_t sizes[] = { 512, 512, 128, 512, 64, 64, 512, 24, 512, 512 };
+    static const uint32_t frameCount = sizeof(sizes) / sizeof(sizes[0]);
+    uint32_t previousCopyBytes = 0;
+    uint32_t directCopyBytes = 0;
+
+    for (uint32_t i = 0; i < frameCount; i++) {
+        // Previous path: UDP.read of the whole datagram into udpBuffer, full
+        // frame memcpy from the read buffer, then the payload memcpy.
+        previousCopyBytes += ART_NET_DMX_HEADER_SIZE + sizes[i];
+        previousCopyBytes += DMX_FRAME_SIZE;
+        previousCopyBytes += sizes[i];
+
+        // Now: header into udpBuffer, payload straight into the back buffer,
+        // plus whatever the carry forward had to copy.
+        directCopyBytes += ART_NET_DMX_HEADER_SIZE + sizes[i];
+
+        writePacket(sizes[i], i);
+        frameBuffer->swap();
+        TEST_ASSERT_EQUAL_MEMORY(expectedFrame, frameBuffer->getReadBuffer(), DMX_FRAME_SIZE);
+    }
+
+    directCopyBytes += frameBuffer->getCarriedBytes();
+
+    printf("[bench] bytes copied per frame: before %.1f, after %.1f\n",
+        (double)previousCopyBytes / frameCount, (double)directCopyBytes / frameCount);
+
+    TEST_ASSERT_LESS_THAN(previousCopyBytes / 2, directCopyBytes);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_frames_copy_nothing);
+    RUN_TEST(test_short_packets_carry_forward_tail);
+    RUN_TEST(test_multiple_writes_before_swap);
+    RUN_TEST(test_random_lengths_match_reference);
+    RUN_TEST(test_abort_keeps_output_consistent);
+    RUN_TEST(test_latest_frame_is_visible_to_the_writer);
+    RUN_TEST(test_bytes_copied_per_frame);
+    return UNITY_END();
+}
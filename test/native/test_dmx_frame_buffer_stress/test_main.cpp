@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <DmxFrameBuffer.h>
+#include <unity.h>
+#include <atomic>
+#include <thread>
+
+static constexpr uint32_t STRESS_FRAMES = 200000;
+
+// Packet `seq` as sent by the writer thread: a deterministic length and
+// contents, with the sequence number in slots 1-4 so the reader can tell
+// which frame it got.
+static uint16_t packetSize(uint32_t seq) {
+    return 4 + (seq * 97) % (DMX_MAX_CHANNELS - 3);
+}
+
+static uint8_t packetSlot(uint32_t seq, uint16_t slot) {
+    return (seq * 7 + slot) & 0xFF;
+}
+
+static void fillPacket(uint8_t *slots, uint32_t seq, uint16_t size) {
+    memcpy(slots, &seq, sizeof(seq));
+
+    for (uint16_t i = sizeof(seq); i < size; i++) {
+        slots[i] = packetSlot(seq, i);
+    }
+}
+
+static DmxFrameBuffer *frameBuffer;
+
+void setUp(void) {
+    frameBuffer = new DmxFrameBuffer();
+}
+
+void tearDown(void) {
+    delete frameBuffer;
+}
+
+void test_reader_never_sees_torn_frames(void) {
+    std::atomic<bool> writerDone(false);
+    uint32_t framesSeen = 0;
+    uint32_t errors = 0;
+
+    std::thread writer([&]() {
+        for (uint32_t seq = 1; seq <= STRESS_FRAMES; seq++) {
+            uint16_t size = packetSize(seq);
+            fillPacket(frameBuffer->beginWrite(0, size), seq, size);
+            frameBuffer->commitWrite();
+
+            if ((seq & 0x3F) == 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        writerDone.store(true);
+    });
+
+    // The reader keeps its own model of the frame and replays every packet
+    // the writer sent since the last frame it saw.
+    static uint8_t model[DMX_FRAME_SIZE];
+    uint32_t modelSeq = 0;
+    memset(model, 0, sizeof(model));
+
+    while (true) {
+        bool done = writerDone.load();
+
+        if (frameBuffer->swap()) {
+            const uint8_t *frame = frameBuffer->getReadBuffer();
+            uint32_t seq;
+            memcpy(&seq, &frame[1], sizeof(seq));
+
+            if (seq <= modelSeq || seq > STRESS_FRAMES) {
+                errors++;
+                break;
+            }
+
+            while (modelSeq < seq) {
+                modelSeq++;
+                fillPacket(&model[1], modelSeq, packetSize(modelSeq));
+            }
+
+            if (memcmp(model, frame, DMX_FRAME_SIZE) != 0) {
+                errors++;
+            }
+
+            framesSeen++;
+        } else if (done) {
+            break;
+        }
+    }
+
+    writer.join();
+
+    printf("[stress] reader saw %u of %u frames\n", framesSeen, STRESS_FRAMES);
+
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES, modelSeq);
+    TEST_ASSERT_GREATER_THAN(0, framesSeen);
+}
+
+void test_slow_reader_gets_latest_frame(void) {
+    std::thread writer([&]() {
+        for (uint32_t seq = 1; seq <= 1000; seq++) {
+            fillPacket(frameBuffer->beginWrite(0, DMX_MAX_CHANNELS), seq, DMX_MAX_CHANNELS);
+            frameBuffer->commitWrite();
+        }
+    });
+
+    writer.join();
+
+    uint32_t seq;
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+    memcpy(&seq, &frameBuffer->getReadBuffer()[1], sizeof(seq));
+    TEST_ASSERT_EQUAL_UINT32(1000, seq);
+    TEST_ASSERT_FALSE(frameBuffer->swap());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reader_never_sees_torn_frames);
+    RUN_TEST(test_slow_reader_gets_latest_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,314 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <DmxFrameBuffer.h>
+#include <DmxInputDecoder.h>
+#include <DmxInputScheduler.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static DmxFrameBuffer *frameBuffer;
+static DmxInputDecoder *decoder;
+static DmxInputScheduler *scheduler;
+
+static ArtNet artNet;
+static ArtNetDmxDataPacket lastSent;
+static uint32_t lastSentSize;
+static uint32_t lastSentIP;
+static ArtNetPollReplyPacket lastReply;
+static uint32_t delivered;
+
+// A line break as the UART reports it: its 0x00 byte, then the event.
+static void lineBreak() {
+    uint8_t breakByte = 0;
+    decoder->onData(&breakByte, 1);
+    decoder->onBreak();
+}
+
+// Start code and slots after a break, handed over `chunk` bytes at a time
+// like the UART driver does.
+static void lineFrame(uint8_t startCode, const uint8_t *slots, uint16_t count, uint16_t chunk) {
+    static uint8_t frame[DMX_FRAME_SIZE + 8];
+
+    frame[0] = startCode;
+    memcpy(frame + 1, slots, count);
+
+    for (uint16_t i = 0; i < count + 1; i += chunk) {
+        uint16_t size = count + 1 - i < chunk ? count + 1 - i : chunk;
+        decoder->onData(frame + i, size);
+    }
+}
+
+// One full frame on the wire; it is decoded at the following break.
+static void lineSend(const uint8_t *slots, uint16_t count) {
+    lineFrame(0, slots, count, 120);
+    lineBreak();
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    frameBuffer = new DmxFrameBuffer();
+    decoder = new DmxInputDecoder();
+    scheduler = new DmxInputScheduler();
+    decoder->begin(frameBuffer);
+    scheduler->begin(frameBuffer);
+
+    artNet = ArtNet();
+    artNet.net = 1;
+    artNet.subnet = 2;
+    artNet.portUniverse[0] = 5;
+    artNet.portMode[0] = PortMode::Input;
+    artNet.pollReplyMaxDelayMs = 0;
+    delivered = 0;
+    lastSentSize = 0;
+
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t startCode, const uint8_t *data, uint16_t size) {
+        delivered++;
+    });
+
+    artNet.setDmxCommitCallback([]() {});
+
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {
+        if (size == sizeof(ArtNetPollReplyPacket)) {
+            memcpy(&lastReply, data, size);
+            return;
+        }
+
+        memcpy(&lastSent, data, size);
+        lastSentSize = size;
+        lastSentIP = ip;
+    });
+}
+
+void tearDown(void) {
+    delete scheduler;
+    delete decoder;
+    delete frameBuffer;
+    arduino_shim::useHostClock();
+}
+
+void test_frames_are_cut_at_breaks(void) {
+    uint8_t slots[512];
+
+    for (uint16_t i = 0; i < sizeof(slots); i++) {
+        slots[i] = i * 7;
+    }
+
+    // Tail of a frame we joined in the middle of: no break before it.
+    decoder->onData(slots, 100);
+    lineBreak();
+    TEST_ASSERT_FALSE(frameBuffer->swap());
+
+    lineSend(slots, 512);
+
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+    TEST_ASSERT_EQUAL_UINT16(512, frameBuffer->getReadSize());
+    TEST_ASSERT_EQUAL_UINT8(0, frameBuffer->getReadBuffer()[0]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(slots, frameBuffer->getReadBuffer() + 1, 512);
+    TEST_ASSERT_EQUAL_UINT32(1, decoder->stats.frames);
+
+    // Byte at a time, and a short frame ending with a zero slot that is not
+    // the break byte.
+    slots[23] = 0;
+    lineFrame(0, slots, 24, 1);
+    lineBreak();
+
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(slots, frameBuffer->getReadBuffer() + 1, 24);
+    TEST_ASSERT_EQUAL_UINT32(2, decoder->stats.frames);
+}
+
+void test_bad_frames_are_dropped(void) {
+    uint8_t slots[600] = { 1 };
+
+    lineBreak();
+
+    // Text packet.
+    lineFrame(0x17, slots, 10, 120);
+    lineBreak();
+    TEST_ASSERT_EQUAL_UINT32(1, decoder->stats.nzsFrames);
+
+    // Two breaks in a row.
+    lineBreak();
+    TEST_ASSERT_EQUAL_UINT32(1, decoder->stats.emptyFrames);
+
+    // 513 slots, in one go and in pieces.
+    lineFrame(0, slots, 513, 600);
+    lineBreak();
+    lineFrame(0, slots, 513, 64);
+    lineBreak();
+    TEST_ASSERT_EQUAL_UINT32(2, decoder->stats.overruns);
+
+    // Bytes lost: the frame is dropped, the next break resynchronizes.
+    lineFrame(0, slots, 100, 50);
+    decoder->onError();
+    lineFrame(0, slots, 100, 50);
+    lineBreak();
+    TEST_ASSERT_EQUAL_UINT32(1, decoder->stats.errors);
+
+    TEST_ASSERT_FALSE(frameBuffer->swap());
+    TEST_ASSERT_EQUAL_UINT32(0, decoder->stats.frames);
+
+    lineSend(slots, 100);
+    TEST_ASSERT_TRUE(frameBuffer->swap());
+}
+
+void test_only_changes_are_sent(void) {
+    uint8_t slots[512] = { 0 };
+
+    lineBreak();
+    lineSend(slots, 512);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::Fresh, (uint8_t)scheduler->next(millis()));
+    TEST_ASSERT_EQUAL_UINT16(512, scheduler->getLength());
+
+    // A desk repeats the same frame ~44 times per second.
+    for (uint8_t i = 0; i < 30; i++) {
+        arduino_shim::advanceFakeClock(22700);
+        lineSend(slots, 512);
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::None, (uint8_t)scheduler->next(millis()));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(30, scheduler->stats.unchanged);
+
+    slots[300] = 255;
+    arduino_shim::advanceFakeClock(22700);
+    lineSend(slots, 512);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::Fresh, (uint8_t)scheduler->next(millis()));
+    TEST_ASSERT_EQUAL_UINT8(255, scheduler->getData()[300]);
+}
+
+void test_changes_are_rate_limited_and_coalesced(void) {
+    uint8_t slots[512] = { 0 };
+    uint32_t sent = 0;
+    unsigned long start = millis();
+
+    lineBreak();
+
+    // A fader moving on every DMX frame for one second.
+    while (millis() - start < 1000) {
+        slots[0]++;
+        lineSend(slots, 512);
+
+        if (scheduler->next(millis()) == DmxFrameKind::Fresh) {
+            sent++;
+            TEST_ASSERT_EQUAL_UINT8(slots[0], scheduler->getData()[0]);
+        }
+
+        arduino_shim::advanceFakeClock(10000);
+    }
+
+    // 100 frames in, at most one per DMX_INPUT_MIN_INTERVAL_MS out: on the
+    // first frame after each interval.
+    TEST_ASSERT_LESS_OR_EQUAL(1000 / DMX_INPUT_MIN_INTERVAL_MS, sent);
+    TEST_ASSERT_GREATER_OR_EQUAL(1000 / (DMX_INPUT_MIN_INTERVAL_MS + 10), sent);
+    // Every other frame was replaced by a newer one.
+    TEST_ASSERT_EQUAL_UINT32(100 - sent, scheduler->stats.coalesced);
+
+    // The last change goes out once the interval is over, with no new frame.
+    slots[0]++;
+    lineSend(slots, 512);
+    scheduler->next(millis());
+    arduino_shim::advanceFakeClock(1000);
+    slots[0]++;
+    lineSend(slots, 512);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::None, (uint8_t)scheduler->next(millis()));
+    arduino_shim::advanceFakeClock(DMX_INPUT_MIN_INTERVAL_MS * 1000);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::Fresh, (uint8_t)scheduler->next(millis()));
+    TEST_ASSERT_EQUAL_UINT8(slots[0], scheduler->getData()[0]);
+}
+
+void test_keep_alive_until_input_is_lost(void) {
+    uint8_t slots[64] = { 9 };
+    uint32_t keepAlives = 0;
+
+    lineBreak();
+    lineSend(slots, 64);
+    scheduler->next(millis());
+
+    // Static input for 5 s.
+    for (uint16_t i = 0; i < 500; i++) {
+        arduino_shim::advanceFakeClock(10000);
+        lineSend(slots, 64);
+
+        if (scheduler->next(millis()) == DmxFrameKind::KeepAlive) {
+            keepAlives++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(5000 / DMX_INPUT_KEEP_ALIVE_MS, keepAlives);
+    TEST_ASSERT_TRUE(scheduler->isReceiving(millis()));
+
+    // Cable pulled.
+    for (uint16_t i = 0; i < 500; i++) {
+        arduino_shim::advanceFakeClock(10000);
+
+        if (scheduler->next(millis()) == DmxFrameKind::KeepAlive) {
+            keepAlives++;
+        }
+    }
+
+    // Only while the last frame is within DMX_INPUT_LOSS_TIMEOUT_MS.
+    TEST_ASSERT_LESS_OR_EQUAL(5000 / DMX_INPUT_KEEP_ALIVE_MS + DMX_INPUT_LOSS_TIMEOUT_MS / DMX_INPUT_KEEP_ALIVE_MS + 1, keepAlives);
+    TEST_ASSERT_FALSE(scheduler->isReceiving(millis()));
+}
+
+void test_art_dmx_of_input_port(void) {
+    uint8_t slots[3] = { 10, 20, 30 };
+
+    artNet.sendDmx(0, 0x0A0000FF, slots, 3);
+
+    TEST_ASSERT_EQUAL_UINT32(0x0A0000FF, lastSentIP);
+    TEST_ASSERT_EQUAL_UINT32(ART_NET_DMX_HEADER_SIZE + 4, lastSentSize);
+    TEST_ASSERT_EQUAL_STRING(ART_NET_ID, lastSent.ID);
+    TEST_ASSERT_EQUAL_UINT16((uint16_t)OpCode::Dmx, ((uint16_t)lastSent.OpCodeHi << 8) | lastSent.OpCodeLo);
+    TEST_ASSERT_EQUAL_UINT8(1, lastSent.Sequence);
+    TEST_ASSERT_EQUAL_UINT8(1, lastSent.Net);
+    TEST_ASSERT_EQUAL_UINT8(0x25, lastSent.SubUni);
+    TEST_ASSERT_EQUAL_UINT8(4, lastSent.LengthLo);
+    TEST_ASSERT_EQUAL_UINT8(30, lastSent.Data[2]);
+    TEST_ASSERT_EQUAL_UINT8(0, lastSent.Data[3]);
+
+    for (uint16_t i = 0; i < 255; i++) {
+        artNet.sendDmx(0, 0x0A0000FF, slots, 3);
+    }
+
+    // Wraps to 1, 0 would disable the receiver's sequence check.
+    TEST_ASSERT_EQUAL_UINT8(1, lastSent.Sequence);
+    TEST_ASSERT_EQUAL_UINT32(256, artNet.stats.dmxSent);
+
+    // Our own broadcast, or anyone else's data for that universe, is not output.
+    artNet.onPacketReceived(0x0A000001, 0x1936, (uint8_t*) &lastSent, lastSentSize);
+    TEST_ASSERT_EQUAL_UINT32(0, delivered);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxForeign);
+}
+
+void test_poll_reply_advertises_input(void) {
+    uint8_t poll[14] = { 0 };
+    memcpy(poll, ART_NET_ID, sizeof(ART_NET_ID));
+    poll[8] = ((uint16_t)OpCode::Poll & 0xFF);
+    poll[9] = ((uint16_t)OpCode::Poll >> 8);
+
+    artNet.goodInput[0] = ART_NET_GOOD_INPUT_DATA;
+    artNet.onPacketReceived(0x0A000001, 0x1936, poll, sizeof(poll));
+    artNet.processPendingReplies();
+
+    TEST_ASSERT_EQUAL_UINT8(0b01000000, lastReply.port_types[0]);
+    TEST_ASSERT_EQUAL_UINT8(5, lastReply.sw_in[0]);
+    TEST_ASSERT_EQUAL_UINT8(ART_NET_GOOD_INPUT_DATA, lastReply.good_input[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, lastReply.good_output[0]);
+    TEST_ASSERT_EQUAL_UINT8(0b10100000, lastReply.port_types[1]);
+    TEST_ASSERT_EQUAL_UINT8(0b10000000, lastReply.good_output[1]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frames_are_cut_at_breaks);
+    RUN_TEST(test_bad_frames_are_dropped);
+    RUN_TEST(test_only_changes_are_sent);
+    RUN_TEST(test_changes_are_rate_limited_and_coalesced);
+    RUN_TEST(test_keep_alive_until_input_is_lost);
+    RUN_TEST(test_art_dmx_of_input_port);
+    RUN_TEST(test_poll_reply_advertises_input);
+    return UNITY_END();
+}
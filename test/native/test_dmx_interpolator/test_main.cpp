@@ -0,0 +1,240 @@
+#include <Arduino.h>
+#include <Bench.h>
+#include <DmxFrameBuffer.h>
+#include <DmxInterpolator.h>
+#include <DmxOutputScheduler.h>
+#include <unity.h>
+
+static DmxInterpolator *interpolator;
+static uint8_t frameA[DMX_FRAME_SIZE];
+static uint8_t frameB[DMX_FRAME_SIZE];
+
+static void fillRandom(uint8_t *frame) {
+    frame[0] = 0;
+
+    for (uint16_t i = 1; i < DMX_FRAME_SIZE; i++) {
+        frame[i] = rand();
+    }
+}
+
+// Starts a 50 ms fade from frameA to frameB at 1000 ms.
+static void startFade(void) {
+    interpolator->setTarget(frameA, DMX_FRAME_SIZE, 950);
+    // frameA is on the output right when frameB comes in.
+    interpolator->render(1000);
+    interpolator->setTarget(frameB, DMX_FRAME_SIZE, 1000);
+    TEST_ASSERT_EQUAL_UINT16(50, interpolator->getInterval());
+}
+
+void setUp(void) {
+    interpolator = new DmxInterpolator();
+    interpolator->enabled = 1;
+    srand(42);
+    fillRandom(frameA);
+    fillRandom(frameB);
+}
+
+void tearDown(void) {
+    delete interpolator;
+    arduino_shim::useHostClock();
+}
+
+void test_blend_matches_per_slot_reference(void) {
+    startFade();
+
+    for (unsigned long elapsed = 0; elapsed < 50; elapsed++) {
+        TEST_ASSERT_TRUE(interpolator->render(1000 + elapsed));
+
+        uint32_t fraction = elapsed * 256 / 50;
+        const uint8_t *frame = interpolator->getFrame();
+
+        for (uint16_t i = 1; i < DMX_FRAME_SIZE; i++) {
+            uint8_t expected = (frameA[i] * (256 - fraction) + frameB[i] * fraction) >> 8;
+
+            if (frame[i] != expected) {
+                char message[64];
+                snprintf(message, sizeof(message), "slot %u at %lu ms", i, elapsed);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+
+    // Lands exactly on the target.
+    TEST_ASSERT_FALSE(interpolator->render(1050));
+    TEST_ASSERT_FALSE(interpolator->isMoving());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frameB, interpolator->getFrame(), DMX_FRAME_SIZE);
+}
+
+void test_excluded_channels_jump(void) {
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i += 7) {
+        interpolator->setExcluded(i, true);
+    }
+
+    interpolator->setExcluded(DMX_MAX_CHANNELS, true);
+    TEST_ASSERT_FALSE(interpolator->isExcluded(DMX_MAX_CHANNELS));
+    TEST_ASSERT_TRUE(interpolator->isExcluded(7));
+
+    startFade();
+    interpolator->render(1010);
+
+    const uint8_t *frame = interpolator->getFrame();
+    uint16_t moving = 0;
+
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i++) {
+        if (i % 7 == 0) {
+            TEST_ASSERT_EQUAL_UINT8(frameB[1 + i], frame[1 + i]);
+        } else if (frame[1 + i] != frameB[1 + i]) {
+            moving++;
+        }
+    }
+
+    TEST_ASSERT_GREATER_THAN(DMX_MAX_CHANNELS / 2, moving);
+
+    interpolator->reset();
+    TEST_ASSERT_FALSE(interpolator->isExcluded(7));
+}
+
+void test_interval_follows_jittery_arrivals(void) {
+    uint8_t frame[DMX_FRAME_SIZE] = { 0 };
+    unsigned long now = 0;
+
+    // First frame: nothing to fade from.
+    frame[1] = 100;
+    interpolator->setTarget(frame, DMX_FRAME_SIZE, now);
+    TEST_ASSERT_FALSE(interpolator->isMoving());
+    TEST_ASSERT_EQUAL_UINT8(100, interpolator->getFrame()[1]);
+
+    // 20 Hz give or take 10 ms.
+    for (uint8_t i = 0; i < 40; i++) {
+        now += 40 + (i % 3) * 10;
+        frame[1] += 2;
+        interpolator->setTarget(frame, DMX_FRAME_SIZE, now);
+    }
+
+    TEST_ASSERT_UINT16_WITHIN(6, 50, interpolator->getInterval());
+
+    // A frame after a pause is a new look, not a step of the fade.
+    frame[1] = 10;
+    interpolator->setTarget(frame, DMX_FRAME_SIZE, now + DMX_INTERPOLATION_MAX_INTERVAL_MS + 1);
+    TEST_ASSERT_FALSE(interpolator->isMoving());
+    TEST_ASSERT_EQUAL_UINT8(10, interpolator->getFrame()[1]);
+    TEST_ASSERT_UINT16_WITHIN(6, 50, interpolator->getInterval());
+}
+
+void test_early_frame_continues_from_current_output(void) {
+    startFade();
+    interpolator->render(1025);
+
+    uint8_t halfway[DMX_FRAME_SIZE];
+    memcpy(halfway, interpolator->getFrame(), DMX_FRAME_SIZE);
+
+    // Back to frameA half way through: no jump to frameB first.
+    interpolator->setTarget(frameA, DMX_FRAME_SIZE, 1025);
+    interpolator->render(1025);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(halfway, interpolator->getFrame(), DMX_FRAME_SIZE);
+}
+
+// Network fade from 0 to 250 at 20 Hz, output task running back to back at
+// about 44 Hz.
+static uint32_t runFade(bool smoothing, uint8_t *largestStep) {
+    DmxFrameBuffer frameBuffer;
+    DmxOutputScheduler scheduler;
+    uint32_t frames = 0;
+    uint8_t last = 0;
+
+    interpolator->enabled = smoothing;
+    arduino_shim::setFakeClock(1000000);
+    scheduler.begin(&frameBuffer, NULL, interpolator);
+    *largestStep = 0;
+
+    uint32_t nextNetworkFrame = 0;
+
+    for (uint32_t micros = 0; micros < 1400000; micros += 1000) {
+        if (micros >= nextNetworkFrame && nextNetworkFrame <= 1250000) {
+            memset(frameBuffer.beginWrite(0, DMX_MAX_CHANNELS), nextNetworkFrame / 5000, DMX_MAX_CHANNELS);
+            frameBuffer.commitWrite();
+            nextNetworkFrame += 50000;
+        }
+
+        DmxFrameKind kind = scheduler.next(millis(), DMX_MAX_CHANNELS);
+
+        if (kind != DmxFrameKind::None) {
+            uint8_t value = scheduler.getFrame()[1];
+
+            TEST_ASSERT_GREATER_OR_EQUAL_UINT8(last, value);
+
+            if (value - last > *largestStep) {
+                *largestStep = value - last;
+            }
+
+            last = value;
+            frames++;
+            // The frame takes about 23 ms on the line.
+            arduino_shim::advanceFakeClock(22000);
+            micros += 22000;
+        }
+
+        arduino_shim::advanceFakeClock(1000);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(250, last);
+    return frames;
+}
+
+void test_scheduler_sends_steps_between_fresh_frames(void) {
+    uint8_t steppedLargest;
+    uint8_t smoothLargest;
+    uint32_t stepped = runFade(false, &steppedLargest);
+    uint32_t smooth = runFade(true, &smoothLargest);
+
+    printf("[interpolator] fade 0-250 at 20 Hz: %u frames, largest step %u without, %u frames, largest step %u with\n",
+        stepped, steppedLargest, smooth, smoothLargest);
+    TEST_ASSERT_EQUAL_UINT8(10, steppedLargest);
+    TEST_ASSERT_GREATER_THAN(stepped * 3 / 2, smooth);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT8(7, smoothLargest);
+}
+
+// One slot at a time, what the ESP32 would do without the word pass. Kept
+// scalar here, the host compiler would otherwise vectorize it.
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-tree-vectorize")))
+#endif
+static void blendPerSlot(uint8_t *slots, uint32_t fraction) {
+    for (uint16_t j = 0; j < DMX_MAX_CHANNELS; j++) {
+        slots[j] = (frameA[1 + j] * (256 - fraction) + frameB[1 + j] * fraction) >> 8;
+    }
+}
+
+void test_render_cost(void) {
+    static uint8_t slots[DMX_MAX_CHANNELS];
+
+    startFade();
+
+    double ns = bench::nsPerOp(100000, [](uint32_t i) {
+        // Never reaches the end of the fade.
+        interpolator->render(1000 + i % 50);
+        bench::doNotOptimize(interpolator->getFrame()[1]);
+    });
+
+    bench::report("Interpolate 512 slots", ns);
+
+    double scalarNs = bench::nsPerOp(100000, [](uint32_t i) {
+        blendPerSlot(slots, (i % 50) * 256 / 50);
+        bench::doNotOptimize(slots[1]);
+    });
+
+    bench::report("Interpolate per slot, scalar", scalarNs);
+    // 44 Hz on 3 ports is 132 frames per second.
+    printf("[interpolator] %.3f%% of a core for 3 ports at 44 Hz\n", ns * 132 / 1e7);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_blend_matches_per_slot_reference);
+    RUN_TEST(test_excluded_channels_jump);
+    RUN_TEST(test_interval_follows_jittery_arrivals);
+    RUN_TEST(test_early_frame_continues_from_current_output);
+    RUN_TEST(test_scheduler_sends_steps_between_fresh_frames);
+    RUN_TEST(test_render_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,277 @@
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <DmxFrameBuffer.h>
+#include <DmxNzsQueue.h>
+#include <DmxOutputScheduler.h>
+#include <unity.h>
+
+using namespace art_net;
+
+// Text packet start code (ANSI E1.11 alternate start codes).
+#define START_CODE_TEXT 0x17
+
+static ArtNet artNet;
+static DmxFrameBuffer *frameBuffer;
+static DmxNzsQueue *nzsQueue;
+static DmxOutputScheduler *scheduler;
+
+static uint8_t nzsPacket[sizeof(ArtNetNzsDataPacket)];
+
+static void buildNzsPacket(uint8_t subUni, uint8_t startCode, uint16_t length) {
+    ArtNetNzsDataPacket *packet = (ArtNetNzsDataPacket*) nzsPacket;
+
+    memset(nzsPacket, 0, sizeof(nzsPacket));
+    memcpy(packet->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    packet->OpCodeLo = ((uint16_t)OpCode::Nzs & 0xFF);
+    packet->OpCodeHi = ((uint16_t)OpCode::Nzs >> 8);
+    packet->ProtVerLo = 14;
+    packet->StartCode = startCode;
+    packet->SubUni = subUni;
+    packet->LengthHi = length >> 8;
+    packet->LengthLo = length & 0xFF;
+    memcpy(packet->Data, "Hello", 5);
+}
+
+static void writeFrame(uint16_t size, uint8_t value) {
+    memset(frameBuffer->beginWrite(0, size), value, size);
+    frameBuffer->commitWrite();
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    artNet = ArtNet();
+
+    // Same routing as the node: start code 0 to the frame buffer, others queued.
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t startCode, const uint8_t *data, uint16_t size) {
+        if (startCode != 0) {
+            nzsQueue->push(startCode, data, size);
+        } else {
+            memcpy(frameBuffer->beginWrite(0, size), data, size);
+            frameBuffer->stageWrite();
+        }
+    });
+
+    artNet.setDmxCommitCallback([]() {
+        frameBuffer->publish();
+    });
+
+    frameBuffer = new DmxFrameBuffer();
+    nzsQueue = new DmxNzsQueue();
+    scheduler = new DmxOutputScheduler();
+    scheduler->begin(frameBuffer, nzsQueue);
+}
+
+void tearDown(void) {
+    delete scheduler;
+    delete nzsQueue;
+    delete frameBuffer;
+    scheduler = NULL;
+    nzsQueue = NULL;
+    frameBuffer = NULL;
+    arduino_shim::useHostClock();
+}
+
+void test_art_nzs_is_queued_with_its_start_code(void) {
+    buildNzsPacket(0x00, START_CODE_TEXT, 6);
+    TEST_ASSERT_EQUAL_INT8((int8_t)PacketParseStatus::Success, (int8_t)artNet.onPacketReceived(0x0A000001, 0x1936, nzsPacket, sizeof(nzsPacket)));
+
+    const DmxNzsFrame *frame = nzsQueue->front();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT16(7, frame->length);
+    TEST_ASSERT_EQUAL_UINT8(START_CODE_TEXT, frame->data[0]);
+    TEST_ASSERT_EQUAL_STRING("Hello", (const char*)frame->data + 1);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.nzs);
+
+    // Nothing reaches the NSC frame buffer.
+    TEST_ASSERT_FALSE(frameBuffer->swap());
+}
+
+void test_art_nzs_rejections(void) {
+    buildNzsPacket(0x00, 0, 6);
+    artNet.onPacketReceived(0x0A000001, 0x1936, nzsPacket, sizeof(nzsPacket));
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxBadLength);
+
+    buildNzsPacket(0x07, START_CODE_TEXT, 6);
+    artNet.onPacketReceived(0x0A000001, 0x1936, nzsPacket, sizeof(nzsPacket));
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxForeign);
+
+    buildNzsPacket(0x00, START_CODE_TEXT, 100);
+    artNet.onPacketReceived(0x0A000001, 0x1936, nzsPacket, ART_NET_DMX_HEADER_SIZE + 50);
+    TEST_ASSERT_EQUAL_UINT32(1, artNet.stats.dmxTruncated);
+
+    TEST_ASSERT_TRUE(nzsQueue->isEmpty());
+}
+
+void test_queue_is_fifo_and_drops_when_full(void) {
+    uint8_t slots[1];
+
+    for (uint8_t i = 0; i < DMX_NZS_QUEUE_SIZE + 2; i++) {
+        slots[0] = i;
+        TEST_ASSERT_EQUAL(i < DMX_NZS_QUEUE_SIZE, nzsQueue->push(0x91, slots, 1));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(2, nzsQueue->getDropped());
+
+    for (uint8_t i = 0; i < DMX_NZS_QUEUE_SIZE; i++) {
+        TEST_ASSERT_EQUAL_UINT8(i, nzsQueue->front()->data[1]);
+        nzsQueue->pop();
+    }
+
+    TEST_ASSERT_TRUE(nzsQueue->isEmpty());
+    TEST_ASSERT_NULL(nzsQueue->front());
+}
+
+void test_nzs_and_fresh_nsc_alternate(void) {
+    uint8_t slots[4] = { 1, 2, 3, 4 };
+
+    writeFrame(100, 9);
+    nzsQueue->push(START_CODE_TEXT, slots, 4);
+    nzsQueue->push(START_CODE_TEXT, slots, 4);
+
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::NonZeroStartCode, (uint8_t)scheduler->next(millis(), 512));
+    TEST_ASSERT_EQUAL_UINT16(5, scheduler->getFrameLength());
+    TEST_ASSERT_EQUAL_UINT8(START_CODE_TEXT, scheduler->getFrame()[0]);
+
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::Fresh, (uint8_t)scheduler->next(millis(), 512));
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler->getFrame()[0]);
+    TEST_ASSERT_EQUAL_UINT8(9, scheduler->getFrame()[1]);
+
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::NonZeroStartCode, (uint8_t)scheduler->next(millis(), 512));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::None, (uint8_t)scheduler->next(millis(), 512));
+    TEST_ASSERT_TRUE(nzsQueue->isEmpty());
+}
+
+typedef struct {
+    uint32_t nscFrames;
+    uint32_t nzsFrames;
+    uint32_t nzsOffered;
+    // Longest time without an NSC frame on the line.
+    unsigned long longestNscGapMicros;
+} MixedStreamResult;
+
+// One simulated second of the output task: a new NSC frame of `channels`
+// slots every 2 ms and an NZS frame of `nzsSlots` every `nzsIntervalMicros`.
+static MixedStreamResult simulateMixedStream(uint16_t channels, uint16_t nzsSlots, unsigned long nzsIntervalMicros, uint8_t nscMinRefreshHz) {
+    static uint8_t text[512];
+    MixedStreamResult result = { 0, 0, 0, 0 };
+
+    tearDown();
+    setUp();
+    scheduler->nscMinRefreshHz = nscMinRefreshHz;
+
+    unsigned long start = micros();
+    unsigned long nextNsc = start;
+    unsigned long nextNzs = start;
+    unsigned long lastNsc = start;
+    uint8_t value = 0;
+    uint32_t sequence = 0;
+    uint32_t lastNzs = 0;
+
+    while (micros() - start < 1000000) {
+        while ((long)(micros() - nextNsc) >= 0) {
+            writeFrame(channels, value++);
+            nextNsc += 2000;
+        }
+
+        while ((long)(micros() - nextNzs) >= 0) {
+            memcpy(text, &sequence, sizeof(sequence));
+            nzsQueue->push(START_CODE_TEXT, text, nzsSlots);
+            result.nzsOffered++;
+            sequence++;
+            nextNzs += nzsIntervalMicros;
+        }
+
+        DmxFrameKind kind = scheduler->next(millis(), channels);
+
+        if (kind == DmxFrameKind::None) {
+            delayMicroseconds(1000);
+            continue;
+        }
+
+        if (kind == DmxFrameKind::NonZeroStartCode) {
+            // In order; only frames refused by a full queue are missing.
+            uint32_t sent;
+            memcpy(&sent, scheduler->getFrame() + 1, sizeof(sent));
+            TEST_ASSERT_TRUE(result.nzsFrames == 0 || sent > lastNzs);
+            lastNzs = sent;
+            result.nzsFrames++;
+        } else {
+            unsigned long gap = micros() - lastNsc;
+            result.longestNscGapMicros = gap > result.longestNscGapMicros ? gap : result.longestNscGapMicros;
+            lastNsc = micros();
+            result.nscFrames++;
+        }
+
+        delayMicroseconds(DMX_BREAK_LOW_INTERVAL_MICROS + DMX_BREAK_HIGH_INTERVAL_MICROS);
+        delayMicroseconds(scheduler->getFrameLength() * DMX_SLOT_MICROS);
+    }
+
+    // Whatever is still queued goes out too.
+    while (!nzsQueue->isEmpty()) {
+        if (scheduler->next(millis(), channels) == DmxFrameKind::NonZeroStartCode) {
+            result.nzsFrames++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(result.nzsOffered, result.nzsFrames + nzsQueue->getDropped());
+
+    return result;
+}
+
+void test_mixed_stream_keeps_nsc_minimum(void) {
+    // NZS flood: full size frames offered faster than the line can send them.
+    MixedStreamResult flood = simulateMixedStream(512, 512, 5000, 20);
+    printf("[nzs] flood: %u NSC fps, %u NZS fps (%u offered), longest NSC gap %lu us\n",
+        flood.nscFrames, flood.nzsFrames, flood.nzsOffered, flood.longestNscGapMicros);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(20, flood.nscFrames);
+    TEST_ASSERT_GREATER_THAN(0, flood.nzsFrames);
+    // Alternating: a fresh NSC frame waits for one NZS frame at most.
+    TEST_ASSERT_LESS_THAN(1000000 / 20, flood.longestNscGapMicros);
+
+    // Occasional short messages cost the NSC stream little.
+    MixedStreamResult occasional = simulateMixedStream(512, 32, 100000, 20);
+    MixedStreamResult none = simulateMixedStream(512, 32, 2000000, 20);
+    printf("[nzs] occasional: %u NSC fps, %u NZS fps; NSC only: %u fps\n",
+        occasional.nscFrames, occasional.nzsFrames, none.nscFrames);
+
+    TEST_ASSERT_EQUAL_UINT32(occasional.nzsOffered, occasional.nzsFrames);
+    TEST_ASSERT_GREATER_OR_EQUAL(none.nscFrames - 2, occasional.nscFrames);
+}
+
+void test_minimum_holds_with_static_nsc(void) {
+    // The NSC data never changes, only the minimum refresh sends it while
+    // NZS frames keep the line busy.
+    uint8_t slots[512] = { 0 };
+    unsigned long start = micros();
+    uint32_t nscFrames = 0;
+
+    scheduler->next(millis(), 512);
+
+    while (micros() - start < 1000000) {
+        while (nzsQueue->push(START_CODE_TEXT, slots, 512)) {}
+
+        DmxFrameKind kind = scheduler->next(millis(), 512);
+
+        if (kind == DmxFrameKind::KeepAlive) {
+            nscFrames++;
+        }
+
+        delayMicroseconds(scheduler->getFrameLength() * DMX_SLOT_MICROS + 104);
+    }
+
+    printf("[nzs] static NSC under NZS flood: %u fps\n", nscFrames);
+    TEST_ASSERT_GREATER_OR_EQUAL(DMX_NSC_MIN_REFRESH_HZ, nscFrames);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_art_nzs_is_queued_with_its_start_code);
+    RUN_TEST(test_art_nzs_rejections);
+    RUN_TEST(test_queue_is_fifo_and_drops_when_full);
+    RUN_TEST(test_nzs_and_fresh_nsc_alternate);
+    RUN_TEST(test_mixed_stream_keeps_nsc_minimum);
+    RUN_TEST(test_minimum_holds_with_static_nsc);
+    return UNITY_END();
+}
@@ -0,0 +1,153 @@
+#include <Arduino.h>
+#include <DmxFrameBuffer.h>
+#include <DmxOutputScheduler.h>
+#include <unity.h>
+
+// 250 kbaud, 8N2: 44 us per slot.
+#define SLOT_MICROS 44
+
+static DmxFrameBuffer *frameBuffer;
+static DmxOutputScheduler *scheduler;
+
+static void writeFrame(uint16_t size, uint8_t value) {
+    memset(frameBuffer->beginWrite(0, size), value, size);
+    frameBuffer->commitWrite();
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    frameBuffer = new DmxFrameBuffer();
+    scheduler = new DmxOutputScheduler();
+    scheduler->begin(frameBuffer);
+}
+
+void tearDown(void) {
+    delete scheduler;
+    delete frameBuffer;
+    scheduler = NULL;
+    frameBuffer = NULL;
+    arduino_shim::useHostClock();
+}
+
+void test_fixed_mode_sends_configured_length(void) {
+    scheduler->adaptive = 0;
+
+    writeFrame(40, 1);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::Fresh, (uint8_t)scheduler->next(millis(), 512));
+    TEST_ASSERT_EQUAL_UINT16(513, scheduler->getFrameLength());
+
+    // Same data again still goes out.
+    writeFrame(40, 1);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::Fresh, (uint8_t)scheduler->next(millis(), 512));
+}
+
+void test_adaptive_length_follows_highest_slot(void) {
+    scheduler->adaptive = 1;
+
+    writeFrame(40, 1);
+    scheduler->next(millis(), 512);
+    TEST_ASSERT_EQUAL_UINT16(DMX_MIN_CHANNELS + 1, scheduler->getFrameLength());
+
+    writeFrame(300, 2);
+    scheduler->next(millis(), 512);
+    TEST_ASSERT_EQUAL_UINT16(301, scheduler->getFrameLength());
+
+    // A shorter packet later doesn't cut slots that were received before.
+    writeFrame(40, 3);
+    scheduler->next(millis(), 512);
+    TEST_ASSERT_EQUAL_UINT16(301, scheduler->getFrameLength());
+    TEST_ASSERT_EQUAL_UINT8(2, scheduler->getFrame()[300]);
+
+    // Never above the configured channel count.
+    writeFrame(512, 4);
+    scheduler->next(millis(), 400);
+    TEST_ASSERT_EQUAL_UINT16(401, scheduler->getFrameLength());
+}
+
+void test_adaptive_skips_unchanged_frames_until_keep_alive(void) {
+    scheduler->adaptive = 1;
+
+    writeFrame(100, 7);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::Fresh, (uint8_t)scheduler->next(millis(), 512));
+
+    for (uint8_t i = 0; i < 10; i++) {
+        arduino_shim::advanceFakeClock(25000);
+        writeFrame(100, 7);
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::None, (uint8_t)scheduler->next(millis(), 512));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(10, scheduler->getUnchangedSkipped());
+
+    arduino_shim::advanceFakeClock(DMX_MAX_TRANSMIT_INTERVAL_MS * 1000UL);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::KeepAlive, (uint8_t)scheduler->next(millis(), 512));
+
+    writeFrame(100, 8);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::Fresh, (uint8_t)scheduler->next(millis(), 512));
+}
+
+void test_keep_alive_without_data(void) {
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::None, (uint8_t)scheduler->next(millis(), 512));
+
+    arduino_shim::advanceFakeClock((DMX_MAX_TRANSMIT_INTERVAL_MS + 1) * 1000UL);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::KeepAlive, (uint8_t)scheduler->next(millis(), 512));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)DmxFrameKind::None, (uint8_t)scheduler->next(millis(), 512));
+}
+
+// One simulated second of an output task fed with a new, changing frame of
+// `channels` slots every 2 ms. The UART is the bottleneck: break, MAB and
+// 44 us per byte.
+static uint32_t simulateFramesPerSecond(uint8_t adaptive, uint16_t channels, uint16_t channelCount) {
+    tearDown();
+    setUp();
+    scheduler->adaptive = adaptive;
+
+    unsigned long start = micros();
+    unsigned long nextInput = start;
+    uint32_t frames = 0;
+    uint8_t value = 0;
+
+    while (micros() - start < 1000000) {
+        while ((long)(micros() - nextInput) >= 0) {
+            writeFrame(channels, value++);
+            nextInput += 2000;
+        }
+
+        if (scheduler->next(millis(), channelCount) != DmxFrameKind::None) {
+            delayMicroseconds(DMX_BREAK_LOW_INTERVAL_MICROS + DMX_BREAK_HIGH_INTERVAL_MICROS);
+            delayMicroseconds(scheduler->getFrameLength() * SLOT_MICROS);
+            frames++;
+        } else {
+            delayMicroseconds(1000);
+        }
+    }
+
+    return frames;
+}
+
+void test_simulated_refresh_rate(void) {
+    const uint16_t channelCounts[] = { 24, 40, 96, 192, 256, 384, 512 };
+
+    for (uint16_t channels : channelCounts) {
+        uint32_t fixed = simulateFramesPerSecond(0, channels, DMX_MAX_CHANNELS);
+        uint32_t adaptive = simulateFramesPerSecond(1, channels, DMX_MAX_CHANNELS);
+
+        printf("[refresh] %3u channels received: fixed 512 slots %3u fps, adaptive %3u fps\n", channels, fixed, adaptive);
+
+        TEST_ASSERT_GREATER_OR_EQUAL(fixed, adaptive);
+
+        if (channels <= DMX_MIN_CHANNELS) {
+            TEST_ASSERT_GREATER_THAN(fixed * 2, adaptive);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_mode_sends_configured_length);
+    RUN_TEST(test_adaptive_length_follows_highest_slot);
+    RUN_TEST(test_adaptive_skips_unchanged_frames_until_keep_alive);
+    RUN_TEST(test_keep_alive_without_data);
+    RUN_TEST(test_simulated_refresh_rate);
+    return UNITY_END();
+}
@@ -0,0 +1,179 @@
+#include <Arduino.h>
+#include <Bench.h>
+#include <DmxProcessor.h>
+#include <math.h>
+#include <unity.h>
+
+static DmxProcessor *processor;
+static uint8_t data[DMX_MAX_CHANNELS];
+static uint8_t output[DMX_MAX_CHANNELS];
+
+void setUp(void) {
+    processor = new DmxProcessor();
+
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i++) {
+        data[i] = i * 7;
+    }
+
+    memset(output, 0xAA, sizeof(output));
+}
+
+void tearDown(void) {
+    delete processor;
+    processor = NULL;
+}
+
+void test_default_is_passthrough(void) {
+    TEST_ASSERT_TRUE(processor->isPassthrough());
+    TEST_ASSERT_EQUAL_UINT16(100, processor->process(data, 100, output));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, output, 100);
+    TEST_ASSERT_EQUAL_UINT8(0xAA, output[100]);
+}
+
+void test_curve_tables(void) {
+    const uint8_t *linear = DmxProcessor::getCurveTable(DmxCurve::Linear);
+    const uint8_t *gamma = DmxProcessor::getCurveTable(DmxCurve::Gamma);
+    const uint8_t *square = DmxProcessor::getCurveTable(DmxCurve::Square);
+    const uint8_t *inverse = DmxProcessor::getCurveTable(DmxCurve::Inverse);
+    const uint8_t *limit = DmxProcessor::getCurveTable(DmxCurve::Limit);
+
+    for (uint16_t x = 0; x < 256; x++) {
+        TEST_ASSERT_EQUAL_UINT8(x, linear[x]);
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)(255.0 * pow(x / 255.0, 2.2) + 0.5), gamma[x]);
+        TEST_ASSERT_EQUAL_UINT8((x * x + 127) / 255, square[x]);
+        TEST_ASSERT_EQUAL_UINT8(255 - x, inverse[x]);
+        TEST_ASSERT_EQUAL_UINT8(x < DMX_PROCESSOR_LIMIT_LEVEL ? x : DMX_PROCESSOR_LIMIT_LEVEL, limit[x]);
+    }
+}
+
+void test_curves_and_master(void) {
+    processor->setCurve(0, DmxCurve::Inverse, false);
+    processor->setCurve(1, DmxCurve::Gamma, true);
+    processor->setCurve(2, DmxCurve::Linear, false);
+    processor->setMaster(128);
+    TEST_ASSERT_FALSE(processor->isPassthrough());
+
+    data[0] = 10;
+    data[1] = 200;
+    data[2] = 200;
+    data[3] = 200;
+    data[4] = 255;
+    TEST_ASSERT_EQUAL_UINT16(5, processor->process(data, 5, output));
+
+    TEST_ASSERT_EQUAL_UINT8(245, output[0]);
+    TEST_ASSERT_EQUAL_UINT8((DmxProcessor::getCurveTable(DmxCurve::Gamma)[200] * 128 + 127) / 255, output[1]);
+    TEST_ASSERT_EQUAL_UINT8(200, output[2]);
+    TEST_ASSERT_EQUAL_UINT8(100, output[3]);
+    TEST_ASSERT_EQUAL_UINT8(128, output[4]);
+    TEST_ASSERT_EQUAL_UINT8(0xAA, output[5]);
+
+    // Back at full, only the curves are left.
+    processor->setMaster(255);
+    processor->process(data, 5, output);
+    TEST_ASSERT_EQUAL_UINT8(200, output[3]);
+
+    processor->reset();
+    TEST_ASSERT_TRUE(processor->isPassthrough());
+}
+
+void test_patch(void) {
+    processor->setPatch(0, 3);
+    processor->setPatch(1, 3);
+    processor->setPatch(2, DMX_PROCESSOR_UNPATCHED);
+    processor->setPatch(3, 0);
+    // Received channels don't reach this far, the slot reads 0.
+    processor->setPatch(300, 400);
+    processor->setCurve(2, DmxCurve::Inverse, false);
+    processor->setCurve(300, DmxCurve::Inverse, false);
+
+    TEST_ASSERT_EQUAL_UINT16(DMX_MAX_CHANNELS, processor->process(data, 100, output));
+
+    TEST_ASSERT_EQUAL_UINT8(data[3], output[0]);
+    TEST_ASSERT_EQUAL_UINT8(data[3], output[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, output[2]);
+    TEST_ASSERT_EQUAL_UINT8(data[0], output[3]);
+    TEST_ASSERT_EQUAL_UINT8(data[50], output[50]);
+    TEST_ASSERT_EQUAL_UINT8(0, output[200]);
+    TEST_ASSERT_EQUAL_UINT8(255, output[300]);
+
+    // The frame ends after the highest patched slot.
+    for (uint16_t i = 10; i < DMX_MAX_CHANNELS; i++) {
+        processor->setPatch(i, DMX_PROCESSOR_UNPATCHED);
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(10, processor->process(data, 100, output));
+}
+
+void test_out_of_range_settings_are_ignored(void) {
+    processor->setPatch(DMX_MAX_CHANNELS, 0);
+    processor->setCurve(DMX_MAX_CHANNELS, DmxCurve::Inverse, false);
+    processor->setCurve(0, DmxCurve::Count, false);
+    TEST_ASSERT_TRUE(processor->isPassthrough());
+}
+
+// Same result as the word pass, one slot at a time.
+static uint16_t processReference(const uint8_t *patch, const DmxCurve *curves, uint8_t master, const uint8_t *in, uint8_t *out) {
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i++) {
+        uint8_t value = DmxProcessor::getCurveTable(curves[i])[in[patch[i]]];
+        out[i] = (value * master + 127) / 255;
+    }
+
+    return DMX_MAX_CHANNELS;
+}
+
+void test_bench_full_frame(void) {
+    static const uint32_t ITERATIONS = 200000;
+    static uint8_t patch[DMX_MAX_CHANNELS];
+    static DmxCurve curves[DMX_MAX_CHANNELS];
+    static uint8_t expected[DMX_MAX_CHANNELS];
+
+    double passthrough = bench::nsPerOp(ITERATIONS, [](uint32_t i) {
+        data[0] = i;
+        bench::doNotOptimize(processor->process(data, DMX_MAX_CHANNELS, output));
+        bench::doNotOptimize(output);
+    });
+
+    // Fixtures repatched in reverse order, every curve in use, master at 80%.
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i++) {
+        patch[i] = (DMX_MAX_CHANNELS - 1 - i) & 0xFF;
+        curves[i] = (DmxCurve)(i % (uint8_t)DmxCurve::Count);
+        processor->setPatch(i, patch[i]);
+        processor->setCurve(i, curves[i], true);
+    }
+
+    processor->setMaster(204);
+
+    processReference(patch, curves, 204, data, expected);
+    TEST_ASSERT_EQUAL_UINT16(DMX_MAX_CHANNELS, processor->process(data, DMX_MAX_CHANNELS, output));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, output, DMX_MAX_CHANNELS);
+
+    double processed = bench::nsPerOp(ITERATIONS, [](uint32_t i) {
+        data[0] = i;
+        bench::doNotOptimize(processor->process(data, DMX_MAX_CHANNELS, output));
+        bench::doNotOptimize(output);
+    });
+
+    double reference = bench::nsPerOp(ITERATIONS, [](uint32_t i) {
+        data[0] = i;
+        bench::doNotOptimize(processReference(patch, curves, 204, data, expected));
+        bench::doNotOptimize(expected);
+    });
+
+    bench::report("512 slots, passthrough", passthrough);
+    bench::report("512 slots, patch+curve+master", processed);
+    bench::report("512 slots, per slot reference", reference);
+
+    // The device budget is 50 us per frame, the host must be well inside it.
+    TEST_ASSERT_LESS_THAN(50000.0, processed);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_is_passthrough);
+    RUN_TEST(test_curve_tables);
+    RUN_TEST(test_curves_and_master);
+    RUN_TEST(test_patch);
+    RUN_TEST(test_out_of_range_settings_are_ignored);
+    RUN_TEST(test_bench_full_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,383 @@
+#include <Arduino.h>
+#include <DmxShow.h>
+#include <DmxShowCodec.h>
+#include <FakeFlash.h>
+#include <ShowGenerator.h>
+#include <unity.h>
+#include <vector>
+
+// 44 Hz
+#define FRAME_MICROS 22727
+
+static DmxShowEncoder *encoder;
+static DmxShowDecoder *decoder;
+static uint8_t record[DMX_SHOW_MAX_RECORD_SIZE];
+
+// Encodes and decodes one frame, checking the decoder rebuilds it. Returns
+// the record size.
+static uint16_t roundTrip(uint8_t port, const uint8_t *slots, uint16_t length) {
+    uint16_t size = encoder->encode(port, 23, slots, length, record);
+
+    if (size == 0) {
+        return 0;
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL(DMX_SHOW_MAX_RECORD_SIZE, size);
+    TEST_ASSERT_EQUAL_UINT16(size, decoder->decode(record, size));
+    TEST_ASSERT_EQUAL_UINT8(port, decoder->getPort());
+    TEST_ASSERT_EQUAL_UINT16(length, decoder->getLength());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(slots, decoder->getFrame(), length);
+
+    return size;
+}
+
+void setUp(void) {
+    encoder = new DmxShowEncoder();
+    decoder = new DmxShowDecoder();
+}
+
+void tearDown(void) {
+    delete decoder;
+    delete encoder;
+    arduino_shim::useHostClock();
+}
+
+void test_round_trip_of_show_patterns(void) {
+    ShowGenerator show(1);
+    uint8_t slots[DMX_MAX_CHANNELS];
+
+    for (uint32_t frame = 0; frame < 44 * 30; frame++) {
+        show.render(frame, slots);
+        roundTrip(frame % 3, slots, DMX_MAX_CHANNELS);
+    }
+}
+
+void test_round_trip_of_edge_cases(void) {
+    uint8_t slots[DMX_MAX_CHANNELS];
+
+    // Alternating changed / unchanged slots, the most tokens per slot.
+    memset(slots, 0, sizeof(slots));
+    roundTrip(0, slots, DMX_MAX_CHANNELS);
+
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i += 2) {
+        slots[i] = i | 1;
+    }
+
+    roundTrip(0, slots, DMX_MAX_CHANNELS);
+
+    // Noise, then long runs of one value, then a ramp.
+    ShowGenerator noise(2);
+    noise.noise = true;
+    noise.render(5, slots);
+    roundTrip(1, slots, DMX_MAX_CHANNELS);
+
+    memset(slots, 77, sizeof(slots));
+    TEST_ASSERT_LESS_OR_EQUAL(32, roundTrip(1, slots, DMX_MAX_CHANNELS));
+
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i++) {
+        slots[i] = i;
+    }
+
+    roundTrip(1, slots, DMX_MAX_CHANNELS);
+
+    // Shorter and longer frames; slots past a short frame keep their value.
+    slots[0] = 200;
+    roundTrip(1, slots, 24);
+    slots[400] = 1;
+    roundTrip(1, slots, DMX_MAX_CHANNELS);
+    roundTrip(1, slots, 1);
+    roundTrip(1, slots, 0);
+}
+
+void test_unchanged_frames_take_no_space(void) {
+    uint8_t slots[64] = { 5 };
+
+    TEST_ASSERT_GREATER_THAN(0, encoder->encode(0, 0, slots, 64, record));
+    TEST_ASSERT_EQUAL_UINT16(0, encoder->encode(0, 0, slots, 64, record));
+    // Same data on another port is a first frame there.
+    TEST_ASSERT_GREATER_THAN(0, encoder->encode(1, 0, slots, 64, record));
+    // Same data, shorter.
+    TEST_ASSERT_GREATER_THAN(0, encoder->encode(0, 0, slots, 63, record));
+}
+
+void test_corrupt_records_are_rejected(void) {
+    uint8_t slots[DMX_MAX_CHANNELS];
+
+    for (uint16_t i = 0; i < DMX_MAX_CHANNELS; i++) {
+        slots[i] = i * 3;
+    }
+
+    uint16_t size = encoder->encode(0, 1000, slots, DMX_MAX_CHANNELS, record);
+
+    // Truncated anywhere.
+    for (uint16_t i = 0; i < size; i++) {
+        TEST_ASSERT_EQUAL_UINT16(0, decoder->decode(record, i));
+    }
+
+    // Bad port.
+    record[0] = DMX_SHOW_MAX_PORTS;
+    TEST_ASSERT_EQUAL_UINT16(0, decoder->decode(record, size));
+
+    // Tokens covering more slots than the frame has.
+    uint8_t overflow[] = { 0, 0, 2, (uint8_t)DmxShowToken::Fill | 3, 9 };
+    TEST_ASSERT_EQUAL_UINT16(0, decoder->decode(overflow, sizeof(overflow)));
+
+    // Slot count above 512.
+    uint8_t tooLong[] = { 0, 0, 0x81, 0x04, (uint8_t)DmxShowToken::End };
+    TEST_ASSERT_EQUAL_UINT16(0, decoder->decode(tooLong, sizeof(tooLong)));
+}
+
+typedef struct {
+    uint8_t port;
+    unsigned long millis;
+    uint8_t slots[DMX_MAX_CHANNELS];
+} PlayedFrame;
+
+void test_record_and_play_back(void) {
+    static FakeFlash flash(128 * 1024);
+    static DmxShowRecorder recorder;
+    static DmxShowPlayer player;
+    static std::vector<PlayedFrame> recorded;
+    ShowGenerator shows[3] = { ShowGenerator(1), ShowGenerator(2), ShowGenerator(3) };
+    PlayedFrame frame;
+
+    recorded.clear();
+    arduino_shim::setFakeClock(1000000);
+    recorder.begin(&flash);
+    player.begin(&flash);
+    TEST_ASSERT_FALSE(player.hasShow());
+
+    TEST_ASSERT_TRUE(recorder.start(millis()));
+
+    // 20 s of three ports; ports 2 and 3 are static half of the time.
+    for (uint32_t i = 0; i < 44 * 20; i++) {
+        for (uint8_t port = 0; port < 3; port++) {
+            shows[port].render(port && i % 200 > 100 ? 0 : i, frame.slots);
+            frame.port = port;
+            frame.millis = millis();
+            TEST_ASSERT_TRUE(recorder.record(port, frame.slots, DMX_MAX_CHANNELS, millis()));
+            recorded.push_back(frame);
+        }
+
+        TEST_ASSERT_TRUE(recorder.update());
+        arduino_shim::advanceFakeClock(FRAME_MICROS);
+    }
+
+    recorder.stop(millis());
+    TEST_ASSERT_EQUAL_UINT32(0, flash.dirtyWrites);
+    printf("[show] 20 s, 3 ports: %u records, %u bytes, %.1f:1\n",
+        recorder.getRecords(), recorder.getRecordedBytes(),
+        recorded.size() * (double)DMX_MAX_CHANNELS / recorder.getRecordedBytes());
+
+    player.load();
+    TEST_ASSERT_TRUE(player.hasShow());
+    TEST_ASSERT_EQUAL_UINT32(recorder.getRecords(), player.getHeader()->records);
+
+    // Plays back with the recorded timing; frames equal to the previous one
+    // of their port were not recorded, so only the latest state is compared.
+    static uint8_t expected[3][DMX_MAX_CHANNELS];
+    static uint8_t played[3][DMX_MAX_CHANNELS];
+    unsigned long start = 5000000;
+    unsigned long offset = start / 1000 - recorded[0].millis;
+
+    memset(played, 0, sizeof(played));
+    arduino_shim::setFakeClock(start);
+    player.loop = 0;
+    TEST_ASSERT_TRUE(player.start(millis()));
+
+    for (size_t i = 0; i < recorded.size();) {
+        // Everything recorded up to now.
+        while (i < recorded.size() && recorded[i].millis + offset <= millis()) {
+            memcpy(expected[recorded[i].port], recorded[i].slots, DMX_MAX_CHANNELS);
+            i++;
+        }
+
+        while (player.next(millis())) {
+            memcpy(played[player.getPort()], player.getFrame(), player.getLength());
+        }
+
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, played, sizeof(expected));
+        arduino_shim::advanceFakeClock(1000);
+    }
+
+    arduino_shim::advanceFakeClock(1000000);
+    TEST_ASSERT_FALSE(player.next(millis()));
+    TEST_ASSERT_FALSE(player.isPlaying());
+}
+
+void test_loop_restarts_after_the_recorded_duration(void) {
+    static FakeFlash flash(16 * 1024);
+    static DmxShowRecorder recorder;
+    static DmxShowPlayer player;
+    uint8_t slots[4] = { 0 };
+
+    arduino_shim::setFakeClock(0);
+    recorder.begin(&flash);
+    recorder.start(0);
+
+    // Slot 1 counts seconds for 3 s, the recording stops at 5 s.
+    for (uint8_t i = 0; i < 3; i++) {
+        slots[0] = i + 1;
+        recorder.record(0, slots, 4, i * 1000);
+    }
+
+    recorder.stop(5000);
+    player.begin(&flash);
+    player.loop = 1;
+    player.start(100000);
+
+    uint8_t sequence[8];
+    unsigned long times[8];
+    uint8_t count = 0;
+
+    for (unsigned long now = 100000; now <= 111000 && count < 8; now++) {
+        while (count < 8 && player.next(now)) {
+            sequence[count] = player.getFrame()[0];
+            times[count++] = now;
+        }
+    }
+
+    uint8_t expectedSequence[] = { 1, 2, 3, 1, 2, 3, 1, 2 };
+    unsigned long expectedTimes[] = { 100000, 101000, 102000, 105000, 106000, 107000, 110000, 111000 };
+
+    TEST_ASSERT_EQUAL_UINT8(8, count);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedSequence, sequence, 8);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_UINT32(expectedTimes[i], times[i]);
+    }
+}
+
+void test_interrupted_or_full_recordings(void) {
+    static FakeFlash flash(8 * 1024);
+    static DmxShowRecorder recorder;
+    static DmxShowPlayer player;
+    ShowGenerator noise(9);
+    uint8_t slots[DMX_MAX_CHANNELS];
+    uint32_t frames = 0;
+
+    noise.noise = true;
+    recorder.begin(&flash);
+    player.begin(&flash);
+
+    // Power lost while recording: the header is never completed.
+    recorder.start(0);
+    noise.render(0, slots);
+    recorder.record(0, slots, DMX_MAX_CHANNELS, 0);
+    player.load();
+    TEST_ASSERT_FALSE(player.hasShow());
+
+    // Noise fills 8 KB in about 15 frames: the recording stops by itself
+    // and keeps what fitted.
+    recorder.start(0);
+
+    while (recorder.record(0, slots, DMX_MAX_CHANNELS, frames * 23)) {
+        recorder.update();
+        noise.render(++frames, slots);
+    }
+
+    // The rest of the queue is written by the next update.
+    TEST_ASSERT_TRUE(recorder.isRecording());
+    TEST_ASSERT_FALSE(recorder.update());
+    TEST_ASSERT_FALSE(recorder.isRecording());
+    TEST_ASSERT_LESS_OR_EQUAL(8 * 1024 - DMX_SHOW_DATA_OFFSET, recorder.getRecordedBytes());
+    TEST_ASSERT_GREATER_THAN(8 * 1024 - DMX_SHOW_DATA_OFFSET - DMX_SHOW_MAX_RECORD_SIZE, recorder.getRecordedBytes());
+
+    player.load();
+    player.loop = 0;
+    TEST_ASSERT_TRUE(player.hasShow());
+    TEST_ASSERT_TRUE(player.start(0));
+
+    uint32_t played = 0;
+
+    for (unsigned long now = 0; player.isPlaying(); now++) {
+        while (player.next(now)) {
+            noise.render(played++, slots);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(slots, player.getFrame(), DMX_MAX_CHANNELS);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(frames, played);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.dirtyWrites);
+}
+
+void test_flash_is_only_written_by_update(void) {
+    static FakeFlash flash(64 * 1024);
+    static DmxShowRecorder recorder;
+    static DmxShowPlayer player;
+    ShowGenerator noise(5);
+    uint8_t slots[DMX_MAX_CHANNELS];
+    uint32_t frames = 0;
+
+    noise.noise = true;
+    recorder.begin(&flash);
+    TEST_ASSERT_TRUE(recorder.start(0));
+
+    // Noise takes about 500 bytes a frame.
+    for (; frames < 3; frames++) {
+        noise.render(frames, slots);
+        TEST_ASSERT_TRUE(recorder.record(0, slots, DMX_MAX_CHANNELS, frames * 23));
+    }
+
+    TEST_ASSERT_TRUE(recorder.update());
+
+    uint32_t erases = flash.erases;
+    uint32_t writes = flash.writes;
+
+    // Into the third sector.
+    for (; frames < 17; frames++) {
+        noise.render(frames, slots);
+        TEST_ASSERT_TRUE(recorder.record(0, slots, DMX_MAX_CHANNELS, frames * 23));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(erases, flash.erases);
+    TEST_ASSERT_EQUAL_UINT32(writes, flash.writes);
+
+    // One erase per update, the queue goes out over a few of them.
+    uint32_t updates = 0;
+
+    while (flash.bytesWritten < recorder.getRecordedBytes() - DMX_SHOW_PAGE_SIZE) {
+        uint32_t before = flash.erases;
+
+        TEST_ASSERT_TRUE(recorder.update());
+        TEST_ASSERT_LESS_OR_EQUAL(before + 1, flash.erases);
+        updates++;
+    }
+
+    TEST_ASSERT_GREATER_THAN(1, updates);
+
+    // Without updates the queue overruns: the recording ends with what was
+    // queued before.
+    for (;; frames++) {
+        noise.render(frames, slots);
+
+        if (!recorder.record(0, slots, DMX_MAX_CHANNELS, frames * 23)) {
+            break;
+        }
+    }
+
+    TEST_ASSERT_TRUE(recorder.isRecording());
+    TEST_ASSERT_LESS_THAN(32 * 1024, recorder.getRecordedBytes());
+
+    while (recorder.update()) {
+    }
+
+    player.begin(&flash);
+    TEST_ASSERT_TRUE(player.hasShow());
+    TEST_ASSERT_EQUAL_UINT32(recorder.getRecords(), player.getHeader()->records);
+    TEST_ASSERT_EQUAL_UINT32(frames, player.getHeader()->records);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.dirtyWrites);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_of_show_patterns);
+    RUN_TEST(test_round_trip_of_edge_cases);
+    RUN_TEST(test_unchanged_frames_take_no_space);
+    RUN_TEST(test_corrupt_records_are_rejected);
+    RUN_TEST(test_record_and_play_back);
+    RUN_TEST(test_loop_restarts_after_the_recorded_duration);
+    RUN_TEST(test_interrupted_or_full_recordings);
+    RUN_TEST(test_flash_is_only_written_by_update);
+    return UNITY_END();
+}
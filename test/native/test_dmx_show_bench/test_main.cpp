@@ -0,0 +1,102 @@
+#include <Arduino.h>
+#include <Bench.h>
+#include <DmxShowCodec.h>
+#include <ShowGenerator.h>
+#include <unity.h>
+#include <vector>
+
+// One minute at 44 Hz.
+static constexpr uint32_t SHOW_FRAMES = 44 * 60;
+// Data partition of no_ota.csv, where the node keeps its show.
+static constexpr uint32_t SHOW_PARTITION_SIZE = 0x1E0000;
+
+static uint8_t frames[SHOW_FRAMES][DMX_MAX_CHANNELS];
+static std::vector<uint8_t> stream;
+static uint32_t records;
+
+static void renderShow(ShowGenerator &show) {
+    for (uint32_t i = 0; i < SHOW_FRAMES; i++) {
+        show.render(i, frames[i]);
+    }
+}
+
+// Encodes every frame into `stream`, returning ns per frame.
+static double encodeShow(void) {
+    static DmxShowEncoder encoder;
+    uint8_t record[DMX_SHOW_MAX_RECORD_SIZE];
+
+    stream.clear();
+    records = 0;
+    encoder.reset();
+
+    return bench::nsPerOp(SHOW_FRAMES, [&record](uint32_t i) {
+        uint16_t size = encoder.encode(0, 23, frames[i], DMX_MAX_CHANNELS, record);
+        stream.insert(stream.end(), record, record + size);
+        records += size > 0;
+    });
+}
+
+// Decodes `stream`, checking it against the frames, returning ns per record.
+static double decodeShow(void) {
+    static DmxShowDecoder decoder;
+    uint32_t offset = 0;
+
+    decoder.reset();
+
+    double ns = bench::nsPerOp(records, [&offset](uint32_t i) {
+        offset += decoder.decode(stream.data() + offset, stream.size() - offset);
+        bench::doNotOptimize(decoder.getFrame()[0]);
+    });
+
+    TEST_ASSERT_EQUAL_UINT32(stream.size(), offset);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frames[SHOW_FRAMES - 1], decoder.getFrame(), DMX_MAX_CHANNELS);
+
+    return ns;
+}
+
+static void benchShow(const char *name, ShowGenerator &show) {
+    char label[64];
+
+    renderShow(show);
+
+    double encodeNs = encodeShow();
+    double decodeNs = decodeShow();
+    double ratio = SHOW_FRAMES * (double)DMX_MAX_CHANNELS / stream.size();
+    double minutes = SHOW_PARTITION_SIZE / (double)stream.size();
+
+    snprintf(label, sizeof(label), "%s encode", name);
+    bench::report(label, encodeNs);
+    snprintf(label, sizeof(label), "%s decode", name);
+    bench::report(label, decodeNs);
+    printf("[show] %-24s %8u bytes/min %6.1f:1 %6.1f MB/s decoded, %5.1f universe-minutes in flash\n",
+        name, (unsigned) stream.size(), ratio,
+        DMX_MAX_CHANNELS * 1e3 / decodeNs, minutes);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_busy_show(void) {
+    ShowGenerator show(1);
+
+    benchShow("Busy show", show);
+    // Five minutes of three universes must fit.
+    TEST_ASSERT_LESS_THAN(SHOW_PARTITION_SIZE / 3 / 5, stream.size());
+}
+
+void test_noise(void) {
+    ShowGenerator show(2);
+
+    show.noise = true;
+    benchShow("Noise", show);
+    // Worst case: no more than the literal token overhead.
+    TEST_ASSERT_LESS_OR_EQUAL(SHOW_FRAMES * (DMX_MAX_CHANNELS + DMX_MAX_CHANNELS / 64 + 8), stream.size());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_busy_show);
+    RUN_TEST(test_noise);
+    return UNITY_END();
+}
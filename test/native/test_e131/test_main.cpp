@@ -0,0 +1,267 @@
+#include <Arduino.h>
+#include <ArtNetReceiver.h>
+#include <DmxFrameBuffer.h>
+#include <E131.h>
+#include <FakeUdp.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static E131 *e131;
+static uint32_t frames;
+static uint8_t lastFrame[512];
+static uint16_t lastFrameLength;
+static uint32_t lastCommitMask;
+
+static uint8_t packet[sizeof(E131DataPacket)];
+
+static const uint8_t ROOT_LAYER[] = {
+    0x00, 0x10, 0x00, 0x00, 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0x00, 0x00, 0x00
+};
+
+static void buildPacket(uint8_t *buffer, uint16_t universe, uint8_t priority, uint8_t sequence, uint8_t value, uint16_t slots = 512) {
+    E131DataPacket *header = (E131DataPacket*) buffer;
+
+    memset(buffer, 0, sizeof(E131DataPacket));
+    memcpy(buffer, ROOT_LAYER, sizeof(ROOT_LAYER));
+    header->RootFlagsLengthHi = 0x72;
+    header->RootFlagsLengthLo = 0x6E;
+    header->RootVector[3] = E131_VECTOR_ROOT_DATA;
+    header->FramingVector[3] = E131_VECTOR_FRAMING_DATA;
+    strcpy(header->SourceName, "Console");
+    header->Priority = priority;
+    header->Sequence = sequence;
+    header->UniverseHi = universe >> 8;
+    header->UniverseLo = universe & 0xFF;
+    header->DmpVector = 0x02;
+    header->AddressType = 0xA1;
+    header->AddressIncrementLo = 1;
+    header->PropertyCountHi = (slots + 1) >> 8;
+    header->PropertyCountLo = (slots + 1) & 0xFF;
+    memset(header->Data, value, slots);
+}
+
+// Sources are told apart by CID: unless told otherwise each host has its own.
+static void setCid(uint8_t *buffer, uint32_t cid) {
+    memcpy(((E131DataPacket*) buffer)->Cid, &cid, sizeof(cid));
+}
+
+static PacketParseStatus receive(uint32_t ip, uint16_t universe, uint8_t priority, uint8_t sequence, uint8_t value, uint32_t cid = 0) {
+    buildPacket(packet, universe, priority, sequence, value);
+    setCid(packet, cid ? cid : ip);
+    return e131->onPacketReceived(ip, E131_PORT, packet, sizeof(packet));
+}
+
+void setUp(void) {
+    arduino_shim::setFakeClock(1000000);
+
+    e131 = new E131();
+    frames = 0;
+    lastFrameLength = 0;
+    lastCommitMask = 0;
+    memset(lastFrame, 0, sizeof(lastFrame));
+
+    e131->setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        frames++;
+        memcpy(lastFrame, data, size);
+        lastFrameLength = size;
+    });
+
+    e131->setDmxCommitCallback([](uint32_t portMask) {
+        lastCommitMask = portMask;
+    });
+}
+
+void tearDown(void) {
+    delete e131;
+    e131 = NULL;
+    arduino_shim::useHostClock();
+}
+
+void test_delivers_data_of_port_universe(void) {
+    TEST_ASSERT_EQUAL_INT8((int8_t)PacketParseStatus::Success, (int8_t)receive(0x0A000001, 1, 100, 0, 42));
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+    TEST_ASSERT_EQUAL_UINT16(512, lastFrameLength);
+    TEST_ASSERT_EQUAL_UINT8(42, lastFrame[511]);
+    TEST_ASSERT_EQUAL_INT16(100, e131->getActivePriority(0));
+
+    receive(0x0A000001, 7, 100, 1, 42);
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+    TEST_ASSERT_EQUAL_UINT32(1, e131->stats.dmxForeign);
+}
+
+void test_classifies_from_header(void) {
+    buildPacket(packet, 2, 100, 0, 1);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::DmxAccepted, (uint8_t)e131->classifyHeader(packet, E131_DMX_HEADER_SIZE));
+
+    buildPacket(packet, 300, 100, 0, 1);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::DmxRejected, (uint8_t)e131->classifyHeader(packet, E131_DMX_HEADER_SIZE));
+
+    ((E131DataPacket*) packet)->RootVector[3] = E131_VECTOR_ROOT_EXTENDED;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::Other, (uint8_t)e131->classifyHeader(packet, E131_DMX_HEADER_SIZE));
+
+    packet[4] = 'X';
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)HeaderClass::Other, (uint8_t)e131->classifyHeader(packet, E131_DMX_HEADER_SIZE));
+    TEST_ASSERT_EQUAL_INT8((int8_t)PacketParseStatus::BadId, (int8_t)e131->onPacketReceived(1, E131_PORT, packet, sizeof(packet)));
+}
+
+void test_highest_priority_wins(void) {
+    receive(0x0A000001, 1, 100, 0, 10);
+    receive(0x0A000002, 1, 150, 0, 20);
+    TEST_ASSERT_EQUAL_UINT8(20, lastFrame[0]);
+    TEST_ASSERT_EQUAL_INT16(150, e131->getActivePriority(0));
+
+    // The lower source is ignored while the higher one is alive.
+    receive(0x0A000001, 1, 100, 1, 10);
+    TEST_ASSERT_EQUAL_UINT32(2, frames);
+    TEST_ASSERT_EQUAL_UINT32(1, e131->stats.dmxPriority);
+    TEST_ASSERT_EQUAL_UINT8(1, e131->mergers[0].getSourceCount());
+
+    // Until it is lost.
+    arduino_shim::advanceFakeClock((E131_SOURCE_TIMEOUT_MS + 1) * 1000UL);
+    receive(0x0A000001, 1, 100, 2, 10);
+    TEST_ASSERT_EQUAL_UINT32(3, frames);
+    TEST_ASSERT_EQUAL_UINT8(10, lastFrame[0]);
+    TEST_ASSERT_EQUAL_INT16(100, e131->getActivePriority(0));
+}
+
+void test_same_priority_sources_are_merged(void) {
+    receive(0x0A000001, 1, 100, 0, 10);
+    receive(0x0A000002, 1, 100, 0, 90);
+    receive(0x0A000001, 1, 100, 1, 10);
+
+    TEST_ASSERT_TRUE(e131->needsMerge(0));
+    TEST_ASSERT_EQUAL_UINT8(90, lastFrame[0]);
+}
+
+void test_sources_are_told_apart_by_cid(void) {
+    // Two senders on one host.
+    receive(0x0A000001, 1, 100, 0, 10, 0x111);
+    receive(0x0A000001, 1, 100, 0, 90, 0x222);
+    receive(0x0A000001, 1, 100, 1, 10, 0x111);
+
+    TEST_ASSERT_EQUAL_UINT8(2, e131->mergers[0].getSourceCount());
+    TEST_ASSERT_EQUAL_UINT8(90, lastFrame[0]);
+
+    // One sender moving host keeps its sequence.
+    receive(0x0A000002, 1, 100, 0, 50, 0x222);
+    TEST_ASSERT_EQUAL_UINT8(2, e131->mergers[0].getSourceCount());
+    TEST_ASSERT_EQUAL_UINT32(1, e131->getSequenceRejected());
+}
+
+void test_commits_only_the_port_written(void) {
+    receive(0x0A000001, 2, 100, 0, 10);
+    TEST_ASSERT_EQUAL_UINT32(1UL << 1, lastCommitMask);
+
+    receive(0x0A000001, 1, 100, 1, 10);
+    TEST_ASSERT_EQUAL_UINT32(1UL << 0, lastCommitMask);
+}
+
+void test_sequence_rule(void) {
+    receive(0x0A000001, 1, 100, 250, 1);
+    receive(0x0A000001, 1, 100, 251, 2);
+    // Late packet.
+    receive(0x0A000001, 1, 100, 245, 3);
+    TEST_ASSERT_EQUAL_UINT32(2, frames);
+    TEST_ASSERT_EQUAL_UINT32(1, e131->getSequenceRejected());
+
+    // Wraps.
+    receive(0x0A000001, 1, 100, 3, 4);
+    TEST_ASSERT_EQUAL_UINT32(3, frames);
+
+    // Far behind is a restarted source.
+    receive(0x0A000001, 1, 100, 200, 5);
+    TEST_ASSERT_EQUAL_UINT32(4, frames);
+}
+
+void test_preview_start_code_and_termination(void) {
+    buildPacket(packet, 1, 100, 0, 1);
+    ((E131DataPacket*) packet)->Options = E131_OPTION_PREVIEW;
+    e131->onPacketReceived(0x0A000001, E131_PORT, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_UINT32(1, e131->stats.dmxPreview);
+
+    buildPacket(packet, 1, 100, 0, 1);
+    ((E131DataPacket*) packet)->StartCode = 0xDD;
+    e131->onPacketReceived(0x0A000001, E131_PORT, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_UINT32(1, e131->stats.dmxStartCode);
+    TEST_ASSERT_EQUAL_UINT32(0, frames);
+
+    receive(0x0A000002, 1, 150, 0, 20);
+
+    // The high priority source leaves, the lower one takes over right away.
+    buildPacket(packet, 1, 150, 1, 20);
+    setCid(packet, 0x0A000002);
+    ((E131DataPacket*) packet)->Options = E131_OPTION_TERMINATED;
+    e131->onPacketReceived(0x0A000002, E131_PORT, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_UINT32(1, e131->stats.dmxTerminated);
+    TEST_ASSERT_EQUAL_INT16(-1, e131->getActivePriority(0));
+
+    receive(0x0A000001, 1, 100, 1, 10);
+    TEST_ASSERT_EQUAL_UINT8(10, lastFrame[0]);
+}
+
+void test_bad_lengths(void) {
+    buildPacket(packet, 1, 100, 0, 1, 100);
+    TEST_ASSERT_EQUAL_INT8((int8_t)PacketParseStatus::Success, (int8_t)e131->onPacketReceived(1, E131_PORT, packet, E131_DMX_HEADER_SIZE + 100));
+    TEST_ASSERT_EQUAL_UINT16(100, lastFrameLength);
+
+    buildPacket(packet, 1, 100, 1, 1, 100);
+    e131->onPacketReceived(1, E131_PORT, packet, E131_DMX_HEADER_SIZE + 50);
+    TEST_ASSERT_EQUAL_UINT32(1, e131->stats.dmxTruncated);
+
+    buildPacket(packet, 1, 100, 2, 1);
+    ((E131DataPacket*) packet)->PropertyCountHi = 0x03;
+    e131->onPacketReceived(1, E131_PORT, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_UINT32(1, e131->stats.dmxBadLength);
+
+    TEST_ASSERT_EQUAL_INT8((int8_t)PacketParseStatus::BadSize, (int8_t)e131->onPacketReceived(1, E131_PORT, packet, 20));
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+}
+
+void test_multicast_group(void) {
+    uint32_t group = E131::getMulticastGroup(0x0102);
+    uint8_t octets[4];
+    memcpy(octets, &group, sizeof(octets));
+
+    TEST_ASSERT_EQUAL_UINT8(239, octets[0]);
+    TEST_ASSERT_EQUAL_UINT8(255, octets[1]);
+    TEST_ASSERT_EQUAL_UINT8(1, octets[2]);
+    TEST_ASSERT_EQUAL_UINT8(2, octets[3]);
+}
+
+void test_receiver_reads_slots_into_frame_buffer(void) {
+    FakeUdp udp;
+    DmxFrameBuffer frameBuffers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+    Receiver<FakeUdp, E131> receiver(e131, &udp, frameBuffers);
+
+    buildPacket(packet, 1, 100, 0, 33);
+    udp.push(0x0A000001, E131_PORT, packet, sizeof(packet));
+    buildPacket(packet, 500, 100, 0, 44);
+    udp.push(0x0A000001, E131_PORT, packet, sizeof(packet));
+
+    TEST_ASSERT_EQUAL_UINT16(2, receiver.drain());
+    TEST_ASSERT_EQUAL_UINT32(1, receiver.stats.dmxFrames);
+    TEST_ASSERT_EQUAL_UINT32(1, e131->stats.dmxForeign);
+    // Zero copy path, the data callback isn't involved.
+    TEST_ASSERT_EQUAL_UINT32(0, frames);
+
+    frameBuffers[0].publish();
+    TEST_ASSERT_TRUE(frameBuffers[0].swap());
+    TEST_ASSERT_EQUAL_UINT8(33, frameBuffers[0].getReadBuffer()[512]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_delivers_data_of_port_universe);
+    RUN_TEST(test_classifies_from_header);
+    RUN_TEST(test_highest_priority_wins);
+    RUN_TEST(test_same_priority_sources_are_merged);
+    RUN_TEST(test_sources_are_told_apart_by_cid);
+    RUN_TEST(test_commits_only_the_port_written);
+    RUN_TEST(test_sequence_rule);
+    RUN_TEST(test_preview_start_code_and_termination);
+    RUN_TEST(test_bad_lengths);
+    RUN_TEST(test_multicast_group);
+    RUN_TEST(test_receiver_reads_slots_into_frame_buffer);
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include <Arduino.h>
+#include <ArtNetReceiver.h>
+#include <Bench.h>
+#include <DmxFrameBuffer.h>
+#include <DmxPackets.h>
+#include <E131.h>
+#include <FakeUdp.h>
+#include <unity.h>
+
+using namespace art_net;
+
+static constexpr uint32_t BENCH_ITERATIONS = 200000;
+
+static E131 e131;
+static uint32_t dmxFrames;
+
+static uint8_t dmxPacket[sizeof(E131DataPacket)];
+static uint8_t foreignDmxPacket[sizeof(E131DataPacket)];
+static uint8_t syncPacket[49];
+static uint8_t garbagePacket[64];
+
+static void nextSequence() {
+    ((E131DataPacket*) dmxPacket)->Sequence++;
+}
+
+void setUp(void) {
+    e131 = E131();
+    dmxFrames = 0;
+
+    e131.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {
+        bench::doNotOptimize(data[size - 1]);
+        dmxFrames++;
+    });
+
+    e131.setDmxCommitCallback([](uint32_t portMask) {});
+
+    buildE131Packet(dmxPacket, 1);
+    buildE131Packet(foreignDmxPacket, 300);
+
+    memset(syncPacket, 0, sizeof(syncPacket));
+    memcpy(syncPacket, E131_ROOT_LAYER, sizeof(E131_ROOT_LAYER));
+    syncPacket[21] = E131_VECTOR_ROOT_EXTENDED;
+
+    for (uint8_t i = 0; i < sizeof(garbagePacket); i++) {
+        garbagePacket[i] = i * 37;
+    }
+}
+
+void tearDown(void) {}
+
+void test_dmx_matched(void) {
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        nextSequence();
+        e131.onPacketReceived(0x0A000001, E131_PORT, dmxPacket, sizeof(dmxPacket));
+    });
+
+    bench::report("sACN data matched", ns);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS, dmxFrames);
+}
+
+void test_dmx_foreign_universe(void) {
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        e131.onPacketReceived(0x0A000001, E131_PORT, foreignDmxPacket, sizeof(foreignDmxPacket));
+    });
+
+    bench::report("sACN data foreign universe", ns);
+    TEST_ASSERT_EQUAL_UINT32(0, dmxFrames);
+}
+
+void test_garbage(void) {
+    PacketParseStatus status = PacketParseStatus::Success;
+
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [&status](uint32_t i) {
+        status = e131.onPacketReceived(0x0A000001, E131_PORT, garbagePacket, sizeof(garbagePacket));
+    });
+
+    bench::report("Garbage", ns);
+    TEST_ASSERT_EQUAL_INT8((int8_t)PacketParseStatus::BadId, (int8_t)status);
+    TEST_ASSERT_EQUAL_UINT32(0, dmxFrames);
+}
+
+void test_mixed_multicast_traffic(void) {
+    // Same mix as the ArtNet bench: mostly universes for other nodes, a few
+    // frames for us, an occasional sync and some noise.
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        uint32_t slot = i % 100;
+
+        if (slot < 90) {
+            e131.onPacketReceived(0x0A000001, E131_PORT, foreignDmxPacket, sizeof(foreignDmxPacket));
+        } else if (slot < 98) {
+            nextSequence();
+            e131.onPacketReceived(0x0A000001, E131_PORT, dmxPacket, sizeof(dmxPacket));
+        } else if (slot < 99) {
+            e131.onPacketReceived(0x0A000001, E131_PORT, syncPacket, sizeof(syncPacket));
+        } else {
+            e131.onPacketReceived(0x0A000001, E131_PORT, garbagePacket, sizeof(garbagePacket));
+        }
+    });
+
+    bench::report("Mixed multicast", ns);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS * 8 / 100, dmxFrames);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS / 100, e131.stats.extended);
+}
+
+void test_receiver_packets_per_second(void) {
+    static FakeUdp udp;
+    static DmxFrameBuffer frameBuffers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+    static Receiver<FakeUdp, E131> *receiver = new Receiver<FakeUdp, E131>(&e131, &udp, frameBuffers);
+
+    // Through the socket: header only for the foreign universe, slots read
+    // straight into the frame buffer for ours.
+    double ns = bench::nsPerOp(BENCH_ITERATIONS, [](uint32_t i) {
+        if (i % 10 == 0) {
+            nextSequence();
+            udp.push(0x0A000001, E131_PORT, dmxPacket, sizeof(dmxPacket));
+        } else {
+            udp.push(0x0A000001, E131_PORT, foreignDmxPacket, sizeof(foreignDmxPacket));
+        }
+
+        receiver->drain();
+        frameBuffers[0].publish();
+    });
+
+    bench::report("sACN receive stage", ns);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS / 10, receiver->stats.dmxFrames);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_dmx_matched);
+    RUN_TEST(test_dmx_foreign_universe);
+    RUN_TEST(test_garbage);
+    RUN_TEST(test_mixed_multicast_traffic);
+    RUN_TEST(test_receiver_packets_per_second);
+    return UNITY_END();
+}
@@ -0,0 +1,132 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <EEPROM_Data.h>
+#include <FakeFlash.h>
+#include <unity.h>
+
+static FakeFlash *flash;
+
+static void validSettings(EEPROM_Data *data) {
+    memset(data, 0, sizeof(EEPROM_Data));
+    strcpy(data->systemPassword, "secret");
+    data->channelCount = 256;
+    data->net = 2;
+    data->subuni = 0x35;
+    data->wirelessMode = WIRELESS_MODE_CLIENT_DHCP;
+    strcpy(data->wirelessSSID, "Stage WiFi");
+    strcpy(data->wirelessPassword, "password");
+}
+
+// What a node booting on `flash` would read.
+static void assertJournaled(const EEPROM_Data *expected) {
+    ConfigStore store;
+    EEPROM_Data loaded;
+
+    store.begin(flash, EEPROM_DATA_VERSION, sizeof(EEPROM_Data));
+    TEST_ASSERT_TRUE(store.load((uint8_t*) &loaded));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY((const uint8_t*) expected, (const uint8_t*) &loaded, sizeof(EEPROM_Data));
+}
+
+void setUp(void) {
+    flash = new FakeFlash(2 * CONFIG_STORE_SECTOR_SIZE);
+    memset(arduino_shim::eeprom, 0, sizeof(arduino_shim::eeprom));
+}
+
+void tearDown(void) {
+    delete flash;
+}
+
+void test_old_eeprom_is_imported(void) {
+    EEPROM_Data old;
+    validSettings(&old);
+
+    // The 421 bytes of the firmware before ports, then whatever the EEPROM
+    // held after them.
+    TEST_ASSERT_EQUAL_UINT32(421, EEPROM_DATA_LEGACY_SIZE);
+    memcpy(arduino_shim::eeprom, &old, EEPROM_DATA_LEGACY_SIZE);
+    memset(arduino_shim::eeprom + EEPROM_DATA_LEGACY_SIZE, 0x0E, 16);
+
+    EEPROM_DataInitialize(flash);
+    EEPROM_Data *data = EEPROM_DataGet();
+
+    TEST_ASSERT_EQUAL_STRING("secret", data->systemPassword);
+    TEST_ASSERT_EQUAL_UINT16(256, data->channelCount);
+    TEST_ASSERT_EQUAL_UINT8(2, data->net);
+    TEST_ASSERT_EQUAL_UINT8(0x35, data->subuni);
+    TEST_ASSERT_EQUAL_STRING("Stage WiFi", data->wirelessSSID);
+
+    // Port 1 stays on universe 5, the others get their own.
+    TEST_ASSERT_EQUAL_UINT8(5, data->portUniverse[0]);
+    TEST_ASSERT_EQUAL_UINT8(6, data->portUniverse[1]);
+    TEST_ASSERT_EQUAL_UINT8(7, data->portUniverse[2]);
+
+    for (uint8_t i = 0; i < EEPROM_DATA_OUTPUT_PORTS; i++) {
+        TEST_ASSERT_EQUAL_UINT8(PORT_MODE_OUTPUT, data->portMode[i]);
+        TEST_ASSERT_EQUAL_UINT8(0, data->portMergeMode[i]);
+    }
+
+    TEST_ASSERT_EQUAL_STRING("", data->nodeShortName);
+    assertJournaled(data);
+}
+
+void test_universes_wrap_within_the_subnet(void) {
+    EEPROM_Data old;
+    validSettings(&old);
+    old.subuni = 0x2F;
+    memcpy(arduino_shim::eeprom, &old, EEPROM_DATA_LEGACY_SIZE);
+
+    EEPROM_DataInitialize(flash);
+    EEPROM_Data *data = EEPROM_DataGet();
+
+    TEST_ASSERT_EQUAL_UINT8(0xF, data->portUniverse[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x0, data->portUniverse[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x1, data->portUniverse[2]);
+}
+
+void test_first_journal_layout_keeps_its_ports(void) {
+    EEPROM_Data v1;
+    validSettings(&v1);
+    v1.portUniverse[0] = 9;
+    v1.portUniverse[1] = 3;
+    v1.portUniverse[2] = 12;
+    v1.portMode[2] = PORT_MODE_INPUT;
+
+    ConfigStore previous;
+    previous.begin(flash, 1, EEPROM_DATA_BLUETOOTH_SIZE);
+    previous.load((uint8_t*) &v1);
+    TEST_ASSERT_TRUE(previous.store((const uint8_t*) &v1));
+
+    // Ignored once there is a journal.
+    memcpy(arduino_shim::eeprom, &v1, EEPROM_DATA_LEGACY_SIZE);
+
+    EEPROM_DataInitialize(flash);
+    EEPROM_Data *data = EEPROM_DataGet();
+
+    TEST_ASSERT_EQUAL_UINT8(9, data->portUniverse[0]);
+    TEST_ASSERT_EQUAL_UINT8(3, data->portUniverse[1]);
+    TEST_ASSERT_EQUAL_UINT8(12, data->portUniverse[2]);
+    TEST_ASSERT_EQUAL_UINT8(PORT_MODE_INPUT, data->portMode[2]);
+    assertJournaled(data);
+}
+
+void test_blank_node_gets_the_defaults(void) {
+    EEPROM_DataInitialize(flash);
+    EEPROM_Data *data = EEPROM_DataGet();
+
+    TEST_ASSERT_EQUAL_UINT8(WIRELESS_MODE_UNINITIALIZED, data->wirelessMode);
+
+    for (uint8_t i = 0; i < EEPROM_DATA_OUTPUT_PORTS; i++) {
+        TEST_ASSERT_EQUAL_UINT8(i, data->portUniverse[i]);
+    }
+
+    assertJournaled(data);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_old_eeprom_is_imported);
+    RUN_TEST(test_universes_wrap_within_the_subnet);
+    RUN_TEST(test_first_journal_layout_keeps_its_ports);
+    RUN_TEST(test_blank_node_gets_the_defaults);
+    return UNITY_END();
+}
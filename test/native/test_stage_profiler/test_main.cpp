@@ -0,0 +1,166 @@
+#define STAGE_PROFILER_ENABLED 1
+
+#include <Arduino.h>
+#include <ArtNet.h>
+#include <ArtNetReceiver.h>
+#include <DmxFrameBuffer.h>
+#include <FakeUdp.h>
+#include <StageProfiler.h>
+#include <algorithm>
+#include <unity.h>
+#include <vector>
+
+using namespace art_net;
+
+void setUp(void) {}
+
+void tearDown(void) {
+    arduino_shim::useHostClock();
+}
+
+void test_empty_histogram(void) {
+    LatencyHistogram histogram;
+
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getPercentile(50));
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getMax());
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+}
+
+void test_small_values_are_exact(void) {
+    LatencyHistogram histogram;
+
+    for (uint32_t i = 0; i < 10; i++) {
+        histogram.record(i);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(4, histogram.getPercentile(50));
+    TEST_ASSERT_EQUAL_UINT32(9, histogram.getPercentile(99));
+    TEST_ASSERT_EQUAL_UINT32(9, histogram.getMax());
+    TEST_ASSERT_EQUAL_UINT32(10, histogram.getCount());
+}
+
+void test_percentiles_match_reference_within_bucket_error(void) {
+    LatencyHistogram histogram;
+    std::vector<uint32_t> samples;
+
+    srand(3);
+
+    // Mostly short, with a long tail, like the loop stages.
+    for (uint32_t i = 0; i < 20000; i++) {
+        uint32_t value = rand() % 200;
+
+        if (i % 100 == 0) {
+            value = 1000 + rand() % 50000;
+        }
+
+        samples.push_back(value);
+        histogram.record(value);
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    const uint8_t percents[] = { 50, 90, 99 };
+
+    for (uint8_t percent : percents) {
+        uint32_t reference = samples[(samples.size() * percent + 99) / 100 - 1];
+        uint32_t value = histogram.getPercentile(percent);
+
+        TEST_ASSERT_GREATER_OR_EQUAL(reference, value);
+        TEST_ASSERT_LESS_OR_EQUAL(reference + reference / 4 + 1, value);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(samples.back(), histogram.getMax());
+    TEST_ASSERT_EQUAL_UINT32(samples.back(), histogram.getPercentile(100));
+}
+
+void test_huge_values_land_in_last_bucket(void) {
+    LatencyHistogram histogram;
+
+    histogram.record(0xFFFFFFFF);
+    histogram.record(1);
+
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFF, histogram.getPercentile(100));
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.getPercentile(50));
+}
+
+void test_profile_stage_records_statement_time(void) {
+    LatencyHistogram histogram;
+    uint32_t runs = 0;
+
+    arduino_shim::setFakeClock(0);
+
+    PROFILE_STAGE(&histogram, {
+        runs++;
+        delayMicroseconds(250);
+    });
+
+    TEST_ASSERT_EQUAL_UINT32(1, runs);
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.getCount());
+    TEST_ASSERT_EQUAL_UINT32(250, histogram.getMax());
+}
+
+// The network side of loop() on the host, with a burst every 50 iterations
+// and one slow UDP read standing in for a stall.
+void test_host_loop_report(void) {
+    enum { RECEIVE, REPLIES, STAGE_COUNT };
+    const char *names[STAGE_COUNT] = { "Loop UDP Receive", "Loop Replies" };
+    LatencyHistogram histograms[STAGE_COUNT];
+
+    static ArtNet artNet;
+    static DmxFrameBuffer frameBuffers[ART_NET_OUTPUT_UNIVERSE_COUNT];
+    static FakeUdp udp;
+    static uint8_t dmxPacket[sizeof(ArtNetDmxDataPacket)];
+
+    artNet = ArtNet();
+    artNet.setDmxDataCallback([](uint8_t universe, uint8_t ctrlByte, const uint8_t *data, uint16_t size) {});
+    artNet.setDmxCommitCallback([]() {});
+    artNet.setSendPacketCallback([](uint32_t ip, uint16_t port, const uint8_t *data, uint32_t size) {});
+
+    Receiver<FakeUdp> receiver(&artNet, &udp, frameBuffers);
+
+    ArtNetDmxDataPacket *packet = (ArtNetDmxDataPacket*) dmxPacket;
+    memset(dmxPacket, 0, sizeof(dmxPacket));
+    memcpy(packet->ID, ART_NET_ID, sizeof(ART_NET_ID));
+    packet->OpCodeLo = ((uint16_t)OpCode::Dmx & 0xFF);
+    packet->OpCodeHi = ((uint16_t)OpCode::Dmx >> 8);
+    packet->LengthHi = 512 >> 8;
+    packet->LengthLo = 512 & 0xFF;
+
+    for (uint32_t i = 0; i < 2000; i++) {
+        if (i % 50 == 0) {
+            for (uint8_t p = 0; p < 6; p++) {
+                udp.push(0x0A000001, 0x1936, dmxPacket, sizeof(dmxPacket));
+            }
+        }
+
+        udp.parseCostMicros = (i == 1000) ? 3000 : 0;
+
+        PROFILE_STAGE(&histograms[RECEIVE], receiver.drain());
+        PROFILE_STAGE(&histograms[REPLIES], {
+            artNet.processPendingReplies();
+            artNet.processDiagnostics();
+        });
+    }
+
+    char line[128];
+
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        histograms[i].format(line, sizeof(line), names[i]);
+        printf("[profile] %s", line);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(2000, histograms[RECEIVE].getCount());
+    TEST_ASSERT_GREATER_OR_EQUAL(3000, histograms[RECEIVE].getMax());
+    TEST_ASSERT_LESS_THAN(3000, histograms[RECEIVE].getPercentile(99));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_histogram);
+    RUN_TEST(test_small_values_are_exact);
+    RUN_TEST(test_percentiles_match_reference_within_bucket_error);
+    RUN_TEST(test_huge_values_land_in_last_bucket);
+    RUN_TEST(test_profile_stage_records_statement_time);
+    RUN_TEST(test_host_loop_report);
+    return UNITY_END();
+}